@@ -0,0 +1,219 @@
+#ifndef GATEWAY_LINK_H
+#define GATEWAY_LINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <DutyCycle.h>
+#include <LoRaAirtime.h>
+#include <NodeTable.h>
+#include <RadioDriver.h>
+#include <RadioProfile.h>
+#include <ReliableLink.h>
+#include <SubmersibleFrame.h>
+
+// The gateway's side of the link, shared by the firmware and the host
+// simulator: duplicate filtering per node, adaptive data rate, and the ACK
+// or ADR downlink that answers an uplink.
+//
+// Every uplink's RSSI/SNR feeds its node's controller; the node is told its
+// next profile in a downlink at least every downlinkEvery uplinks so it can
+// tell the link is alive. One radio listens for every node, so they all
+// share the gateway's profile: it only moves off the safe profile while a
+// single node is active, and with no uplink from an active node for lostMs
+// it drops back to the safe profile, which is also where the node ends up
+// after missing its downlinks.
+//
+// Downlinks share the sub-band budget with the node's uplinks. An ACK or
+// ADR command is only useful inside the node's receive window, so one that
+// would exceed the budget is dropped rather than deferred.
+//
+// Nothing here reads a clock or blocks. A downlink goes out downlinkDelayMs
+// after the uplink, from service():
+//
+//   if (!gateway.uplink(slot, header, rssi, snr, waitedMs, now())) duplicate;
+//   while (gateway.service(now())) delay(1);
+
+struct GatewayLinkConfig {
+  uint32_t frequencyHz;
+  const DutyCycleRegion* region;
+  float airtimePolicy;           // see DutyCycle
+  uint8_t downlinkEvery;
+  uint32_t lostMs;
+  uint32_t activeMs;             // a node silent longer is no longer deployed
+  uint32_t downlinkDelayMs;      // time for the node to switch to receive
+  uint32_t maxWaitMs;            // older uplinks get no answer, the window has closed
+};
+
+// Link state the gateway keeps per node. The node table's entry type must
+// have one as its member link.
+struct NodeLink {
+  DuplicateFilter filter;        // duplicate suppression and loss accounting
+  AdrController adr;
+  uint8_t adrUplinks;            // since the last downlink
+  uint16_t lastSeq;
+  float snr;
+};
+
+// Progress reports, for the firmware's log. Every method defaults to
+// doing nothing.
+class GatewayLinkListener {
+public:
+  virtual ~GatewayLinkListener() {}
+
+  virtual void downlinkScheduled(const FrameHeader& uplink, bool ack, int8_t margin,
+                                 uint8_t profile, uint8_t next) {}
+  virtual void downlinkSkipped(const char* reason) {}
+  // fallback is true when an active node went silent
+  virtual void profileChanged(uint8_t profile, bool fallback) {}
+};
+
+template <typename T, uint8_t N>
+class GatewayLink {
+public:
+  GatewayLink(RadioDriver& radio, NodeTable<T, N>& nodes, const GatewayLinkConfig& config,
+              GatewayLinkListener& listener)
+    : _radio(radio), _nodes(nodes), _config(config), _listener(listener),
+      _dutyCycle(*config.region, config.airtimePolicy), _profile(RADIO_PROFILE_SAFE),
+      _downlinkPending(false), _downlinkAt(0), _downlinkLength(0), _downlinkAirtimeUs(0),
+      _nextProfile(RADIO_PROFILE_SAFE) {}
+
+  // Start on the shared safe profile; ADR speeds the link up from there
+  void begin() { _radio.applyProfile(_profile); }
+
+  // A binary uplink from the node in slot, taken off the radio waitedMs
+  // after it arrived. Returns false for a retransmission of a frame
+  // already received: it is ACKed again, but its readings must not be
+  // processed twice.
+  bool uplink(uint8_t slot, const FrameHeader& header, int rssi, float snr,
+              uint32_t waitedMs, uint32_t now) {
+    NodeLink& link = _nodes.at(slot).link;
+    link.snr = snr;
+    link.lastSeq = header.seq;
+    answer(link, header, rssi, snr, waitedMs, now);
+    return link.filter.accept(header.seq, header.epoch);
+  }
+
+  // Sends a scheduled downlink once it is due, and falls back to the safe
+  // profile when an active node has gone quiet. Returns true while a
+  // downlink is waiting.
+  bool service(uint32_t now) {
+    // The command goes out on the old profile, then both ends switch
+    if (_downlinkPending && (int32_t)(now - _downlinkAt) >= 0) {
+      _downlinkPending = false;
+      _radio.transmit(_downlink, _downlinkLength);
+      _dutyCycle.record(_config.frequencyHz, _downlinkAirtimeUs, now);
+      if (_nextProfile != _profile) setProfile(_nextProfile, false);
+    }
+
+    // Lost contact with a node: meet it again on the safe profile
+    if (_profile != RADIO_PROFILE_SAFE && nodeLost(now)) setProfile(RADIO_PROFILE_SAFE, true);
+    return _downlinkPending;
+  }
+
+  uint8_t activeNodes(uint32_t now) const {
+    uint8_t active = 0;
+    for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+      if (_nodes.used(slot) && now - _nodes.lastSeen(slot) < _config.activeMs) active++;
+    }
+    return active;
+  }
+
+  // Link statistics summed over every node in the table
+  DuplicateFilterStats totals() const {
+    DuplicateFilterStats total = {};
+    for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+      if (!_nodes.used(slot)) continue;
+      const DuplicateFilterStats& link = _nodes.at(slot).link.filter.stats();
+      total.received += link.received;
+      total.duplicates += link.duplicates;
+      total.missing += link.missing;
+      total.late += link.late;
+      total.resets += link.resets;
+    }
+    return total;
+  }
+
+  uint8_t profile() const { return _profile; }
+  DutyCycle& dutyCycle() { return _dutyCycle; }
+
+private:
+  // Frames asking for an ACK always get one, carrying the ADR decision;
+  // otherwise a downlink only goes out when ADR wants a change or a link
+  // check is due.
+  void answer(NodeLink& link, const FrameHeader& uplink, int rssi, float snr,
+              uint32_t waitedMs, uint32_t now) {
+    // The frame arrived on the gateway's profile, so that is the node's too
+    if (link.adr.profile() != _profile) link.adr.setProfile(_profile);
+    link.adr.addMeasurement(rssi, snr);
+    link.adrUplinks++;
+
+    bool ack = uplink.flags & FRAME_FLAG_ACK_REQUEST;
+    uint8_t next = activeNodes(now) > 1 ? RADIO_PROFILE_SAFE : link.adr.recommend();
+    if (!ack && next == _profile && link.adrUplinks < _config.downlinkEvery) return;
+    if (waitedMs > _config.maxWaitMs) {
+      _listener.downlinkSkipped("node's receive window has closed");
+      return;
+    }
+    _listener.downlinkScheduled(uplink, ack, link.adr.margin(), _profile, next);
+
+    FrameHeader header;
+    header.type = ack ? FRAME_ACK : FRAME_ADR;
+    header.flags = 0;
+    header.nodeId = uplink.nodeId;
+    header.seq = uplink.seq;
+    header.epoch = uplink.epoch;
+    size_t length = frameEncodeDownlink(header, next, _downlink, sizeof(_downlink));
+
+    const RadioProfile& p = radioProfile(_profile);
+    uint32_t airtimeUs = loraTimeOnAirUs(length, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+    if (_dutyCycle.waitMs(_config.frequencyHz, airtimeUs, now) > 0) {
+      _dutyCycle.deferred();
+      _listener.downlinkSkipped("airtime budget used up");
+      return;
+    }
+
+    // Without a downlink the node stays put, so the gateway must too
+    _downlinkPending = true;
+    _downlinkAt = now + _config.downlinkDelayMs;
+    _downlinkLength = length;
+    _downlinkAirtimeUs = airtimeUs;
+    _nextProfile = next;
+    link.adrUplinks = 0;
+  }
+
+  // An active node silent for lostMs: it may be back on the safe profile
+  // after missing its downlinks
+  bool nodeLost(uint32_t now) const {
+    for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+      if (!_nodes.used(slot)) continue;
+      uint32_t silent = now - _nodes.lastSeen(slot);
+      if (silent > _config.lostMs && silent < _config.activeMs) return true;
+    }
+    return false;
+  }
+
+  // Every node's controller follows, with its measurement history restarted
+  void setProfile(uint8_t profile, bool fallback) {
+    _profile = profile;
+    _radio.applyProfile(profile);
+    for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+      if (_nodes.used(slot)) _nodes.at(slot).link.adr.setProfile(profile);
+    }
+    _listener.profileChanged(profile, fallback);
+  }
+
+  RadioDriver& _radio;
+  NodeTable<T, N>& _nodes;
+  GatewayLinkConfig _config;
+  GatewayLinkListener& _listener;
+  DutyCycle _dutyCycle;
+  uint8_t _profile;
+  bool _downlinkPending;
+  uint32_t _downlinkAt;
+  uint8_t _downlink[FRAME_DOWNLINK_SIZE];
+  size_t _downlinkLength;
+  uint32_t _downlinkAirtimeUs;
+  uint8_t _nextProfile;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NODE_SLOT_NONE 0xFF
+
+// Fixed-capacity state for every node a gateway serves, found by the
+// frame's 8-bit node id. A 256-byte index maps each id straight to its
+// slot, so a lookup is one load however many nodes there are, and the
+// slots sit in one array that the display and web pages walk in order.
+// When every slot is taken, the node heard from least recently makes
+// room for the new one; onEvict sees its state before the slot is reused.
+template <typename T, uint8_t N>
+class NodeTable {
+  static_assert(N > 0 && N < NODE_SLOT_NONE, "NodeTable holds 1 to 254 nodes");
+
+public:
+  typedef void (*EvictFn)(uint8_t id, T& state);
+
+  explicit NodeTable(EvictFn onEvict = nullptr) : _onEvict(onEvict), _count(0), _evicted(0) {
+    memset(_index, NODE_SLOT_NONE, sizeof(_index));
+    for (uint8_t i = 0; i < N; i++) _slots[i].used = false;
+  }
+
+  // The node's slot, or NODE_SLOT_NONE if it has none
+  uint8_t slotOf(uint8_t id) const { return _index[id]; }
+
+  T* find(uint8_t id) {
+    uint8_t slot = _index[id];
+    return slot == NODE_SLOT_NONE ? nullptr : &_slots[slot].state;
+  }
+
+  // The node's slot, marked as heard from at now. A new node gets a slot
+  // with its state value-initialised.
+  uint8_t touch(uint8_t id, uint32_t now) {
+    uint8_t slot = _index[id];
+    if (slot == NODE_SLOT_NONE) {
+      slot = _count < N ? freeSlot() : leastRecent(now);
+      if (_slots[slot].used) {
+        if (_onEvict) _onEvict(_slots[slot].id, _slots[slot].state);
+        _index[_slots[slot].id] = NODE_SLOT_NONE;
+        _evicted++;
+      } else {
+        _count++;
+      }
+      _slots[slot].state = T();
+      _slots[slot].id = id;
+      _slots[slot].used = true;
+      _index[id] = slot;
+    }
+    _slots[slot].lastSeen = now;
+    return slot;
+  }
+
+  uint8_t count() const { return _count; }
+  uint8_t capacity() const { return N; }
+  uint32_t evicted() const { return _evicted; }
+
+  // Slots 0 to capacity() - 1, in an order that only changes when a node
+  // is added or evicted
+  bool used(uint8_t slot) const { return _slots[slot].used; }
+  uint8_t id(uint8_t slot) const { return _slots[slot].id; }
+  uint32_t lastSeen(uint8_t slot) const { return _slots[slot].lastSeen; }
+  T& at(uint8_t slot) { return _slots[slot].state; }
+  const T& at(uint8_t slot) const { return _slots[slot].state; }
+
+private:
+  struct Slot {
+    T state;
+    uint32_t lastSeen;
+    uint8_t id;
+    bool used;
+  };
+
+  uint8_t freeSlot() const {
+    for (uint8_t i = 0; i < N; i++) {
+      if (!_slots[i].used) return i;
+    }
+    return 0;
+  }
+
+  uint8_t leastRecent(uint32_t now) const {
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < N; i++) {
+      if (now - _slots[i].lastSeen > now - _slots[oldest].lastSeen) oldest = i;
+    }
+    return oldest;
+  }
+
+  EvictFn _onEvict;
+  Slot _slots[N];
+  uint8_t _index[256];
+  uint8_t _count;
+  uint32_t _evicted;
+};
+
+#endif
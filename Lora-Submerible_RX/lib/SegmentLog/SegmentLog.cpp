@@ -0,0 +1,319 @@
+#include "SegmentLog.h"
+#include <ConfigStore.h>
+
+#define CURSOR_MAGIC 0x43555231   // "CUR1"
+
+struct SegmentCursor {
+  uint32_t magic;
+  uint32_t segment;
+  uint32_t offset;
+  uint32_t crc;
+};
+
+SegmentLog::SegmentLog(fs::FS& fs, const char* dir, uint32_t segmentBytes, uint16_t maxSegments)
+  : _fs(fs), _dir(dir), _segmentBytes(segmentBytes), _maxSegments(maxSegments),
+    _readSegment(0), _readOffset(0), _writeSegment(0), _writeSize(0), _peekBytes(0), _peekCount(0) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+bool SegmentLog::begin() {
+  memset(&_stats, 0, sizeof(_stats));
+  _stats.capacityBytes = _segmentBytes * _maxSegments;
+  _peekBytes = 0;
+  _peekCount = 0;
+  if (!_fs.exists(_dir) && !_fs.mkdir(_dir)) return false;
+
+  // Oldest and newest segment on flash
+  File dir = _fs.open(_dir);
+  if (!dir || !dir.isDirectory()) return false;
+  uint32_t first = UINT32_MAX;
+  uint32_t last = 0;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    const char* name = strrchr(f.name(), '/');
+    name = name ? name + 1 : f.name();
+    char* end;
+    unsigned long segment = strtoul(name, &end, 10);
+    if (end != name && strcmp(end, ".seg") == 0) {
+      if (segment < first) first = segment;
+      if (segment > last) last = segment;
+    }
+    f.close();
+  }
+  dir.close();
+  if (first == UINT32_MAX) first = 0;
+
+  _writeSegment = last;
+  _writeSize = segmentSize(last);
+  if (!loadCursor() || _readSegment < first || _readSegment > last) {
+    _readSegment = first;
+    _readOffset = 0;
+  }
+
+  // Segments the cursor had passed when a reset came before their deletion
+  char path[40];
+  for (uint32_t segment = first; segment < _readSegment; segment++) {
+    segmentPath(segment, path, sizeof(path));
+    _fs.remove(path);
+  }
+
+  // Nothing may be appended behind a bad record the reader cannot pass
+  bool intact;
+  countRecords(_writeSegment, _writeSegment == _readSegment ? _readOffset : 0, intact);
+  if (!intact) {
+    _writeSegment++;
+    _writeSize = 0;
+  }
+
+  recount();
+  return true;
+}
+
+bool SegmentLog::append(const void* data, uint8_t length) {
+  if (length == 0 || length > MAX_RECORD) return false;
+  uint32_t recordSize = length + RECORD_OVERHEAD;
+  if (_writeSize > 0 && _writeSize + recordSize > _segmentBytes) {
+    _writeSegment++;
+    _writeSize = 0;
+  }
+
+  // Full: the oldest segment makes room
+  while (_writeSegment - _readSegment >= _maxSegments) {
+    bool intact;
+    uint32_t lost = countRecords(_readSegment, _readOffset, intact);
+    uint32_t size = segmentSize(_readSegment);
+    _stats.overwritten += lost;
+    _stats.records -= lost < _stats.records ? lost : _stats.records;
+    releaseBytes(size > _readOffset ? size - _readOffset : 0);
+    nextReadSegment();
+  }
+
+  uint8_t record[1 + MAX_RECORD + 4];
+  record[0] = length;
+  memcpy(record + 1, data, length);
+  uint32_t crc = configCrc32(record, length + 1);
+  memcpy(record + 1 + length, &crc, sizeof(crc));
+
+  char path[40];
+  segmentPath(_writeSegment, path, sizeof(path));
+  File f = _fs.open(path, FILE_APPEND);
+  if (!f) return false;
+  size_t written = f.write(record, recordSize);
+  f.close();
+  if (written != recordSize) {
+    // Whatever part landed ends this segment for the reader
+    _writeSegment++;
+    _writeSize = 0;
+    return false;
+  }
+
+  _writeSize += recordSize;
+  _stats.records++;
+  _stats.usedBytes += recordSize;
+  _stats.appended++;
+  return true;
+}
+
+size_t SegmentLog::peek(void* data, size_t cap) {
+  _peekBytes = 0;
+  _peekCount = 0;
+  char path[40];
+  uint8_t record[1 + MAX_RECORD + 4];
+  while (_stats.records > 0) {
+    segmentPath(_readSegment, path, sizeof(path));
+    File f = _fs.open(path, FILE_READ);
+    uint32_t size = f ? f.size() : 0;
+    if (_readOffset >= size) {
+      if (f) f.close();
+      if (_readSegment >= _writeSegment) break;
+      nextReadSegment();
+      continue;
+    }
+
+    uint8_t length;
+    f.seek(_readOffset);
+    bool valid = readRecord(f, record, length);
+    f.close();
+    if (!valid) {
+      // The rest of the segment cannot be framed: skip to the next one
+      _stats.corrupt++;
+      if (_readSegment >= _writeSegment) {
+        _writeSegment++;
+        _writeSize = 0;
+      }
+      nextReadSegment();
+      recount();
+      continue;
+    }
+
+    memcpy(data, record + 1, length < cap ? length : cap);
+    _peekBytes = length + RECORD_OVERHEAD;
+    _peekCount = 1;
+    return length;
+  }
+
+  // Counted records that are not there after all
+  _stats.records = 0;
+  _stats.usedBytes = 0;
+  return 0;
+}
+
+// A damaged record here is left for peek() to find once the batch
+// before it is popped
+size_t SegmentLog::peekNext(void* data, size_t cap) {
+  if (_peekBytes == 0 || _peekCount >= _stats.records) return 0;
+  char path[40];
+  segmentPath(_readSegment, path, sizeof(path));
+  File f = _fs.open(path, FILE_READ);
+  if (!f) return 0;
+  uint32_t offset = _readOffset + _peekBytes;
+  if (offset >= f.size()) {
+    f.close();
+    return 0;
+  }
+
+  uint8_t record[1 + MAX_RECORD + 4];
+  uint8_t length;
+  f.seek(offset);
+  bool valid = readRecord(f, record, length);
+  f.close();
+  if (!valid) return 0;
+
+  memcpy(data, record + 1, length < cap ? length : cap);
+  _peekBytes += length + RECORD_OVERHEAD;
+  _peekCount++;
+  return length;
+}
+
+bool SegmentLog::pop() {
+  if (_peekBytes == 0) return false;
+  _readOffset += _peekBytes;
+  _stats.records -= _peekCount < _stats.records ? _peekCount : _stats.records;
+  releaseBytes(_peekBytes);
+  _stats.replayed += _peekCount;
+  _peekBytes = 0;
+  _peekCount = 0;
+
+  // A finished segment is deleted straight away
+  if (_readSegment < _writeSegment && _readOffset >= segmentSize(_readSegment)) {
+    return nextReadSegment();
+  }
+  return saveCursor();
+}
+
+void SegmentLog::segmentPath(uint32_t segment, char* path, size_t size) const {
+  snprintf(path, size, "%s/%08lu.seg", _dir, (unsigned long)segment);
+}
+
+uint32_t SegmentLog::segmentSize(uint32_t segment) const {
+  char path[40];
+  segmentPath(segment, path, sizeof(path));
+  File f = _fs.open(path, FILE_READ);
+  if (!f) return 0;
+  uint32_t size = f.size();
+  f.close();
+  return size;
+}
+
+// One record at the file's position into record (length byte, payload,
+// CRC). False at the end of the file or on a damaged record.
+bool SegmentLog::readRecord(File& file, uint8_t* record, uint8_t& length) const {
+  int first = file.read();
+  if (first <= 0 || first > MAX_RECORD) return false;
+  length = first;
+  record[0] = length;
+  if (file.read(record + 1, length + 4) != (size_t)(length + 4)) return false;
+  uint32_t crc;
+  memcpy(&crc, record + 1 + length, sizeof(crc));
+  return crc == configCrc32(record, length + 1);
+}
+
+// Valid records from offset to the end of the segment or the first bad
+// one; intact is false when a bad record stopped the count.
+uint32_t SegmentLog::countRecords(uint32_t segment, uint32_t offset, bool& intact) const {
+  intact = true;
+  char path[40];
+  segmentPath(segment, path, sizeof(path));
+  File f = _fs.open(path, FILE_READ);
+  if (!f) return 0;
+
+  uint32_t size = f.size();
+  uint32_t position = offset;
+  uint32_t count = 0;
+  uint8_t record[1 + MAX_RECORD + 4];
+  uint8_t length;
+  f.seek(offset);
+  while (position < size && readRecord(f, record, length)) {
+    position += length + RECORD_OVERHEAD;
+    count++;
+  }
+  f.close();
+  intact = position >= size;
+  return count;
+}
+
+// Records and bytes waiting, from the files themselves
+void SegmentLog::recount() {
+  _stats.records = 0;
+  _stats.usedBytes = 0;
+  for (uint32_t segment = _readSegment; segment <= _writeSegment; segment++) {
+    uint32_t offset = segment == _readSegment ? _readOffset : 0;
+    bool intact;
+    _stats.records += countRecords(segment, offset, intact);
+    uint32_t size = segmentSize(segment);
+    if (size > offset) _stats.usedBytes += size - offset;
+  }
+}
+
+void SegmentLog::releaseBytes(uint32_t bytes) {
+  _stats.usedBytes = bytes < _stats.usedBytes ? _stats.usedBytes - bytes : 0;
+}
+
+// Delete the read segment and move the cursor to the start of the next.
+// A reset in between leaves the cursor on a missing segment, which
+// begin() treats as the start of the oldest one left.
+bool SegmentLog::nextReadSegment() {
+  char path[40];
+  segmentPath(_readSegment, path, sizeof(path));
+  _fs.remove(path);
+  _readSegment++;
+  _readOffset = 0;
+  return saveCursor();
+}
+
+bool SegmentLog::loadCursor() {
+  char path[40];
+  snprintf(path, sizeof(path), "%s/cursor", _dir);
+  File f = _fs.open(path, FILE_READ);
+  if (!f) return false;
+
+  SegmentCursor cursor;
+  bool complete = f.read((uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor);
+  f.close();
+  if (!complete || cursor.magic != CURSOR_MAGIC ||
+      cursor.crc != configCrc32(&cursor, offsetof(SegmentCursor, crc))) {
+    return false;
+  }
+  _readSegment = cursor.segment;
+  _readOffset = cursor.offset;
+  return true;
+}
+
+// Written beside the old cursor and renamed over it, so a reset leaves
+// either the old or the new position
+bool SegmentLog::saveCursor() {
+  SegmentCursor cursor;
+  cursor.magic = CURSOR_MAGIC;
+  cursor.segment = _readSegment;
+  cursor.offset = _readOffset;
+  cursor.crc = configCrc32(&cursor, offsetof(SegmentCursor, crc));
+
+  char path[40];
+  char temp[40];
+  snprintf(path, sizeof(path), "%s/cursor", _dir);
+  snprintf(temp, sizeof(temp), "%s/cursor.tmp", _dir);
+  File f = _fs.open(temp, FILE_WRITE);
+  if (!f) return false;
+  bool complete = f.write((const uint8_t*)&cursor, sizeof(cursor)) == sizeof(cursor);
+  f.close();
+  return complete && _fs.rename(temp, path);
+}
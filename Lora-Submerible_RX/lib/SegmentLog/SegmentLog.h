@@ -0,0 +1,86 @@
+#ifndef SEGMENT_LOG_H
+#define SEGMENT_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Append-only queue of small records on flash, read back oldest first.
+// Records go into numbered segment files in one directory:
+//
+//   <dir>/00000007.seg   length (1) | payload | CRC-32 of length and payload (4)
+//   <dir>/cursor         read position: segment and offset, with a CRC
+//
+// A segment is closed once the next record would not fit in segmentBytes,
+// and deleted once the cursor has passed it. When maxSegments are in use
+// the oldest segment is dropped to make room, so the log never grows past
+// its capacity and the newest data survives a long outage.
+//
+// Power loss: LittleFS commits a file only on close, so an interrupted
+// append leaves the segment at its last complete record, and the cursor
+// is replaced by writing a temporary file and renaming it over the old
+// one. A record with a bad CRC ends its segment. After a reset the last
+// record before the cursor may be delivered again, so consumers must be
+// idempotent.
+struct SegmentLogStats {
+  uint32_t capacityBytes;
+  uint32_t usedBytes;      // bytes of records waiting
+  uint32_t records;        // records waiting
+  uint32_t appended;
+  uint32_t replayed;       // records popped
+  uint32_t overwritten;    // records dropped to make room
+  uint32_t corrupt;        // segments cut short by a bad record
+};
+
+class SegmentLog {
+public:
+  static const uint8_t MAX_RECORD = 250;
+  static const uint8_t RECORD_OVERHEAD = 5;
+
+  SegmentLog(fs::FS& fs, const char* dir, uint32_t segmentBytes, uint16_t maxSegments);
+
+  // The file system must be mounted. Finds the segments, restores the
+  // cursor and counts the records waiting.
+  bool begin();
+
+  bool append(const void* data, uint8_t length);
+
+  // Copies up to cap bytes of the oldest record into data and returns the
+  // record's full length, or 0 when the log is empty. The record stays
+  // queued until pop().
+  size_t peek(void* data, size_t cap);
+
+  // The record after the last one peeked, for reading a batch. Stops (0)
+  // at the end of the segment, so a batch never spans two segments.
+  size_t peekNext(void* data, size_t cap);
+
+  // Drops every record peeked since peek() and saves the cursor.
+  bool pop();
+
+  bool empty() const { return _stats.records == 0; }
+  const SegmentLogStats& stats() const { return _stats; }
+
+private:
+  void segmentPath(uint32_t segment, char* path, size_t size) const;
+  uint32_t segmentSize(uint32_t segment) const;
+  bool readRecord(File& file, uint8_t* record, uint8_t& length) const;
+  uint32_t countRecords(uint32_t segment, uint32_t offset, bool& intact) const;
+  void recount();
+  void releaseBytes(uint32_t bytes);
+  bool nextReadSegment();
+  bool loadCursor();
+  bool saveCursor();
+
+  fs::FS& _fs;
+  const char* _dir;
+  uint32_t _segmentBytes;
+  uint16_t _maxSegments;
+  uint32_t _readSegment;
+  uint32_t _readOffset;
+  uint32_t _writeSegment;
+  uint32_t _writeSize;
+  uint32_t _peekBytes;     // record bytes peeked since peek(), 0 if none
+  uint32_t _peekCount;
+  SegmentLogStats _stats;
+};
+
+#endif
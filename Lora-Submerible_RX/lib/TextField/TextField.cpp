@@ -0,0 +1,52 @@
+#include "TextField.h"
+
+// Shared by every field; only one is drawn at a time
+static GFXcanvas16 canvas(TextField::MAX_CHARS * TextField::CHAR_WIDTH, TextField::CHAR_HEIGHT);
+
+uint32_t TextField::_pixelsSent = 0;
+
+TextField::TextField(int16_t x, int16_t y, uint8_t chars, uint16_t background)
+  : _x(x), _y(y), _chars(chars < MAX_CHARS ? chars : MAX_CHARS), _background(background),
+    _color(background), _valid(false) {
+  memset(_text, ' ', _chars);
+  _text[_chars] = '\0';
+}
+
+void TextField::show(Adafruit_SPITFT& tft, const char* text, uint16_t color) {
+  char padded[MAX_CHARS + 1];
+  size_t length = strnlen(text, _chars);
+  memcpy(padded, text, length);
+  memset(padded + length, ' ', _chars - length);
+  padded[_chars] = '\0';
+
+  // Changed cells; a new colour changes all of them
+  uint8_t first = 0;
+  uint8_t last = _chars;
+  if (_valid && color == _color) {
+    while (first < _chars && padded[first] == _text[first]) first++;
+    if (first == _chars) return;
+    while (last > first && padded[last - 1] == _text[last - 1]) last--;
+  }
+
+  canvas.fillScreen(_background);
+  canvas.setTextWrap(false);
+  canvas.setTextSize(1);
+  canvas.setTextColor(color);
+  canvas.setCursor(0, 0);
+  canvas.print(padded);
+
+  int16_t left = first * CHAR_WIDTH;
+  int16_t width = (last - first) * CHAR_WIDTH;
+  uint16_t* pixels = canvas.getBuffer();
+  tft.startWrite();
+  tft.setAddrWindow(_x + left, _y, width, CHAR_HEIGHT);
+  for (int16_t row = 0; row < CHAR_HEIGHT; row++) {
+    tft.writePixels(pixels + row * canvas.width() + left, width);
+  }
+  tft.endWrite();
+  _pixelsSent += (uint32_t)width * CHAR_HEIGHT;
+
+  memcpy(_text, padded, _chars + 1);
+  _color = color;
+  _valid = true;
+}
@@ -0,0 +1,47 @@
+#ifndef TEXT_FIELD_H
+#define TEXT_FIELD_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SPITFT.h>
+
+// One line of text at a fixed place on the TFT that only repaints the
+// character cells that changed. The line is drawn off screen into a
+// one-row canvas shared by every field, then the changed columns go out
+// in a single SPI transaction: one address window and a burst of
+// writePixels() per pixel row. There is no clear-then-draw step, so the
+// text never flickers, and a clock ticking from 12:00:09 to 12:00:10
+// sends two cells (192 bytes) instead of the whole line.
+//
+// Built-in 6x8 font at text size 1. The Adafruit driver has no DMA path
+// on the ESP32, so the pixels go out with blocking SPI writes on the bus
+// the LoRa radio shares, which is why fewer of them matters.
+class TextField {
+public:
+  static const uint8_t CHAR_WIDTH = 6;
+  static const uint8_t CHAR_HEIGHT = 8;
+  static const uint8_t MAX_CHARS = 26;     // 156 pixels, a full line in landscape
+
+  TextField(int16_t x, int16_t y, uint8_t chars, uint16_t background);
+
+  // Shows text, left aligned and padded or cut to the field's width
+  void show(Adafruit_SPITFT& tft, const char* text, uint16_t color);
+
+  // The next show() repaints every cell, e.g. after the screen was cleared
+  void invalidate() { _valid = false; }
+
+  // Pixels sent since boot, over every field
+  static uint32_t pixelsSent() { return _pixelsSent; }
+
+private:
+  int16_t _x;
+  int16_t _y;
+  uint8_t _chars;
+  uint16_t _background;
+  uint16_t _color;
+  char _text[MAX_CHARS + 1];   // as shown, padded with spaces
+  bool _valid;
+
+  static uint32_t _pixelsSent;
+};
+
+#endif
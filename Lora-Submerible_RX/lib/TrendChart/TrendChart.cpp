@@ -0,0 +1,136 @@
+#include "TrendChart.h"
+
+uint32_t TrendChart::_pixelsSent = 0;
+
+void TrendHistory::add(uint32_t column, uint16_t depthMm, uint16_t turbidityDeciNtu) {
+  advance(column);
+  TrendColumn& c = _columns[column % TREND_COLUMNS];
+  if (c.empty()) {
+    c.depthMinMm = depthMm;
+    c.depthMaxMm = depthMm;
+    c.turbidityMaxDeciNtu = turbidityDeciNtu;
+    return;
+  }
+  if (depthMm < c.depthMinMm) c.depthMinMm = depthMm;
+  if (depthMm > c.depthMaxMm) c.depthMaxMm = depthMm;
+  if (turbidityDeciNtu > c.turbidityMaxDeciNtu) c.turbidityMaxDeciNtu = turbidityDeciNtu;
+}
+
+void TrendHistory::advance(uint32_t column) {
+  if (_started && column == _newest) return;
+
+  // Only the columns being reused are cleared
+  uint32_t first = column - (TREND_COLUMNS - 1);
+  if (_started && column > _newest && column - _newest < TREND_COLUMNS) first = _newest + 1;
+  for (uint32_t c = first;; c++) {
+    TrendColumn& cleared = _columns[c % TREND_COLUMNS];
+    cleared.depthMinMm = UINT16_MAX;
+    cleared.depthMaxMm = 0;
+    cleared.turbidityMaxDeciNtu = 0;
+    if (c == column) break;
+  }
+  _newest = column;
+  _started = true;
+}
+
+TrendChart::TrendChart(int16_t x, int16_t y, int16_t height, uint16_t background,
+                       uint16_t depthColor, uint16_t turbidityColor)
+  : _x(x), _y(y), _height(height < TREND_MAX_HEIGHT ? height : TREND_MAX_HEIGHT),
+    _background(background), _depthColor(depthColor), _turbidityColor(turbidityColor),
+    _depthScale(0), _turbidityScale(0), _drawn(false) {}
+
+// Smallest of 10, 20, 50, 100, ... that is at least value
+uint16_t TrendChart::niceScale(uint16_t value) {
+  uint32_t decade = 10;
+  for (;;) {
+    if (value <= decade) return decade;
+    if (value <= 2 * decade) return 2 * decade;
+    if (value <= 5 * decade) return 5 * decade;
+    if (decade * 10 > UINT16_MAX) return UINT16_MAX;
+    decade *= 10;
+  }
+}
+
+int16_t TrendChart::rowOf(uint16_t value, uint16_t scale) const {
+  if (value > scale) value = scale;
+  return (_height - 1) - (int32_t)value * (_height - 1) / scale;
+}
+
+void TrendChart::drawAll(Adafruit_SPITFT& tft, const TrendHistory& history, uint32_t now) {
+  uint16_t depthMax = 0;
+  uint16_t turbidityMax = 0;
+  for (uint32_t i = 0; i < TREND_COLUMNS; i++) {
+    uint32_t column = now - i;
+    if (!history.holds(column) || history.at(column).empty()) continue;
+    const TrendColumn& c = history.at(column);
+    if (c.depthMaxMm > depthMax) depthMax = c.depthMaxMm;
+    if (c.turbidityMaxDeciNtu > turbidityMax) turbidityMax = c.turbidityMaxDeciNtu;
+  }
+  _depthScale = niceScale(depthMax);
+  _turbidityScale = niceScale(turbidityMax);
+
+  // Oldest first, ending with the gap after now
+  uint16_t pixels[TREND_MAX_HEIGHT];
+  for (uint32_t i = TREND_COLUMNS - 1; i > 0; i--) {
+    renderColumn(history, now - i + 1, pixels);
+    pushColumn(tft, now - i + 1, pixels);
+  }
+  _drawn = true;
+}
+
+void TrendChart::drawColumn(Adafruit_SPITFT& tft, const TrendHistory& history, uint32_t now) {
+  if (history.holds(now) && !history.at(now).empty()) {
+    const TrendColumn& c = history.at(now);
+    if (c.depthMaxMm > _depthScale || c.turbidityMaxDeciNtu > _turbidityScale) _drawn = false;
+  }
+  if (!_drawn) {
+    drawAll(tft, history, now);
+    return;
+  }
+
+  uint16_t pixels[TREND_MAX_HEIGHT];
+  renderColumn(history, now, pixels);
+  pushColumn(tft, now, pixels);
+}
+
+void TrendChart::renderColumn(const TrendHistory& history, uint32_t column, uint16_t* pixels) const {
+  for (int16_t row = 0; row < _height; row++) pixels[row] = _background;
+  if (!history.holds(column) || history.at(column).empty()) return;
+  const TrendColumn& c = history.at(column);
+  bool joined = history.holds(column - 1) && !history.at(column - 1).empty();
+  const TrendColumn& previous = history.at(column - 1);
+
+  // Depth: the interval's range, stretched to meet the previous column
+  int16_t top = rowOf(c.depthMaxMm, _depthScale);
+  int16_t bottom = rowOf(c.depthMinMm, _depthScale);
+  if (joined) {
+    int16_t before = rowOf(previous.depthMaxMm, _depthScale);
+    if (before > bottom) bottom = before - 1;
+    before = rowOf(previous.depthMinMm, _depthScale);
+    if (before < top) top = before + 1;
+  }
+  for (int16_t row = top; row <= bottom; row++) pixels[row] = _depthColor;
+
+  // Turbidity: a line from the previous column, drawn over depth
+  int16_t to = rowOf(c.turbidityMaxDeciNtu, _turbidityScale);
+  int16_t from = joined ? rowOf(previous.turbidityMaxDeciNtu, _turbidityScale) : to;
+  if (from < to) from++;
+  if (from > to) from--;
+  int16_t low = from < to ? from : to;
+  int16_t high = from < to ? to : from;
+  for (int16_t row = low; row <= high; row++) pixels[row] = _turbidityColor;
+}
+
+// The column, then the gap ahead of it, in one transaction
+void TrendChart::pushColumn(Adafruit_SPITFT& tft, uint32_t column, const uint16_t* pixels) {
+  uint16_t gap[TREND_MAX_HEIGHT];
+  for (int16_t row = 0; row < _height; row++) gap[row] = _background;
+
+  tft.startWrite();
+  tft.setAddrWindow(_x + column % TREND_COLUMNS, _y, 1, _height);
+  tft.writePixels((uint16_t*)pixels, _height);
+  tft.setAddrWindow(_x + (column + 1) % TREND_COLUMNS, _y, 1, _height);
+  tft.writePixels(gap, _height);
+  tft.endWrite();
+  _pixelsSent += 2 * _height;
+}
@@ -0,0 +1,85 @@
+#ifndef TREND_CHART_H
+#define TREND_CHART_H
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_SPITFT.h>
+
+#define TREND_COLUMNS 150
+#define TREND_MAX_HEIGHT 64
+
+// One interval of a node's history: the depth range and the highest
+// turbidity, in the frame's units (mm, 0.1 NTU). Empty when min > max.
+struct TrendColumn {
+  uint16_t depthMinMm;
+  uint16_t depthMaxMm;
+  uint16_t turbidityMaxDeciNtu;
+
+  bool empty() const { return depthMinMm > depthMaxMm; }
+};
+
+// The last TREND_COLUMNS intervals of depth and turbidity, downsampled to
+// one column per interval in a ring. Columns are numbered by the caller
+// (time / interval); 6 bytes each, so a node's full history is 900 bytes.
+class TrendHistory {
+public:
+  void add(uint32_t column, uint16_t depthMm, uint16_t turbidityDeciNtu);
+
+  // Makes column the newest, leaving the intervals in between empty.
+  // A column number lower than the newest (millis() wrapped) starts over.
+  void advance(uint32_t column);
+
+  // True while column is within the ring and was reached by advance()
+  bool holds(uint32_t column) const {
+    return _started && column <= _newest && _newest - column < TREND_COLUMNS;
+  }
+  const TrendColumn& at(uint32_t column) const { return _columns[column % TREND_COLUMNS]; }
+
+private:
+  TrendColumn _columns[TREND_COLUMNS];
+  uint32_t _newest;
+  bool _started;
+};
+
+// Sweep-style strip chart of a TrendHistory, one pixel column per
+// interval. Column n is always drawn at x + n % TREND_COLUMNS and the
+// column after it is blanked, so the chart is never scrolled or
+// repainted: each interval costs one column and the gap ahead of it
+// (2 x height pixels in one SPI transaction), however long the history.
+// Depth is drawn as its range in each interval and turbidity as a line,
+// each against its own scale on a 1-2-5 series from zero. A value above
+// the scale, or a different history, repaints the whole chart once.
+class TrendChart {
+public:
+  TrendChart(int16_t x, int16_t y, int16_t height, uint16_t background,
+             uint16_t depthColor, uint16_t turbidityColor);
+
+  // Every column up to now, with the scales fitted to the history
+  void drawAll(Adafruit_SPITFT& tft, const TrendHistory& history, uint32_t now);
+
+  // Column now, after a reading or when a new interval starts
+  void drawColumn(Adafruit_SPITFT& tft, const TrendHistory& history, uint32_t now);
+
+  uint16_t depthScaleMm() const { return _depthScale; }
+  uint16_t turbidityScaleDeciNtu() const { return _turbidityScale; }
+  static uint32_t pixelsSent() { return _pixelsSent; }
+
+private:
+  static uint16_t niceScale(uint16_t value);
+  int16_t rowOf(uint16_t value, uint16_t scale) const;
+  void renderColumn(const TrendHistory& history, uint32_t column, uint16_t* pixels) const;
+  void pushColumn(Adafruit_SPITFT& tft, uint32_t column, const uint16_t* pixels);
+
+  int16_t _x;
+  int16_t _y;
+  int16_t _height;
+  uint16_t _background;
+  uint16_t _depthColor;
+  uint16_t _turbidityColor;
+  uint16_t _depthScale;
+  uint16_t _turbidityScale;
+  bool _drawn;
+
+  static uint32_t _pixelsSent;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "WindowStats.h"
+
+void FieldStats::reset() {
+  min = 0;
+  max = 0;
+  sum = 0;
+  last = 0;
+  count = 0;
+}
+
+void FieldStats::add(float value) {
+  if (count == 0 || value < min) min = value;
+  if (count == 0 || value > max) max = value;
+  sum += value;
+  last = value;
+  count++;
+}
+
+void readingFromFrame(const FrameReading& reading, SensorData& data) {
+  data.current = frameCurrentMa(reading);
+  data.waterDepth = frameDepthCm(reading);
+  data.temperature = frameTempValid(reading) ? frameTempC(reading) : -127;
+  data.turbVoltage = frameTurbVolts(reading);
+  data.turbidity = frameTurbNtu(reading);
+  data.flags = reading.flags;
+}
+
+void ReadingWindow::reset() {
+  start = 0;
+  end = 0;
+  nodeId = 0;
+  flags = 0;
+  samples = 0;
+  waterDepth.reset();
+  temperature.reset();
+  turbidity.reset();
+  current.reset();
+  turbVoltage.reset();
+  rssi.reset();
+}
+
+void ReadingWindow::add(const SensorData& data) {
+  if (samples == 0) start = data.timestamp;
+  if (data.timestamp != 0) end = data.timestamp;
+  nodeId = data.nodeId;
+  flags |= data.flags;
+  if (samples < UINT16_MAX) samples++;
+  waterDepth.add(data.waterDepth);
+  if (data.temperature != -127) temperature.add(data.temperature);
+  turbidity.add(data.turbidity);
+  current.add(data.current);
+  turbVoltage.add(data.turbVoltage);
+  rssi.add(data.rssi);
+}
+
+bool NodeWindow::close(uint32_t now, uint32_t intervalMs, ReadingWindow& finished) {
+  if (closedOnce && now - openedMs < intervalMs) return false;
+  finished = current;
+  current.reset();
+  openedMs = now;
+  closedOnce = true;
+  return true;
+}
@@ -0,0 +1,71 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+#include <SubmersibleFrame.h>
+
+// Running minimum, maximum, mean and last value of one field over an
+// aggregation window. Plain data, so a finished window can be copied
+// through a FreeRTOS queue or written to flash as it is.
+struct FieldStats {
+  float min;
+  float max;
+  float sum;
+  float last;
+  uint32_t count;
+
+  void reset();
+  void add(float value);
+  float mean() const { return count > 0 ? sum / count : 0; }
+};
+
+// One reading as the gateway keeps it
+struct SensorData {
+  float waterDepth;     // Water depth in cm
+  float temperature;    // Temperature in °C, -127 without a probe
+  float turbidity;      // Turbidity in NTU
+  float current;        // Submersible sensor current in mA
+  float turbVoltage;    // Turbidity sensor voltage
+  int rssi;             // Signal strength
+  uint8_t nodeId;       // Sending node
+  uint8_t flags;        // FrameReadingFlags from the node
+  time_t timestamp;     // When the node took the reading (0 if clock not set)
+  bool isValid;         // Data validity flag
+};
+
+// The measured fields of a frame reading; the caller fills in the rest.
+void readingFromFrame(const FrameReading& reading, SensorData& data);
+
+// Every reading of one node received in one upload interval, uploaded as
+// one record instead of only the reading that happened to be latest
+struct ReadingWindow {
+  time_t start;             // first reading (0 if clock not set)
+  time_t end;               // last reading, also the record's key
+  uint8_t nodeId;
+  uint8_t flags;            // FrameReadingFlags seen in the window, ORed
+  uint16_t samples;
+  FieldStats waterDepth;
+  FieldStats temperature;   // readings with a valid probe only
+  FieldStats turbidity;
+  FieldStats current;
+  FieldStats turbVoltage;
+  FieldStats rssi;
+
+  void reset();
+  void add(const SensorData& data);
+};
+
+// The window a node's readings are collecting in. It is closed on the
+// node's first data, so a new node reaches the database at once, and then
+// every interval.
+struct NodeWindow {
+  ReadingWindow current;
+  uint32_t openedMs;
+  bool closedOnce;
+
+  // When due, moves the window into finished and opens the next at now.
+  bool close(uint32_t now, uint32_t intervalMs, ReadingWindow& finished);
+};
+
+#endif
@@ -7,18 +7,36 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <EEPROM.h>
+#include <LittleFS.h>
 #include "time.h"
 #include "sys/time.h"
 #include "esp_sntp.h"
 #include <Firebase_ESP_Client.h>
+#include <SubmersibleFrame.h>
+#include <RadioProfile.h>
+#include <RadioDriver.h>
+#include <InterruptRadioDriver.h>
+#include <LoRaAirtime.h>
+#include <DutyCycle.h>
+#include <ReliableLink.h>
+#include <ConfigStore.h>
+#include <Metrics.h>
+#include <SegmentLog.h>
+#include <WindowStats.h>
+#include <NodeTable.h>
+#include <GatewayLink.h>
+#include <TextField.h>
+#include <TrendChart.h>
 
 // Add Firebase token helper
 #include "addons/TokenHelper.h"
 #include "addons/RTDBHelper.h"
 
-// WiFi and AP Configuration
+// WiFi and AP Configuration. Credentials live in a CRC-checked config
+// record; the legacy EEPROM strings are only read once to migrate.
 #define WIFI_SSID_ADDR 0
 #define WIFI_PASS_ADDR 50
+#define RX_CONFIG_SCHEMA 1
 const char* ap_ssid = "Wifi Login_SB";
 const char* ap_password = "12345678";
 
@@ -34,8 +52,60 @@ FirebaseAuth auth;
 FirebaseConfig config;
 String uid;
 String databasePath;
-unsigned long lastFirebaseUpdate = 0;
 const unsigned long FIREBASE_UPDATE_INTERVAL = 600000; // 10 minutes
+// Windows are also checked on this timer, so a node that falls silent
+// still has its last readings uploaded within one interval
+#define WINDOW_SWEEP_MS 10000
+
+// Uploads run in their own task, which owns every Firebase call, so a
+// slow or dead WAN never stalls reception, the clock or the status LED.
+// loop() aggregates every reading into its node's window and hands each
+// finished window over through a bounded queue without waiting; a window
+// that finds the queue full is dropped and counted. Up to UPLOAD_BATCH_MAX
+// windows go to Firebase with one multi-path update per node. A failed
+// upload is retried with exponential backoff, and moved to the backlog
+// after UPLOAD_MAX_ATTEMPTS.
+#define UPLOAD_QUEUE_LENGTH 32      // one window from every node in the table
+#define UPLOAD_BATCH_MAX 8
+#define UPLOAD_TASK_PRIORITY 1
+#define UPLOAD_TASK_CORE 0
+#define UPLOAD_TASK_STACK 8192
+#define UPLOAD_TIMEOUT_MS 10000
+#define UPLOAD_MAX_ATTEMPTS 5
+#define UPLOAD_BACKOFF_MIN_MS 1000
+#define UPLOAD_BACKOFF_MAX_MS 60000
+
+// queued and dropped are written by loop(), the rest by the worker
+struct UploadStats {
+    uint32_t queued;         // windows
+    uint32_t dropped;        // queue full
+    uint32_t uploaded;
+    uint32_t batches;        // batches that succeeded
+    uint32_t retries;
+    uint32_t stored;         // put in the backlog during an outage
+    uint32_t failed;         // lost: the backlog could not take them
+    uint32_t lastLatencyMs;
+    uint32_t backoffMs;      // wait before the next attempt, 0 when idle
+};
+UploadStats uploadStats = {};
+QueueHandle_t uploadQueue = NULL;
+volatile bool firebaseReady = false;
+volatile unsigned long lastUploadAt = 0;
+
+// Windows that could not be uploaded wait on flash (LittleFS, the
+// "spiffs" partition) and are replayed oldest first once Firebase is back,
+// one batch every BACKLOG_REPLAY_INTERVAL_MS while no live window is
+// waiting. 32 segments of 16 KB hold about 3,500 windows, over three weeks
+// at one window per 10 minutes; past that the oldest are dropped. Only the
+// upload worker touches the backlog. A replay writes to the window's own
+// timestamp path, so a record delivered twice after a reset overwrites
+// itself.
+#define BACKLOG_DIR "/backlog"
+#define BACKLOG_SEGMENT_BYTES 16384
+#define BACKLOG_SEGMENTS 32
+#define BACKLOG_REPLAY_INTERVAL_MS 500
+SegmentLog backlog(LittleFS, BACKLOG_DIR, BACKLOG_SEGMENT_BYTES, BACKLOG_SEGMENTS);
+bool backlogReady = false;
 
 // NTP Server settings
 const char* ntpServer1 = "pool.ntp.org";
@@ -56,8 +126,13 @@ const int daylightOffset_sec = 0;
 // Initialize objects
 Adafruit_ST7735 tft = Adafruit_ST7735(TFT_CS, TFT_DC, TFT_RST);
 WebServer server(80);
-String stored_ssid;
-String stored_password;
+
+struct RxConfig {
+    char ssid[33];        // 32 characters max per 802.11
+    char password[65];    // 64 characters max for WPA2
+};
+RxConfig gatewayConfig = {};
+ConfigStore configStore("rx", RX_CONFIG_SCHEMA, &gatewayConfig, sizeof(gatewayConfig));
 
 // Display colors
 #define BACKGROUND ST7735_BLACK
@@ -67,39 +142,151 @@ String stored_password;
 #define TIME_COLOR ST7735_CYAN
 #define DATE_COLOR ST7735_YELLOW
 #define SYNC_COLOR ST7735_MAGENTA
+#define DEPTH_TREND_COLOR ST7735_CYAN
+#define TURBIDITY_TREND_COLOR ST7735_YELLOW
+
+// Screen layout (landscape, 160x128). Labels are drawn once; each value is
+// a TextField that repaints only the characters that changed, and the
+// connection square is only repainted when its colour changes.
+#define LABEL_X 5
+#define LABEL_CHARS(n) (LABEL_X + (n) * TextField::CHAR_WIDTH)
+TextField depthField(LABEL_CHARS(7), 20, 18, BACKGROUND);       // after "Depth: "
+TextField tempField(LABEL_CHARS(6), 35, 19, BACKGROUND);        // after "Temp: "
+TextField turbidityField(LABEL_CHARS(11), 50, 14, BACKGROUND);  // after "Turbidity: "
+TextField signalField(LABEL_CHARS(8), 65, 10, BACKGROUND);      // after "Signal: "
+TextField nodeField(LABEL_CHARS(20), 5, 4, BACKGROUND);         // after the title
+TextField dateField(LABEL_X, 105, 13, BACKGROUND);              // "dd/mm/yyyy | "
+TextField timeField(LABEL_CHARS(13), 105, 8, BACKGROUND);
+TextField syncField(LABEL_X, 115, 2, BACKGROUND);
+uint16_t statusColor = BACKGROUND;
+
+// Trend of the node on screen over the last TREND_HOURS, one column per
+// TREND_COLUMN_MS, drawn under the readings
+#define TREND_HOURS 6
+#define TREND_COLUMN_MS (TREND_HOURS * 3600000UL / TREND_COLUMNS)
+TrendChart trendChart(LABEL_X, 76, 28, BACKGROUND, DEPTH_TREND_COLOR, TURBIDITY_TREND_COLOR);
+int chartedNode = -1;   // node id the chart was last drawn for
 
 // Time sync status
 bool timeInitialized = false;
 unsigned long lastNTPSync = 0;
 const unsigned long NTP_SYNC_INTERVAL = 3600000; // 1 hour
 
-// Latest sensor readings
-struct SensorData {
-    float waterDepth;     // Water depth in cm
-    float temperature;    // Temperature in °C
-    float turbidity;      // Turbidity in NTU
-    float current;        // Submersible sensor current in mA
-    float turbVoltage;    // Turbidity sensor voltage
-    int rssi;             // Signal strength
-    bool isValid;         // Data validity flag
-} latestData;
+// Windows waiting for upload (WindowStats.h) overflow into the flash backlog
+static_assert(sizeof(ReadingWindow) <= SegmentLog::MAX_RECORD, "ReadingWindow must fit a backlog record");
+
+// Everything the gateway keeps about one node, in a fixed table looked up
+// by the frame's node id. An entry is about 1.2 KB, most of it the trend
+// (900 B of columns plus its position). When the table is full the node
+// heard from least recently is dropped for a new one. A node silent for
+// NODE_ACTIVE_MS no longer counts as deployed.
+#define NODE_TABLE_SIZE 32        // 32 entries: about 37 KB of node state
+#define NODE_ACTIVE_MS 1800000
+struct NodeState {
+    SensorData latest;            // isValid once a reading has arrived
+    NodeLink link;                // duplicates, ADR and link quality
+    NodeWindow window;            // readings waiting for the next upload
+    TrendHistory trend;
+};
+void nodeEvicted(uint8_t id, NodeState& node);
+NodeTable<NodeState, NODE_TABLE_SIZE> nodes(nodeEvicted);
+int lastUplinkRssi = -120;
 
-// EEPROM helper functions
-void writeString(int addr, String str) {
-    int len = str.length();
-    EEPROM.write(addr, len);
-    for (int i = 0; i < len; i++) {
-        EEPROM.write(addr + 1 + i, str[i]);
+// The TFT shows one node at a time and moves on to the next every
+// DISPLAY_CYCLE_MS
+#define DISPLAY_CYCLE_MS 5000
+uint8_t displayedSlot = NODE_SLOT_NONE;
+
+// Largest packet kept from the radio FIFO (binary frames or legacy JSON)
+#define LORA_MAX_PACKET 255
+
+// Adaptive data rate and the ACK/ADR downlinks, see GatewayLink.h. Each
+// node hears its next profile at least every ADR_DOWNLINK_EVERY uplinks;
+// with no uplink from an active node for ADR_LOST_MS the gateway drops
+// back to the safe profile.
+#define ADR_DOWNLINK_EVERY 4
+#define ADR_LOST_MS 180000
+#define DOWNLINK_DELAY_MS 20
+
+// Frames are taken off the radio by a task woken from DIO0 and wait in a
+// ring until loop() gets to them. The node listens for a downlink for
+// 500 ms after its uplink; a frame that waited longer gets no answer.
+#define RADIO_TASK_PRIORITY 5
+#define RADIO_TASK_CORE 1
+#define DOWNLINK_MAX_WAIT_MS 250
+
+InterruptRadioDriver radio;
+
+class GatewayLog : public GatewayLinkListener {
+public:
+    void downlinkScheduled(const FrameHeader& uplink, bool ack, int8_t margin,
+                           uint8_t profile, uint8_t next) override {
+        Serial.print(ack ? "ACK seq " : "ADR");
+        if (ack) Serial.print(uplink.seq);
+        Serial.print(": node ");
+        Serial.print(uplink.nodeId);
+        Serial.print(", margin ");
+        Serial.print(margin);
+        Serial.print(" dB, profile ");
+        Serial.print(profile);
+        Serial.print(" -> ");
+        Serial.println(next);
     }
-}
+    
+    void downlinkSkipped(const char* reason) override {
+        Serial.print("Downlink skipped: ");
+        Serial.println(reason);
+    }
+    
+    void profileChanged(uint8_t profile, bool fallback) override {
+        if (fallback) Serial.println("ADR: no uplink, falling back to safe profile");
+    }
+};
+GatewayLog gatewayLog;
+
+const GatewayLinkConfig GATEWAY_LINK = {
+    (uint32_t)RADIO_FREQUENCY,
+    &RADIO_DUTY_REGION,
+    RADIO_AIRTIME_POLICY,
+    ADR_DOWNLINK_EVERY,
+    ADR_LOST_MS,
+    NODE_ACTIVE_MS,
+    DOWNLINK_DELAY_MS,
+    DOWNLINK_MAX_WAIT_MS
+};
+GatewayLink<NodeState, NODE_TABLE_SIZE> gatewayLink(radio, nodes, GATEWAY_LINK, gatewayLog);
 
-String readString(int addr) {
-    int len = EEPROM.read(addr);
-    String str = "";
-    for (int i = 0; i < len; i++) {
-        str += char(EEPROM.read(addr + 1 + i));
+// Per-stage latency from packet to cloud, served at /metrics; build with
+// -DMETRICS_ENABLED=0 to leave the probes out
+METRIC_HISTOGRAM(ringLatency, "rx_ring_wait_seconds", "RxDone until loop() takes the frame from the receive ring");
+METRIC_HISTOGRAM(decodeLatency, "rx_decode_seconds", "Frame taken from the receive ring until decoded");
+METRIC_HISTOGRAM(downlinkLatency, "rx_downlink_seconds", "ADR bookkeeping and the ACK or ADR downlink");
+METRIC_HISTOGRAM(displayLatency, "rx_display_seconds", "Decoded readings until the TFT is updated");
+METRIC_HISTOGRAM(firebaseLatency, "rx_firebase_upload_seconds", "Firebase updateNode round trip for one node's windows");
+METRIC_COUNTER(decodeErrors, "rx_decode_errors_total", "Packets that decoded to no reading");
+METRIC_COUNTER(firebaseFailures, "rx_firebase_failures_total", "Firebase uploads that failed");
+
+// Legacy length-prefixed EEPROM string, bounded to the destination size
+void readLegacyString(int addr, char* out, size_t size) {
+    size_t len = EEPROM.read(addr);
+    if (len >= size) len = 0;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = char(EEPROM.read(addr + 1 + i));
     }
-    return str;
+    out[len] = '\0';
+}
+
+// Load the config record, migrating the old EEPROM credentials on the
+// first boot after an update
+void loadConfiguration() {
+    if (configStore.begin()) return;
+    
+    Serial.println("No configuration record, migrating EEPROM");
+    EEPROM.begin(512);
+    readLegacyString(WIFI_SSID_ADDR, gatewayConfig.ssid, sizeof(gatewayConfig.ssid));
+    readLegacyString(WIFI_PASS_ADDR, gatewayConfig.password, sizeof(gatewayConfig.password));
+    EEPROM.end();
+    configStore.commit();
 }
 
 // WiFi Configuration Web Interface
@@ -126,15 +313,23 @@ void handleRoot() {
     }
     html += "</div>";
     
-    if (latestData.isValid) {
+    // One section per node, in table order
+    for (uint8_t slot = 0; slot < nodes.capacity(); slot++) {
+        if (!nodes.used(slot) || !nodes.at(slot).latest.isValid) continue;
+        const NodeState& node = nodes.at(slot);
+        const SensorData& data = node.latest;
         html += "<div class='readings'>";
-        html += "<h3>Latest Readings</h3>";
-        html += "Current Reading: " + String(latestData.current, 2) + " mA<br>";
-        html += "Water Depth: " + String(latestData.waterDepth, 1) + " cm<br>";
-        html += "Temperature: " + String(latestData.temperature, 1) + " °C<br>";
-        html += "Turbidity: " + String(latestData.turbidity, 1) + " NTU<br>";
-        html += "Turbidity Voltage: " + String(latestData.turbVoltage, 2) + " V<br>";
-        html += "Signal Strength: " + String(latestData.rssi) + " dBm<br>";
+        html += "<h3>Node " + String(nodes.id(slot)) + "</h3>";
+        html += "Last heard: " + String((millis() - nodes.lastSeen(slot)) / 1000) + " s ago<br>";
+        html += "Current Reading: " + String(data.current, 2) + " mA<br>";
+        html += "Water Depth: " + String(data.waterDepth, 1) + " cm<br>";
+        html += "Temperature: " + String(data.temperature, 1) + " °C<br>";
+        html += "Turbidity: " + String(data.turbidity, 1) + " NTU<br>";
+        html += "Turbidity Voltage: " + String(data.turbVoltage, 2) + " V<br>";
+        html += "Signal Strength: " + String(data.rssi) + " dBm, SNR " + String(node.link.snr, 1) + " dB<br>";
+        const DuplicateFilterStats& link = node.link.filter.stats();
+        html += "Frames: " + String(link.received) + " received, " + String(link.missing) + " missing, "
+              + String(link.duplicates) + " duplicates (" + String(node.link.filter.deliveryRatio() * 100, 1) + "% delivered)<br>";
         html += "</div>";
     }
     
@@ -160,10 +355,15 @@ void handleWiFiConfig() {
     
     String new_ssid = server.arg("ssid");
     String new_password = server.arg("password");
+    if (new_ssid.length() >= sizeof(gatewayConfig.ssid) ||
+        new_password.length() >= sizeof(gatewayConfig.password)) {
+        server.send(400, "text/plain", "SSID or password too long");
+        return;
+    }
     
-    writeString(WIFI_SSID_ADDR, new_ssid);
-    writeString(WIFI_PASS_ADDR, new_password);
-    EEPROM.commit();
+    strlcpy(gatewayConfig.ssid, new_ssid.c_str(), sizeof(gatewayConfig.ssid));
+    strlcpy(gatewayConfig.password, new_password.c_str(), sizeof(gatewayConfig.password));
+    configStore.commit();    // restarting next, so no deferred write
     
     String response = "<html><body>";
     response += "<h2>Configuration Saved</h2>";
@@ -176,13 +376,93 @@ void handleWiFiConfig() {
     ESP.restart();
 }
 
-void setupWiFiConfig() {
-    WiFi.mode(WIFI_AP);
-    WiFi.softAP(ap_ssid, ap_password);
+#if METRICS_ENABLED
+// metricsWrite() target, streaming into the chunked response
+struct MetricsResponse {
+    void print(const char* text) { server.sendContent(text); }
+};
+
+// Prometheus text format: the per-stage histograms and counters, then the
+// link and airtime statistics the gateway keeps anyway
+void handleMetrics() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4", "");
+    MetricsResponse response;
+    metricsWrite(response);
     
+    DuplicateFilterStats link = gatewayLink.totals();
+    uint32_t expected = link.received + link.missing;
+    const DutyCycleStats& air = gatewayLink.dutyCycle().stats();
+    InterruptRadioStats rx = radio.stats();
+    const SegmentLogStats& backlogStats = backlog.stats();
+    char text[192];
+    const struct {
+        const char* name;
+        const char* type;
+        const char* help;
+        double value;
+    } values[] = {
+        { "rx_frames_received_total", "counter", "Unique frames accepted", (double)link.received },
+        { "rx_frames_missing_total", "counter", "Sequence numbers skipped and not filled", (double)link.missing },
+        { "rx_frames_late_total", "counter", "Skipped sequence numbers that arrived later", (double)link.late },
+        { "rx_frames_duplicate_total", "counter", "Retransmissions of frames already received", (double)link.duplicates },
+        { "rx_delivery_ratio", "gauge", "Share of all nodes' frames received", expected ? (double)link.received / expected : 1.0 },
+        { "rx_nodes", "gauge", "Nodes in the gateway's table", (double)nodes.count() },
+        { "rx_nodes_active", "gauge", "Nodes heard from within NODE_ACTIVE_MS", (double)gatewayLink.activeNodes(millis()) },
+        { "rx_nodes_evicted_total", "counter", "Nodes dropped from the full table", (double)nodes.evicted() },
+        { "rx_radio_frames_total", "counter", "Frames taken off the radio into the receive ring", (double)rx.received },
+        { "rx_radio_dropped_total", "counter", "Frames lost because the receive ring was full", (double)rx.dropped },
+        { "rx_radio_crc_errors_total", "counter", "Frames received with a bad payload CRC", (double)rx.crcErrors },
+        { "rx_radio_ring_high_water", "gauge", "Most frames ever waiting in the receive ring", (double)rx.highWater },
+        { "rx_downlinks_total", "counter", "ACK and ADR downlinks sent", (double)air.frames },
+        { "rx_downlinks_skipped_total", "counter", "Downlinks dropped by the airtime budget", (double)air.deferred },
+        { "rx_airtime_seconds_total", "counter", "Downlink time on air since boot", air.airtimeUs / 1e6 },
+        { "rx_radio_profile", "gauge", "Radio profile chosen by ADR", (double)gatewayLink.profile() },
+        { "rx_uploads_queued_total", "counter", "Windows handed to the upload worker", (double)uploadStats.queued },
+        { "rx_uploads_dropped_total", "counter", "Windows dropped because the upload queue was full", (double)uploadStats.dropped },
+        { "rx_uploads_total", "counter", "Windows uploaded to Firebase", (double)uploadStats.uploaded },
+        { "rx_upload_batches_total", "counter", "Batches of windows that reached Firebase", (double)uploadStats.batches },
+        { "rx_upload_retries_total", "counter", "Upload attempts repeated after a failure", (double)uploadStats.retries },
+        { "rx_uploads_stored_total", "counter", "Windows moved to the flash backlog", (double)uploadStats.stored },
+        { "rx_uploads_lost_total", "counter", "Windows the backlog could not take", (double)uploadStats.failed },
+        { "rx_backlog_capacity_bytes", "gauge", "Flash set aside for the backlog", (double)backlogStats.capacityBytes },
+        { "rx_backlog_used_bytes", "gauge", "Backlog bytes waiting to be replayed", (double)backlogStats.usedBytes },
+        { "rx_backlog_records", "gauge", "Windows waiting in the backlog", (double)backlogStats.records },
+        { "rx_backlog_replayed_total", "counter", "Backlog windows uploaded", (double)backlogStats.replayed },
+        { "rx_backlog_overwritten_total", "counter", "Oldest backlog windows dropped to make room", (double)backlogStats.overwritten },
+        { "rx_backlog_corrupt_total", "counter", "Backlog segments cut short by a damaged record", (double)backlogStats.corrupt },
+        { "rx_upload_queue_depth", "gauge", "Windows waiting for the upload worker",
+          uploadQueue ? (double)uxQueueMessagesWaiting(uploadQueue) : 0 },
+        { "rx_upload_backoff_seconds", "gauge", "Wait before the next upload attempt", uploadStats.backoffMs / 1000.0 },
+        { "rx_firebase_ready", "gauge", "1 while Firebase is reachable", firebaseReady ? 1.0 : 0.0 },
+        { "rx_rssi_dbm", "gauge", "RSSI of the last uplink", (double)lastUplinkRssi },
+        { "rx_display_pixels_total", "counter", "Pixels sent to the TFT by value fields and the trend chart",
+          (double)(TextField::pixelsSent() + TrendChart::pixelsSent()) },
+        { "rx_heap_free_bytes", "gauge", "Free heap", (double)ESP.getFreeHeap() },
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        metricsFormatValue(text, sizeof(text), values[i].name, values[i].type, values[i].help, values[i].value);
+        response.print(text);
+    }
+    server.sendContent("");
+}
+#endif
+
+// The status page and /metrics are served on the home network too, not
+// only on the configuration AP
+void setupWebServer() {
     server.on("/", HTTP_GET, handleRoot);
     server.on("/configure", HTTP_POST, handleWiFiConfig);
+#if METRICS_ENABLED
+    server.on("/metrics", HTTP_GET, handleMetrics);
+#endif
     server.begin();
+}
+
+void setupWiFiConfig() {
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(ap_ssid, ap_password);
+    setupWebServer();
     
     Serial.println("Configuration AP Started");
     Serial.print("IP Address: ");
@@ -195,67 +475,331 @@ void initFirebase() {
     auth.user.email = USER_EMAIL;
     auth.user.password = USER_PASSWORD;
     config.token_status_callback = tokenStatusCallback;
+    config.timeout.socketConnection = UPLOAD_TIMEOUT_MS;
+    config.timeout.serverResponse = UPLOAD_TIMEOUT_MS;
     
     Firebase.begin(&config, &auth);
     Firebase.reconnectWiFi(true);
-    
-    while ((auth.token.uid) == "") {
-        Serial.print('.');
-        delay(1000);
-    }
+}
+
+// The database path needs the user's UID, known once the first token
+// has arrived, i.e. the first time Firebase.ready() is true
+void setDatabasePath() {
+    if (databasePath.length() > 0) return;
     
     uid = auth.token.uid.c_str();
     Serial.print("User UID: ");
     Serial.println(uid);
     
-    databasePath = String("/AWRLData/") + String(uid) + String("/Record");
+    databasePath = String("/AWRLData/") + String(uid) + String("/Nodes");
 }
 
-void sendToFirebase(const SensorData& data) {
-    if (!Firebase.ready()) {
-        Serial.println("Firebase not ready");
-        return;
-    }
+// Wall-clock time a reading was taken, given its age on arrival
+time_t readingTimestamp(uint32_t ageDs) {
+    time_t now = time(nullptr);
+    if (now < 1000000000) return 0;  // Clock not synced yet
+    return now - (ageDs + 5) / 10;
+}
+
+void windowTimestamp(time_t t, char* text, size_t size) {
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    strftime(text, size, "%Y-%m-%d_%H-%M-%S", &timeinfo);
+}
 
+// One field's statistics under key/stats/name
+void addFieldJson(FirebaseJson& json, const String& key, const char* name, const FieldStats& field) {
+    if (field.count == 0) return;
+    String path = key + "/stats/" + name + "/";
+    json.set(path + "min", field.min);
+    json.set(path + "max", field.max);
+    json.set(path + "mean", field.mean());
+    json.set(path + "last", field.last);
+    json.set(path + "n", (int)field.count);
+}
+
+// A window under its end time. depth, temperature and turbidity_ntu keep
+// the layout of the single-reading records (the last value of the
+// window), so readers of the old Record/ layout only need the node's path.
+void addWindowJson(FirebaseJson& json, const ReadingWindow& w) {
+    char timeStringBuff[30];
+    windowTimestamp(w.end, timeStringBuff, sizeof(timeStringBuff));
+    String key = String(timeStringBuff);
+    
+    json.set(key + "/depth", w.waterDepth.last);
+    json.set(key + "/temperature", w.temperature.count > 0 ? w.temperature.last : -127);
+    json.set(key + "/timestamp", key);
+    json.set(key + "/turbidity_ntu", w.turbidity.last);
+    
+    windowTimestamp(w.start, timeStringBuff, sizeof(timeStringBuff));
+    json.set(key + "/window_start", String(timeStringBuff));
+    json.set(key + "/samples", (int)w.samples);
+    json.set(key + "/flags", (int)w.flags);
+    addFieldJson(json, key, "depth", w.waterDepth);
+    addFieldJson(json, key, "temperature", w.temperature);
+    addFieldJson(json, key, "turbidity_ntu", w.turbidity);
+    addFieldJson(json, key, "current_ma", w.current);
+    addFieldJson(json, key, "turbidity_voltage", w.turbVoltage);
+    addFieldJson(json, key, "rssi", w.rssi);
+}
+
+// Called from the upload worker only. Each node's windows become children
+// of Nodes/<id>/Record in a single updateNode, so a batch costs one HTTPS
+// round trip per node in it. A window closed before the clock was set gets
+// the upload time. Returns true once Firebase has all of them.
+bool sendToFirebase(ReadingWindow* windows, size_t count) {
     Serial.println("\n--- Firebase Upload Attempt ---");
     
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        Serial.println("Failed to obtain time");
-        return;
+    for (size_t i = 0; i < count; i++) {
+        if (windows[i].end == 0) windows[i].end = readingTimestamp(0);
+        if (windows[i].start == 0) windows[i].start = windows[i].end;
+        if (windows[i].end == 0) {
+            Serial.println("Failed to obtain time");
+            return false;
+        }
     }
     
-    char timeStringBuff[30];
-    strftime(timeStringBuff, sizeof(timeStringBuff), "%Y-%m-%d_%H-%M-%S", &timeinfo);
-    String timestamp = String(timeStringBuff);
-    
-    String readingPath = String(databasePath) + String("/") + String(timestamp);
-    
-    // Create a JSON object with all data exactly matching the screenshot format
-    FirebaseJson json;
-    json.set("depth", data.waterDepth);
-    json.set("temperature", data.temperature);
-    json.set("timestamp", timestamp);
-    json.set("turbidity_ntu", data.turbidity);
-
-    // Debug print before upload
-    Serial.println("Uploading complete data set:");
-    Serial.print("Path: "); Serial.println(readingPath);
-    String jsonStr;
-    json.toString(jsonStr, true);
-    Serial.println(jsonStr);
-
-    // Upload entire JSON object in one transaction
-    if (Firebase.RTDB.setJSON(&fbdo, readingPath.c_str(), &json)) {
-        Serial.println("Complete data upload successful!");
-        tft.fillRect(tft.width() - 10, 0, 10, 10, VALUE_COLOR);
+    bool sent[UPLOAD_BATCH_MAX] = {};
+    for (size_t i = 0; i < count; i++) {
+        if (sent[i]) continue;
+        uint8_t nodeId = windows[i].nodeId;
+        FirebaseJson json;
+        size_t nodeWindows = 0;
+        for (size_t j = i; j < count; j++) {
+            if (sent[j] || windows[j].nodeId != nodeId) continue;
+            addWindowJson(json, windows[j]);
+            sent[j] = true;
+            nodeWindows++;
+        }
+        
+        String nodePath = databasePath + "/" + String(nodeId) + "/Record";
+        Serial.print("Path: ");
+        Serial.print(nodePath);
+        Serial.print(", ");
+        Serial.print(nodeWindows);
+        Serial.println(nodeWindows == 1 ? " window" : " windows");
+        
+        METRIC_STAMP(uploadStart);
+        bool uploaded = Firebase.RTDB.updateNode(&fbdo, nodePath.c_str(), &json);
+        METRIC_SINCE(firebaseLatency, uploadStart);
+        if (!uploaded) {
+            // Windows already sent are sent again with the retry, to the same paths
+            METRIC_COUNT(firebaseFailures);
+            Serial.println("Data upload failed");
+            Serial.println("Error: " + fbdo.errorReason());
+            return false;
+        }
+    }
+    Serial.println("Window upload successful!");
+    return true;
+}
+
+uint32_t nextBackoff(uint32_t backoffMs) {
+    if (backoffMs == 0) return UPLOAD_BACKOFF_MIN_MS;
+    return backoffMs * 2 < UPLOAD_BACKOFF_MAX_MS ? backoffMs * 2 : UPLOAD_BACKOFF_MAX_MS;
+}
+
+// Into the backlog, with the time it was closed if no reading in it had
+// a clock, so a late upload still lands under the right timestamp
+void storeWindow(ReadingWindow& w) {
+    if (w.end == 0) w.end = readingTimestamp(0);
+    if (w.start == 0) w.start = w.end;
+    if (backlogReady && backlog.append(&w, sizeof(w))) {
+        uploadStats.stored++;
+    } else {
+        uploadStats.failed++;
+        Serial.println("Window lost: backlog unavailable");
+    }
+}
+
+// The oldest backlog windows, up to max of them from one segment. Records
+// written by a firmware with another layout are skipped, and popped with
+// the batch.
+size_t peekBacklog(ReadingWindow* batch, size_t max) {
+    size_t count = 0;
+    size_t peeked = 0;
+    size_t length = backlog.peek(&batch[0], sizeof(ReadingWindow));
+    while (length > 0) {
+        peeked++;
+        if (length == sizeof(ReadingWindow)) count++;
+        if (count == max) break;
+        length = backlog.peekNext(&batch[count], sizeof(ReadingWindow));
+    }
+    if (count == 0 && peeked > 0) backlog.pop();
+    return count;
+}
+
+void printBacklog() {
+    const SegmentLogStats& backlogStats = backlog.stats();
+    Serial.print("Backlog: ");
+    Serial.print(backlogStats.records);
+    Serial.print(" windows, ");
+    Serial.print(backlogStats.usedBytes);
+    Serial.print("/");
+    Serial.print(backlogStats.capacityBytes);
+    Serial.print(" bytes (");
+    Serial.print(100.0 * backlogStats.usedBytes / backlogStats.capacityBytes, 1);
+    Serial.print("%), ");
+    Serial.print(backlogStats.replayed);
+    Serial.print(" replayed, ");
+    Serial.print(backlogStats.overwritten);
+    Serial.println(" overwritten");
+}
+
+// A batch of live windows is taken off the queue and held until it is
+// uploaded; after UPLOAD_MAX_ATTEMPTS it goes to the backlog. While
+// Firebase is unreachable everything queued is moved to the backlog
+// straight away, and waiting does not use up attempts.
+void uploadWorker(void* arg) {
+    backlogReady = backlog.begin();
+    if (backlogReady) {
+        printBacklog();
+    } else {
+        Serial.println("Error: Could not open the upload backlog");
+    }
+    initFirebase();
+    
+    static ReadingWindow batch[UPLOAD_BATCH_MAX];
+    size_t batchCount = 0;
+    bool live = false;
+    uint8_t attempts = 0;
+    unsigned long replayStart = 0;
+    uint32_t replayFirst = 0;
+    for (;;) {
+        // Live windows first; the backlog only between them, at a bounded rate
+        if (batchCount == 0) {
+            TickType_t wait = backlog.empty() ? portMAX_DELAY : pdMS_TO_TICKS(BACKLOG_REPLAY_INTERVAL_MS);
+            live = xQueueReceive(uploadQueue, &batch[0], wait) == pdTRUE;
+            if (live) {
+                batchCount = 1;
+                while (batchCount < UPLOAD_BATCH_MAX &&
+                       xQueueReceive(uploadQueue, &batch[batchCount], 0) == pdTRUE) {
+                    batchCount++;
+                }
+            } else {
+                batchCount = peekBacklog(batch, UPLOAD_BATCH_MAX);
+                if (batchCount == 0) continue;
+            }
+        }
+        
+        bool connected = WiFi.status() == WL_CONNECTED;
+        firebaseReady = connected && Firebase.ready();
+        if (!firebaseReady) {
+            if (live) {
+                for (size_t i = 0; i < batchCount; i++) storeWindow(batch[i]);
+            }
+            ReadingWindow queued;
+            while (xQueueReceive(uploadQueue, &queued, 0) == pdTRUE) {
+                storeWindow(queued);
+            }
+            batchCount = 0;
+            attempts = 0;
+            if (connected) {
+                Serial.println("Firebase not ready, attempting to reconnect...");
+                Firebase.begin(&config, &auth);
+            }
+            uploadStats.backoffMs = nextBackoff(uploadStats.backoffMs);
+            vTaskDelay(pdMS_TO_TICKS(uploadStats.backoffMs));
+            continue;
+        }
+        setDatabasePath();
+        
+        unsigned long start = millis();
+        bool uploaded = sendToFirebase(batch, batchCount);
+        uploadStats.lastLatencyMs = millis() - start;
+        
+        if (uploaded) {
+            uploadStats.uploaded += batchCount;
+            uploadStats.batches++;
+            uploadStats.backoffMs = 0;
+            lastUploadAt = millis();
+            attempts = 0;
+            batchCount = 0;
+        }
+        
+        if (!live) {
+            if (!uploaded) {
+                // Peeked again after the wait, in case live windows came first
+                batchCount = 0;
+                uploadStats.retries++;
+                uploadStats.backoffMs = nextBackoff(uploadStats.backoffMs);
+                vTaskDelay(pdMS_TO_TICKS(uploadStats.backoffMs));
+                continue;
+            }
+            if (replayStart == 0) {
+                replayStart = millis();
+                replayFirst = backlog.stats().replayed;
+            }
+            backlog.pop();
+            if (backlog.empty()) {
+                // Replay throughput for the whole drain, pauses for live windows included
+                uint32_t count = backlog.stats().replayed - replayFirst;
+                float seconds = (millis() - replayStart) / 1000.0;
+                Serial.print("Backlog replayed: ");
+                Serial.print(count);
+                Serial.print(" windows in ");
+                Serial.print(seconds, 1);
+                Serial.print(" s (");
+                Serial.print(seconds > 0 ? count / seconds : 0, 2);
+                Serial.println("/s)");
+                replayStart = 0;
+            }
+            continue;
+        }
+        
+        if (!uploaded && ++attempts >= UPLOAD_MAX_ATTEMPTS) {
+            Serial.println("Upload failed, moved to backlog");
+            for (size_t i = 0; i < batchCount; i++) storeWindow(batch[i]);
+            attempts = 0;
+            batchCount = 0;
+            uploadStats.backoffMs = 0;
+        } else if (!uploaded) {
+            uploadStats.retries++;
+            uploadStats.backoffMs = nextBackoff(uploadStats.backoffMs);
+            vTaskDelay(pdMS_TO_TICKS(uploadStats.backoffMs));
+        }
+    }
+}
+
+void startUploadWorker() {
+    uploadQueue = xQueueCreate(UPLOAD_QUEUE_LENGTH, sizeof(ReadingWindow));
+    if (uploadQueue == NULL ||
+        xTaskCreatePinnedToCore(uploadWorker, "upload", UPLOAD_TASK_STACK, NULL,
+                                UPLOAD_TASK_PRIORITY, NULL, UPLOAD_TASK_CORE) != pdPASS) {
+        Serial.println("Error: Could not start the upload worker");
+    }
+}
+
+// Never blocks: back-pressure shows up as dropped windows
+void queueUpload(const ReadingWindow& w) {
+    if (uploadQueue == NULL) return;
+    if (xQueueSend(uploadQueue, &w, 0) == pdTRUE) {
+        uploadStats.queued++;
     } else {
-        Serial.println("Data upload failed");
-        Serial.println("Error: " + fbdo.errorReason());
-        tft.fillRect(tft.width() - 10, 0, 10, 10, ERROR_COLOR);
+        uploadStats.dropped++;
+        Serial.println("Upload queue full, window dropped");
+    }
+}
+
+// Queues the node's window if it's due. An empty window is left open, so
+// a node's first data after a silence is uploaded at once.
+void closeWindow(NodeState& node, uint32_t now, uint32_t intervalMs = FIREBASE_UPDATE_INTERVAL) {
+    if (node.window.current.samples == 0) return;
+    ReadingWindow finished;
+    if (node.window.close(now, intervalMs, finished)) {
+        if (finished.end == 0) finished.end = readingTimestamp(0);
+        queueUpload(finished);
     }
 }
 
+// A full table is making room for a new node: the old one's readings are
+// uploaded now rather than lost with its slot
+void nodeEvicted(uint8_t id, NodeState& node) {
+    Serial.print("Node table full, evicting node ");
+    Serial.println(id);
+    closeWindow(node, millis(), 0);
+}
+
 void timeAvailable(struct timeval *t) {
     Serial.println("NTP time sync completed!");
     timeInitialized = true;
@@ -299,104 +843,294 @@ void setupDisplay() {
     tft.setCursor(5, 5);
     tft.println("Water Level Monitor");
     tft.drawFastHLine(0, 15, tft.width(), TEXT_COLOR);
+    
+    tft.setTextColor(TIME_COLOR);
+    tft.setCursor(LABEL_CHARS(2), 115);
+    tft.print("sinaubumi.org");
+}
+
+// The connection square
+void showStatus(uint16_t color) {
+    if (color == statusColor) return;
+    tft.fillRect(tft.width() - 10, 0, 10, 10, color);
+    statusColor = color;
 }
 
 void displayDateTime() {
     struct tm timeinfo;
     if(!getLocalTime(&timeinfo)) {
-        tft.fillRect(0, 105, tft.width(), 25, BACKGROUND);
-        tft.setTextColor(ERROR_COLOR);
-        tft.setCursor(5, 115);
-        tft.print("Time Error");
+        dateField.show(tft, "Time Error", ERROR_COLOR);
+        timeField.show(tft, "", ERROR_COLOR);
         return;
     }
     
-    tft.fillRect(0, 105, tft.width(), 25, BACKGROUND);
-    
-    char dateTimeStr[30];
-    strftime(dateTimeStr, sizeof(dateTimeStr), "%d/%m/%Y | %H:%M:%S", &timeinfo);
-    tft.setTextColor(DATE_COLOR);
-    tft.setCursor(5, 105);
-    tft.print(dateTimeStr);
+    char text[16];
+    strftime(text, sizeof(text), "%d/%m/%Y | ", &timeinfo);
+    dateField.show(tft, text, DATE_COLOR);
+    strftime(text, sizeof(text), "%H:%M:%S", &timeinfo);
+    timeField.show(tft, text, DATE_COLOR);
     
-    tft.setCursor(5, 115);
-    if (timeInitialized && (millis() - lastNTPSync < NTP_SYNC_INTERVAL)) {
-        tft.setTextColor(SYNC_COLOR);
-        tft.print("@ ");
-    }
-    tft.setTextColor(TIME_COLOR);
-    tft.print("sinaubumi.org");
+    bool synced = timeInitialized && (millis() - lastNTPSync < NTP_SYNC_INTERVAL);
+    syncField.show(tft, synced ? "@" : "", SYNC_COLOR);
+}
+
+void drawReadingLabels() {
+    tft.setTextColor(TEXT_COLOR);
+    tft.setCursor(LABEL_X, 20);
+    tft.print("Depth: ");
+    tft.setCursor(LABEL_X, 35);
+    tft.print("Temp: ");
+    tft.setCursor(LABEL_X, 50);
+    tft.print("Turbidity: ");
+    tft.setCursor(LABEL_X, 65);
+    tft.print("Signal: ");
 }
 
 void updateDisplay(const SensorData& data) {
-    tft.fillRect(0, 16, tft.width(), 89, BACKGROUND);
+    static bool labelsDrawn = false;
+    if (!labelsDrawn) {
+        drawReadingLabels();
+        labelsDrawn = true;
+    }
+    char text[TextField::MAX_CHARS + 1];
     
     // Display Water Depth with Current in parentheses
-    tft.setTextColor(TEXT_COLOR);
-    tft.setCursor(5, 20);
-    tft.print("Depth: ");
-    tft.setTextColor(VALUE_COLOR);
-    tft.print(data.waterDepth, 1);
-    tft.print(" cm (");
-    tft.print(data.current, 2);
-    tft.println(" mA)");
+    snprintf(text, sizeof(text), "%.1f cm (%.2f mA)", data.waterDepth, data.current);
+    depthField.show(tft, text, VALUE_COLOR);
     
     // Display Temperature
-    tft.setTextColor(TEXT_COLOR);
-    tft.setCursor(5, 35);
-    tft.print("Temp: ");
     if(data.temperature != -127) {
-        tft.setTextColor(VALUE_COLOR);
-        tft.print(data.temperature, 1);
-        tft.println(" C");
+        snprintf(text, sizeof(text), "%.1f C", data.temperature);
+        tempField.show(tft, text, VALUE_COLOR);
     } else {
-        tft.setTextColor(ERROR_COLOR);
-        tft.println("Error");
+        tempField.show(tft, "Error", ERROR_COLOR);
     }
     
     // Display Turbidity
-    tft.setTextColor(TEXT_COLOR);
-    tft.setCursor(5, 50);
-    tft.print("Turbidity: ");
-    tft.setTextColor(VALUE_COLOR);
-    tft.print(data.turbidity, 1);
-    tft.println(" NTU");
+    snprintf(text, sizeof(text), "%.1f NTU", data.turbidity);
+    turbidityField.show(tft, text, VALUE_COLOR);
     
     // Display Signal Strength
-    tft.setTextColor(TEXT_COLOR);
-    tft.setCursor(5, 65);
-    tft.print("Signal: ");
-    
     if (data.rssi >= -50) {
-        tft.setTextColor(ST7735_GREEN);
-        tft.println("Excellent");
+        signalField.show(tft, "Excellent", ST7735_GREEN);
     } else if (data.rssi >= -70) {
-        tft.setTextColor(ST7735_GREEN);
-        tft.println("Good");
+        signalField.show(tft, "Good", ST7735_GREEN);
     } else if (data.rssi >= -90) {
-        tft.setTextColor(ST7735_YELLOW);
-        tft.println("Fair");
+        signalField.show(tft, "Fair", ST7735_YELLOW);
     } else {
-        tft.setTextColor(ST7735_RED);
-        tft.println("Poor");
+        signalField.show(tft, "Poor", ST7735_RED);
+    }
+    
+    // Display which node this is
+    snprintf(text, sizeof(text), "#%u", data.nodeId);
+    nodeField.show(tft, text, VALUE_COLOR);
+}
+
+uint32_t trendColumn(unsigned long ms) {
+    return ms / TREND_COLUMN_MS;
+}
+
+// The chart keeps its columns while the same node stays on screen and is
+// only repainted in full when another node comes up
+void showTrend(uint8_t slot) {
+    uint32_t column = trendColumn(millis());
+    if (nodes.id(slot) != chartedNode) {
+        chartedNode = nodes.id(slot);
+        trendChart.drawAll(tft, nodes.at(slot).trend, column);
+    } else {
+        trendChart.drawColumn(tft, nodes.at(slot).trend, column);
+    }
+}
+
+void showNode(uint8_t slot) {
+    displayedSlot = slot;
+    updateDisplay(nodes.at(slot).latest);
+    showTrend(slot);
+}
+
+// The next node with readings after the one shown, wrapping around
+void showNextNode() {
+    for (uint8_t step = 1; step <= nodes.capacity(); step++) {
+        uint8_t slot = (displayedSlot == NODE_SLOT_NONE ? step - 1 : displayedSlot + step) % nodes.capacity();
+        if (nodes.used(slot) && nodes.at(slot).latest.isValid) {
+            showNode(slot);
+            return;
+        }
     }
 }
 
+// Binary frame from the shared SubmersibleFrame codec. A batch frame is
+// unpacked into one reading per sample, oldest first; waitedDs is how long
+// the frame sat in the receive ring. Returns the number of readings stored.
+size_t decodeBinaryPacket(const uint8_t* packet, size_t len, FrameHeader& header,
+                          SensorData* readings, size_t maxReadings, uint32_t waitedDs) {
+    FrameSample samples[FRAME_BATCH_MAX];
+    size_t count = 0;
+    FrameStatus status = frameDecodeUplink(packet, len, header, samples, FRAME_BATCH_MAX, count);
+    if (count > maxReadings) count = maxReadings;
+    for (size_t i = 0; i < count; i++) {
+        readingFromFrame(samples[i].reading, readings[i]);
+        readings[i].timestamp = readingTimestamp(samples[i].ageDs + waitedDs);
+    }
+    
+    if (status != FRAME_OK) {
+        Serial.print("Frame decode failed: ");
+        Serial.println(frameStatusString(status));
+        if (count == 0) return 0;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        readings[i].nodeId = header.nodeId;
+    }
+    
+    Serial.print("Binary frame from node ");
+    Serial.print(header.nodeId);
+    Serial.print(", seq ");
+    Serial.print(header.seq);
+    Serial.print(", readings ");
+    Serial.println(count);
+    return count;
+}
+
+// Legacy JSON packet, kept while older senders are still deployed
+bool decodeLegacyPacket(const uint8_t* packet, size_t len, SensorData& data) {
+    Serial.print("Raw message: ");
+    Serial.write(packet, len);
+    Serial.println();
+
+    DynamicJsonDocument doc(200);
+    DeserializationError error = deserializeJson(doc, (const char*)packet, len);
+    if (error) {
+        Serial.println("JSON parsing failed");
+        Serial.print("Error: ");
+        Serial.println(error.c_str());
+        return false;
+    }
+    
+    data.current = doc["current"].as<float>();  // Current in mA
+    data.waterDepth = doc["depth"].as<float>(); // Depth in cm
+    data.temperature = doc["temp"].as<float>(); // Temperature in °C
+    data.turbVoltage = doc["turb_v"].as<float>(); // Turbidity voltage
+    data.turbidity = doc["turb_ntu"].as<float>(); // Turbidity in NTU
+    data.nodeId = doc["id"] | 0;
+    data.flags = 0;
+    data.timestamp = readingTimestamp(0);
+    return true;
+}
+
+void printReading(const SensorData& data) {
+    Serial.println("Parsed Data:");
+    if (data.timestamp > 0) {
+        struct tm timeinfo;
+        char timeStr[30];
+        localtime_r(&data.timestamp, &timeinfo);
+        strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", &timeinfo);
+        Serial.print("Taken at: ");
+        Serial.println(timeStr);
+    }
+    Serial.print("Current: ");
+    Serial.print(data.current);
+    Serial.println(" mA");
+    Serial.print("Water Depth: ");
+    Serial.print(data.waterDepth);
+    Serial.println(data.flags & FRAME_FLAG_DEPTH_GATED ? " cm (held by node filter)" : " cm");
+    Serial.print("Temperature: ");
+    Serial.print(data.temperature);
+    Serial.println(" °C");
+    Serial.print("Turbidity Voltage: ");
+    Serial.print(data.turbVoltage);
+    Serial.println(" V");
+    Serial.print("Turbidity: ");
+    Serial.print(data.turbidity);
+    Serial.println(data.flags & FRAME_FLAG_TURB_GATED ? " NTU (held by node filter)" : " NTU");
+    Serial.print("RSSI: ");
+    Serial.print(data.rssi);
+    Serial.println(" dBm");
+}
+
+void printLinkStats(const NodeState& node) {
+    const DuplicateFilterStats& link = node.link.filter.stats();
+    Serial.print("Node ");
+    Serial.print(node.latest.nodeId);
+    Serial.print(" of ");
+    Serial.print(nodes.count());
+    Serial.print(", seq ");
+    Serial.print(node.link.lastSeq);
+    Serial.print(", SNR ");
+    Serial.print(node.link.snr, 1);
+    Serial.print(" dB, link: received ");
+    Serial.print(link.received);
+    Serial.print(", missing ");
+    Serial.print(link.missing);
+    Serial.print(", late ");
+    Serial.print(link.late);
+    Serial.print(", duplicates ");
+    Serial.print(link.duplicates);
+    Serial.print(", delivery ");
+    Serial.print(node.link.filter.deliveryRatio() * 100, 1);
+    Serial.println("%");
+    
+    InterruptRadioStats rx = radio.stats();
+    Serial.print("Radio: ");
+    Serial.print(rx.received);
+    Serial.print(" frames, ");
+    Serial.print(rx.dropped);
+    Serial.print(" dropped (ring full), ");
+    Serial.print(rx.crcErrors);
+    Serial.print(" CRC errors, ring high water ");
+    Serial.print(rx.highWater);
+    Serial.print("/");
+    Serial.println(InterruptRadioDriver::RING_SIZE);
+    
+    Serial.print("Window ");
+    Serial.print(node.window.current.samples);
+    Serial.print(" samples, uploads: ");
+    Serial.print(uploadStats.queued);
+    Serial.print(" queued, ");
+    Serial.print(uploadStats.uploaded);
+    Serial.print(" uploaded in ");
+    Serial.print(uploadStats.batches);
+    Serial.print(" batches, ");
+    Serial.print(uploadStats.retries);
+    Serial.print(" retries, ");
+    Serial.print(uploadStats.stored);
+    Serial.print(" to backlog, ");
+    Serial.print(uploadStats.failed);
+    Serial.print(" lost, ");
+    Serial.print(uploadStats.dropped);
+    Serial.print(" dropped, waiting ");
+    Serial.println(uploadQueue ? uxQueueMessagesWaiting(uploadQueue) : 0);
+    printBacklog();
+    
+    const DutyCycleStats& air = gatewayLink.dutyCycle().stats();
+    Serial.print("Downlink airtime: ");
+    Serial.print(gatewayLink.dutyCycle().usedUs(RADIO_FREQUENCY, millis()) / 1e6, 1);
+    Serial.print(" s in window, ");
+    Serial.print(air.frames);
+    Serial.print(" frames, skipped ");
+    Serial.println(air.deferred);
+}
+
 void setup() {
     Serial.begin(115200);
     while (!Serial);
     Serial.println("Water Monitor System");
 
-    EEPROM.begin(512);
+    loadConfiguration();
     setupDisplay();
     
-    // Try to connect with stored credentials
-    stored_ssid = readString(WIFI_SSID_ADDR);
-    stored_password = readString(WIFI_PASS_ADDR);
+    // The backlog and the upload worker run whatever the WiFi state: a
+    // gateway that boots into an outage (or with no credentials yet)
+    // stores its windows until Firebase is reachable
+    if (!LittleFS.begin(true)) {
+        Serial.println("Error: Could not mount LittleFS");
+    }
+    startUploadWorker();
     
-    if (stored_ssid.length() > 0) {
+    // Try to connect with stored credentials
+    if (gatewayConfig.ssid[0] != '\0') {
         WiFi.mode(WIFI_STA);
-        WiFi.begin(stored_ssid.c_str(), stored_password.c_str());
+        WiFi.begin(gatewayConfig.ssid, gatewayConfig.password);
         
         int attempts = 0;
         while (WiFi.status() != WL_CONNECTED && attempts < 20) {
@@ -409,61 +1143,51 @@ void setup() {
     if (WiFi.status() != WL_CONNECTED) {
         setupWiFiConfig();
     } else {
+        setupWebServer();
+        Serial.print("Web server at http://");
+        Serial.println(WiFi.localIP());
         setupTime();
-        initFirebase();
     }
     
     // Initialize LoRa
     LoRa.setPins(LORA_SS, LORA_RST, LORA_DIO0);
-    while (!LoRa.begin(915E6)) {
+    while (!LoRa.begin(RADIO_FREQUENCY)) {
         Serial.print(".");
         delay(500);
     }
     
-    // Configure LoRa parameters - using different settings to avoid interference
-    LoRa.setTxPower(17);                // Reduced power from 20 to 17
-    LoRa.setSignalBandwidth(250E3);     // Changed bandwidth from 500kHz to 250kHz
-    LoRa.setSpreadingFactor(8);         // Increased spreading factor from 7 to 8
-    LoRa.setCodingRate4(6);             // Changed coding rate from 4/5 to 4/6
-    LoRa.setSyncWord(0xA5);             // Changed sync word from 0xF0 to 0xA5 for submersible parameter
-    LoRa.enableCrc();
+    if (!radio.begin(LORA_DIO0, RADIO_TASK_PRIORITY, RADIO_TASK_CORE)) {
+        Serial.println("Error: Could not start the LoRa receive task");
+    }
+    
+    // Start on the shared safe profile; ADR speeds the link up from there
+    gatewayLink.begin();
     
     Serial.println("Setup Complete!");
-    
-    // Initialize latestData
-    latestData.isValid = false;
-    latestData.current = 0;
-    latestData.waterDepth = 0;
-    latestData.temperature = 0;
-    latestData.turbidity = 0;
-    latestData.turbVoltage = 0;
-    latestData.rssi = -120;
 }
 
 void loop() {
     static unsigned long lastTimeUpdate = 0;
     static unsigned long lastWiFiCheck = 0;
-    static unsigned long lastFirebaseRetry = 0;
-    static bool firstDataSent = false;
+    static unsigned long lastDisplayCycle = 0;
+    static unsigned long lastWindowSweep = 0;
+    static uint32_t lastTrendColumn = 0;
     unsigned long currentMillis = millis();
 
     // Constants for timing
     const unsigned long TIME_UPDATE_INTERVAL = 1000;      // 1 second
     const unsigned long WIFI_CHECK_INTERVAL = 30000;      // 30 seconds
-    const unsigned long FIREBASE_RETRY_INTERVAL = 5000;   // 5 seconds
 
-    // Handle WiFi configuration if not connected
-    if (WiFi.status() != WL_CONNECTED) {
-        server.handleClient();
-        tft.fillRect(tft.width() - 10, 0, 10, 10, ERROR_COLOR);
-        
-        // Attempt to reconnect to WiFi
-        if (currentMillis - lastWiFiCheck >= WIFI_CHECK_INTERVAL) {
-            Serial.println("Attempting to reconnect to WiFi...");
+    server.handleClient();
+    
+    // Without WiFi only the uploads stop: reception, ACKs and windows go
+    // on, and the worker moves the windows to the backlog
+    if (currentMillis - lastWiFiCheck >= WIFI_CHECK_INTERVAL) {
+        if (WiFi.status() != WL_CONNECTED) {
+            Serial.println("WiFi disconnected, attempting to reconnect...");
             WiFi.reconnect();
-            lastWiFiCheck = currentMillis;
         }
-        return;
+        lastWiFiCheck = currentMillis;
     }
 
     // Update time display every second
@@ -472,104 +1196,109 @@ void loop() {
         lastTimeUpdate = currentMillis;
     }
     
-    // Check connections and retry if needed
-    if (currentMillis - lastWiFiCheck >= WIFI_CHECK_INTERVAL) {
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("WiFi disconnected, attempting to reconnect...");
-            WiFi.reconnect();
-        }
-        if (!Firebase.ready()) {
-            Serial.println("Firebase not ready, attempting to reconnect...");
-            Firebase.begin(&config, &auth);
-        }
-        lastWiFiCheck = currentMillis;
+    // Move the TFT on to the next node
+    if (nodes.count() > 1 && currentMillis - lastDisplayCycle >= DISPLAY_CYCLE_MS) {
+        showNextNode();
+        lastDisplayCycle = currentMillis;
     }
-
-    // Firebase reconnection attempt
-    if (!Firebase.ready() && (currentMillis - lastFirebaseRetry >= FIREBASE_RETRY_INTERVAL)) {
-        Serial.println("Attempting to reconnect to Firebase...");
-        Firebase.begin(&config, &auth);
-        lastFirebaseRetry = currentMillis;
+    
+    // Start the chart's next column, even if the node is silent
+    if (displayedSlot != NODE_SLOT_NONE && trendColumn(currentMillis) != lastTrendColumn) {
+        lastTrendColumn = trendColumn(currentMillis);
+        showTrend(displayedSlot);
     }
-
+    
     // Handle LoRa packets
-    int packetSize = LoRa.parsePacket();
-    if (packetSize) {
-        String message = "";
-        while (LoRa.available()) {
-            message += (char)LoRa.read();
-        }
+    uint8_t packet[LORA_MAX_PACKET];
+    METRIC_STAMP(receiveStart);
+    size_t packetLength = radio.receive(packet, sizeof(packet));
+    if (packetLength > 0) {
+        int rssi = radio.packetRssi();
+        float snr = radio.packetSnr();
+        uint32_t waitedMs = millis() - radio.packetTime();
+        METRIC_RECORD(ringLatency, waitedMs * 1000);
 
         Serial.println("\n--- Received LoRa Packet ---");
-        Serial.print("Raw message: ");
-        Serial.println(message);
-
-        DynamicJsonDocument doc(200);
-        DeserializationError error = deserializeJson(doc, message);
-
-        if (!error) {
-            // Update latest data with all fields from the submersible sensor packet
-            latestData.current = doc["current"].as<float>();  // Current in mA
-            latestData.waterDepth = doc["depth"].as<float>(); // Depth in cm
-            latestData.temperature = doc["temp"].as<float>(); // Temperature in °C
-            latestData.turbVoltage = doc["turb_v"].as<float>(); // Turbidity voltage
-            latestData.turbidity = doc["turb_ntu"].as<float>(); // Turbidity in NTU
-            latestData.rssi = LoRa.packetRssi();
-            latestData.isValid = true;
-            
-            // Debug output
-            Serial.println("Parsed Data:");
-            Serial.print("Current: ");
-            Serial.print(latestData.current);
-            Serial.println(" mA");
-            Serial.print("Water Depth: ");
-            Serial.print(latestData.waterDepth);
-            Serial.println(" cm");
-            Serial.print("Temperature: ");
-            Serial.print(latestData.temperature);
-            Serial.println(" °C");
-            Serial.print("Turbidity Voltage: ");
-            Serial.print(latestData.turbVoltage);
-            Serial.println(" V");
-            Serial.print("Turbidity: ");
-            Serial.print(latestData.turbidity);
-            Serial.println(" NTU");
-            Serial.print("RSSI: ");
-            Serial.print(latestData.rssi);
-            Serial.println(" dBm");
+
+        SensorData readings[FRAME_BATCH_MAX];
+        size_t readingCount = 0;
+        uint8_t slot = NODE_SLOT_NONE;
+        if (frameIsLegacyJson(packet, packetLength)) {
+            readingCount = decodeLegacyPacket(packet, packetLength, readings[0]) ? 1 : 0;
+            METRIC_SINCE(decodeLatency, receiveStart);
+            if (readingCount == 0) METRIC_COUNT(decodeErrors);
+            if (readingCount > 0) slot = nodes.touch(readings[0].nodeId, millis());
+        } else {
+            FrameHeader header;
+            readingCount = decodeBinaryPacket(packet, packetLength, header, readings, FRAME_BATCH_MAX, waitedMs / 100);
+            METRIC_SINCE(decodeLatency, receiveStart);
+            if (readingCount == 0) METRIC_COUNT(decodeErrors);
+            if (readingCount > 0) {
+                slot = nodes.touch(header.nodeId, millis());
+                
+                // A retransmission of a frame we already have is ACKed
+                // again, but its readings are not processed twice
+                METRIC_STAMP(downlinkStart);
+                bool fresh = gatewayLink.uplink(slot, header, rssi, snr, waitedMs, millis());
+                while (gatewayLink.service(millis())) delay(1);
+                METRIC_SINCE(downlinkLatency, downlinkStart);
+                if (!fresh) {
+                    Serial.print("Duplicate seq ");
+                    Serial.print(header.seq);
+                    Serial.println(" dropped");
+                    readingCount = 0;
+                }
+            }
+        }
+        lastUplinkRssi = rssi;
+
+        if (readingCount > 0) {
+            NodeState& node = nodes.at(slot);
+            METRIC_STAMP(displayStart);
+            for (size_t i = 0; i < readingCount; i++) {
+                // Update the node's latest data with all fields from the submersible sensor packet
+                node.latest = readings[i];
+                node.latest.rssi = rssi;
+                node.latest.isValid = true;
+                printReading(node.latest);
+                node.window.current.add(node.latest);
+                node.trend.add(trendColumn(currentMillis),
+                               frameScaleUnsigned(node.latest.waterDepth, 10),
+                               frameScaleUnsigned(node.latest.turbidity, 10));
+            }
             
-            // Update display
-            updateDisplay(latestData);
+            printLinkStats(node);
             
-            // Send to Firebase if it's time or first data
-            if (!firstDataSent || (currentMillis - lastFirebaseUpdate >= FIREBASE_UPDATE_INTERVAL)) {
-                if (Firebase.ready() && WiFi.status() == WL_CONNECTED) {
-                    Serial.println("Sending data to Firebase...");
-                    sendToFirebase(latestData);
-                    lastFirebaseUpdate = currentMillis;
-                    firstDataSent = true;
-                } else {
-                    Serial.println("Skipping Firebase upload - connection not ready");
-                    tft.fillRect(tft.width() - 10, 0, 10, 10, ERROR_COLOR);
-                }
+            // Update display if this node is on screen, or none is yet
+            if (displayedSlot == NODE_SLOT_NONE || displayedSlot == slot) {
+                showNode(slot);
             }
-        } else {
-            Serial.println("JSON parsing failed");
-            Serial.print("Error: ");
-            Serial.println(error.c_str());
-            Serial.print("Message: ");
-            Serial.println(message);
+            METRIC_SINCE(displayLatency, displayStart);
+            
+            // Close the node's window if it's time or its first data
+            closeWindow(node, currentMillis);
+        }
+    }
+    
+    // Close the windows of nodes that have gone quiet
+    if (currentMillis - lastWindowSweep >= WINDOW_SWEEP_MS) {
+        for (uint8_t slot = 0; slot < nodes.capacity(); slot++) {
+            if (nodes.used(slot)) closeWindow(nodes.at(slot), currentMillis);
         }
+        lastWindowSweep = currentMillis;
     }
 
+    // Lost contact with a node: meet it again on the safe profile
+    gatewayLink.service(millis());
+
     // Visual connection status indicator
-    if (WiFi.status() == WL_CONNECTED && Firebase.ready()) {
-        if (latestData.isValid && (currentMillis - lastFirebaseUpdate < FIREBASE_UPDATE_INTERVAL + 5000)) {
-            tft.fillRect(tft.width() - 10, 0, 10, 10, VALUE_COLOR); // Green when all good
+    if (WiFi.status() == WL_CONNECTED && firebaseReady) {
+        if (lastUploadAt != 0 && (currentMillis - lastUploadAt < FIREBASE_UPDATE_INTERVAL + 5000)) {
+            showStatus(VALUE_COLOR); // Green when all good
         } else {
-            tft.fillRect(tft.width() - 10, 0, 10, 10, SYNC_COLOR); // Magenta when connected but waiting
+            showStatus(SYNC_COLOR); // Magenta when connected but waiting
         }
     } else {
-        tft.fillRect(tft.width() - 10, 0, 10, 10, ERROR_COLOR); // Red when there's a connection issue
+        showStatus(ERROR_COLOR); // Red when there's a connection issue
     }
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+// Generated by tools/embed_web.py from web/index.html - do not edit.
+#ifndef INDEX_HTML_GZ_H
+#define INDEX_HTML_GZ_H
+
+#include <Arduino.h>
+
+const size_t INDEX_HTML_GZ_LEN = 2175;
+const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xbd, 0x19, 0xfd, 0x6f, 0xdb, 0x36,
+  0xf6, 0x77, 0xff, 0x15, 0x3c, 0x14, 0x77, 0xb2, 0x91, 0xc4, 0x76, 0x92, 0x1e, 0x3a, 0xf8, 0xeb,
+  0x90, 0xcb, 0x1a, 0xac, 0x77, 0x69, 0x57, 0x34, 0x5d, 0xf7, 0xc3, 0x50, 0x04, 0xb4, 0xf4, 0x6c,
+  0x73, 0xa5, 0x48, 0x4d, 0xa4, 0xe2, 0x66, 0x41, 0xfe, 0xf7, 0xbd, 0x47, 0x52, 0xb2, 0x24, 0xdb,
+  0x71, 0xba, 0x3b, 0x0c, 0x6d, 0x11, 0x8a, 0x7c, 0xdf, 0xdf, 0x2f, 0x9d, 0xac, 0x6c, 0x2a, 0x67,
+  0x93, 0x15, 0xf0, 0x64, 0xd6, 0x99, 0xa4, 0x60, 0x39, 0x53, 0x3c, 0x85, 0x69, 0x74, 0x27, 0x60,
+  0x9d, 0xe9, 0xdc, 0x46, 0x2c, 0xd6, 0xca, 0x82, 0xb2, 0xd3, 0x68, 0x2d, 0x12, 0xbb, 0x9a, 0x26,
+  0x70, 0x27, 0x62, 0x38, 0x71, 0x1f, 0xc7, 0x4c, 0x28, 0x61, 0x05, 0x97, 0x27, 0x26, 0xe6, 0x12,
+  0xa6, 0xa7, 0x11, 0x12, 0x31, 0xf6, 0x5e, 0xc2, 0xac, 0x33, 0xd7, 0xc9, 0xfd, 0xc3, 0x02, 0x71,
+  0x4f, 0x16, 0x3c, 0x15, 0xf2, 0x7e, 0x74, 0x91, 0x23, 0xe0, 0x38, 0xe5, 0xf9, 0x52, 0xa8, 0xd1,
+  0xd9, 0x30, 0xfb, 0x8a, 0xe7, 0xaf, 0x9e, 0xce, 0xe8, 0xbb, 0xa1, 0xff, 0x76, 0x6f, 0xbc, 0xb0,
+  0x7a, 0x9c, 0xf1, 0x24, 0x11, 0x6a, 0xe9, 0x00, 0x1f, 0x3b, 0xfd, 0x1c, 0x05, 0xc4, 0xcf, 0x87,
+  0x39, 0x8f, 0xbf, 0x2c, 0x73, 0x5d, 0xa8, 0x64, 0xf4, 0x62, 0x31, 0xa4, 0x3f, 0x0d, 0xc8, 0x3a,
+  0x79, 0x36, 0x1c, 0xcf, 0x75, 0x9e, 0x40, 0x7e, 0x92, 0x23, 0x6e, 0x61, 0x46, 0xdf, 0x39, 0x4a,
+  0xa8, 0xce, 0x42, 0x34, 0x09, 0xc1, 0x90, 0xfe, 0x7c, 0x23, 0x21, 0xcb, 0xe7, 0x12, 0x1e, 0xbc,
+  0xf8, 0xa7, 0xc3, 0xe1, 0xdf, 0x4b, 0x98, 0x58, 0x4b, 0xc9, 0x33, 0x03, 0xa3, 0xf2, 0x50, 0x92,
+  0x3a, 0x75, 0xa4, 0x10, 0x31, 0x39, 0xb6, 0xab, 0x87, 0x92, 0x19, 0xd2, 0x1a, 0x5b, 0xf8, 0x6a,
+  0x4f, 0xb8, 0x14, 0x4b, 0x35, 0x92, 0xb0, 0xb0, 0x81, 0xd2, 0xe8, 0x14, 0xe1, 0x8d, 0x96, 0x22,
+  0x61, 0x2f, 0x92, 0x24, 0x41, 0xd1, 0xe7, 0x85, 0xb5, 0x5a, 0xd5, 0x44, 0x27, 0x66, 0x3a, 0x1f,
+  0xbd, 0x78, 0x79, 0x79, 0x71, 0xf5, 0xcf, 0x52, 0xca, 0x91, 0xd2, 0x0a, 0xc6, 0xfe, 0x65, 0xbd,
+  0x12, 0x16, 0x2a, 0xc5, 0x9c, 0x04, 0x4e, 0xbb, 0x1a, 0xc7, 0x18, 0x7d, 0x0b, 0x79, 0x53, 0xc8,
+  0x71, 0x5c, 0xe4, 0x06, 0xd1, 0x33, 0x2d, 0xdc, 0x63, 0x53, 0xfd, 0x97, 0xce, 0x8e, 0x7c, 0x09,
+  0x0f, 0x81, 0xfd, 0xab, 0x57, 0xaf, 0xc6, 0xce, 0xd3, 0x46, 0xfc, 0x0e, 0x23, 0x93, 0x72, 0x29,
+  0x1f, 0x3b, 0x93, 0x41, 0x08, 0x84, 0x89, 0x89, 0x73, 0x91, 0xd9, 0x59, 0x67, 0x51, 0xa8, 0xd8,
+  0x0a, 0xad, 0x58, 0xae, 0xd7, 0x5d, 0xc9, 0xe7, 0x20, 0x8f, 0xd9, 0x1d, 0x97, 0x05, 0xf4, 0xd8,
+  0x43, 0x27, 0x07, 0x5b, 0xe4, 0x8a, 0x45, 0x13, 0x9b, 0xcf, 0x26, 0x36, 0x99, 0x45, 0xec, 0x88,
+  0x39, 0x18, 0xfc, 0x19, 0x4d, 0x06, 0x78, 0x53, 0xde, 0x3a, 0x94, 0xcd, 0xed, 0x00, 0x11, 0xa2,
+  0x71, 0xe7, 0xb1, 0x46, 0x1e, 0x14, 0x4a, 0xdb, 0x4d, 0x88, 0xec, 0x1d, 0xcf, 0x19, 0x85, 0x38,
+  0x9b, 0x3a, 0xae, 0xd1, 0x65, 0x91, 0xe3, 0xb3, 0x65, 0x1f, 0x7c, 0x3c, 0x8d, 0xa2, 0x63, 0x96,
+  0xf4, 0x63, 0x7f, 0xd9, 0xb7, 0xfa, 0x4a, 0x7c, 0x85, 0xa4, 0x7b, 0xd6, 0x23, 0xf2, 0x2c, 0xbd,
+  0x88, 0x7a, 0xe3, 0x8e, 0xc3, 0x3e, 0x0a, 0xe8, 0x3f, 0x73, 0x34, 0x07, 0xfb, 0x1e, 0x32, 0x74,
+  0xba, 0x43, 0x4d, 0xe8, 0x58, 0x21, 0x9e, 0x7a, 0xc4, 0x7f, 0x64, 0xb2, 0x30, 0xa9, 0x1a, 0x33,
+  0x12, 0x37, 0xc0, 0xdc, 0xc6, 0xa2, 0x4d, 0x3f, 0x4e, 0x59, 0x57, 0x4d, 0xeb, 0x30, 0x8a, 0xee,
+  0x7b, 0xc4, 0x75, 0xa1, 0x73, 0xd6, 0x25, 0xe1, 0x05, 0x4a, 0x3e, 0x1c, 0xe3, 0x8f, 0x09, 0x42,
+  0x59, 0x48, 0x33, 0xd3, 0x97, 0xa0, 0x96, 0x76, 0x85, 0x77, 0x47, 0x47, 0xa5, 0x8a, 0x16, 0xa1,
+  0xc2, 0xf3, 0x2f, 0xe2, 0x33, 0x9b, 0x4e, 0xa7, 0x4c, 0x15, 0x52, 0xb2, 0x7f, 0xb1, 0xe8, 0x75,
+  0x9e, 0xeb, 0x3c, 0x62, 0xa3, 0xda, 0xfb, 0x96, 0xbc, 0x09, 0x2c, 0xc7, 0x97, 0x51, 0x53, 0x57,
+  0x64, 0x8c, 0x9c, 0x89, 0xc2, 0x47, 0x44, 0x83, 0x9c, 0xa3, 0x7f, 0x60, 0x44, 0x84, 0xea, 0x17,
+  0x4e, 0x45, 0x84, 0x3d, 0x62, 0x9e, 0x16, 0x59, 0xc5, 0xf6, 0xc8, 0x1d, 0x62, 0xc1, 0xba, 0x4d,
+  0x89, 0x1d, 0xc1, 0x1e, 0x6b, 0x18, 0xb4, 0x41, 0xfb, 0x98, 0x45, 0xef, 0x34, 0xcb, 0x72, 0x3d,
+  0x87, 0x2d, 0xcb, 0x7f, 0x2c, 0xf2, 0xb9, 0x48, 0x84, 0xbd, 0xf7, 0x76, 0x47, 0x84, 0xf9, 0xad,
+  0xb2, 0xc5, 0x01, 0xd3, 0x3b, 0xb0, 0x6d, 0xcb, 0xbf, 0xfb, 0xf8, 0xd3, 0xc6, 0xf4, 0x9e, 0x14,
+  0xdd, 0x1f, 0xb3, 0x4f, 0x5a, 0x5a, 0x0c, 0xec, 0x51, 0x1d, 0xfd, 0xae, 0xc2, 0x3e, 0x77, 0xd8,
+  0x9f, 0x7a, 0x5b, 0xc2, 0x5d, 0x4a, 0x40, 0x27, 0xf8, 0xe0, 0x28, 0x49, 0xf8, 0xc8, 0xa2, 0x87,
+  0xdb, 0x35, 0x3d, 0x6c, 0xd3, 0x21, 0x32, 0xde, 0x4a, 0x0b, 0x21, 0x11, 0x82, 0x9c, 0xd9, 0x20,
+  0x7b, 0xe5, 0xae, 0xd9, 0x1b, 0x95, 0x15, 0xd6, 0xd3, 0xf3, 0x80, 0x21, 0xea, 0x04, 0xdd, 0xb7,
+  0x0d, 0x10, 0xa7, 0xce, 0x23, 0x2d, 0xd0, 0x25, 0x4a, 0x90, 0x90, 0x2f, 0x59, 0xd7, 0x1d, 0x7b,
+  0xce, 0x8f, 0x11, 0xa2, 0x74, 0xc8, 0xea, 0x4e, 0xd9, 0x80, 0x60, 0x4b, 0x43, 0xef, 0xa6, 0x8f,
+  0xa6, 0x6b, 0x32, 0xd8, 0xc0, 0x1f, 0x66, 0xd2, 0x16, 0x2b, 0x87, 0x5f, 0x21, 0x26, 0xa4, 0x9d,
+  0xfc, 0xcb, 0x57, 0xcf, 0xb8, 0xfc, 0x8a, 0x6a, 0xd1, 0x25, 0x85, 0xfa, 0xb2, 0x65, 0xb5, 0x6b,
+  0xfd, 0x81, 0xb3, 0x6b, 0x7c, 0xf1, 0x26, 0x23, 0x98, 0x3e, 0x56, 0x4c, 0xc7, 0x25, 0x1a, 0x78,
+  0x5d, 0xdd, 0xa5, 0xa1, 0x42, 0x40, 0xa4, 0xdd, 0xab, 0x93, 0xb0, 0x13, 0x9e, 0xb0, 0x1a, 0xe5,
+  0x02, 0x4c, 0x60, 0xec, 0xce, 0xa5, 0x99, 0xdc, 0xbb, 0xd4, 0xc6, 0xa3, 0xd2, 0xa1, 0x2e, 0x11,
+  0x17, 0xb9, 0x15, 0x29, 0x6c, 0x09, 0x75, 0xe1, 0xef, 0x49, 0xa4, 0x0d, 0x54, 0x7f, 0x2d, 0x54,
+  0xa2, 0xd7, 0xb7, 0xa9, 0x61, 0x03, 0x86, 0x3d, 0x64, 0xd8, 0x6b, 0x5b, 0xdb, 0x60, 0x83, 0x65,
+  0x76, 0x05, 0x58, 0x0a, 0x91, 0xe1, 0x4a, 0x17, 0x39, 0x09, 0x59, 0xa3, 0x20, 0x45, 0x2a, 0x2c,
+  0x11, 0xa8, 0xa7, 0xbc, 0xb3, 0x3b, 0xd3, 0x8b, 0xd2, 0xe6, 0x5b, 0xc0, 0x6d, 0x6e, 0xc3, 0xc0,
+  0xad, 0x19, 0x10, 0x25, 0xda, 0x22, 0xc7, 0x89, 0xc0, 0xdb, 0xc2, 0x1f, 0xdb, 0x00, 0x09, 0x2c,
+  0x00, 0x2b, 0xa8, 0x33, 0x30, 0x2b, 0x3f, 0xea, 0x56, 0xc1, 0xf1, 0x22, 0xdb, 0x32, 0xc9, 0x0f,
+  0x78, 0xe9, 0x5d, 0x44, 0xcf, 0xc8, 0x05, 0x20, 0xf0, 0x00, 0x28, 0x39, 0xb8, 0x97, 0x54, 0xa8,
+  0xdb, 0xea, 0x15, 0x3f, 0x44, 0x5a, 0xa4, 0xa5, 0xb7, 0x1c, 0x80, 0xc4, 0xde, 0x05, 0xa5, 0x43,
+  0xc2, 0x79, 0x2e, 0x75, 0xfc, 0xc5, 0xcb, 0x90, 0xe8, 0xb8, 0x48, 0xa9, 0xbe, 0x2f, 0xc1, 0xbe,
+  0x96, 0x40, 0xc7, 0x7f, 0xdf, 0xbf, 0x49, 0xba, 0x91, 0xeb, 0x24, 0xa8, 0x34, 0x46, 0xba, 0x82,
+  0xfc, 0x87, 0x8f, 0x6f, 0xaf, 0xb1, 0x8c, 0x92, 0x8c, 0xe3, 0xfd, 0x38, 0x98, 0xda, 0x88, 0x40,
+  0xfd, 0xf3, 0xd2, 0xcf, 0x45, 0x88, 0x12, 0xfd, 0x94, 0x25, 0x2e, 0xf6, 0x4b, 0x7b, 0x2f, 0xe1,
+  0x49, 0x9f, 0xf2, 0xa5, 0x8e, 0x9e, 0x60, 0x11, 0xda, 0x51, 0x28, 0x24, 0x5b, 0xdc, 0xf6, 0x95,
+  0x25, 0x24, 0x49, 0xad, 0x20, 0xe5, 0xaa, 0xe0, 0xd4, 0xef, 0xf6, 0xd3, 0xa7, 0xa2, 0xe4, 0x8a,
+  0x55, 0x59, 0x81, 0xfe, 0xe6, 0x91, 0xfa, 0xa1, 0x1b, 0xd7, 0xbf, 0x1c, 0xc3, 0x7d, 0x65, 0xac,
+  0xd1, 0x76, 0x0b, 0x67, 0x84, 0xd0, 0x58, 0x4d, 0x97, 0xfc, 0xbd, 0x00, 0x1b, 0xaf, 0xba, 0xd1,
+  0x80, 0x67, 0x62, 0x10, 0x26, 0x38, 0x34, 0x77, 0xa7, 0x8f, 0x11, 0xad, 0xba, 0x25, 0x62, 0x37,
+  0x07, 0x93, 0x69, 0x65, 0x28, 0x69, 0x58, 0x18, 0x03, 0xca, 0xab, 0xfe, 0xaf, 0x06, 0x01, 0x7a,
+  0x63, 0xf6, 0xb8, 0x85, 0x45, 0xed, 0x9d, 0x39, 0xe1, 0x93, 0x3e, 0x50, 0x8f, 0xeb, 0x6d, 0x1a,
+  0x3f, 0xc1, 0xef, 0x18, 0x09, 0xb0, 0xf9, 0xdf, 0x41, 0x97, 0xe6, 0xdb, 0x63, 0x16, 0xd3, 0xb9,
+  0x35, 0x21, 0x84, 0xe1, 0x63, 0x85, 0x23, 0xaf, 0x34, 0x19, 0x57, 0xd3, 0x33, 0x37, 0x70, 0x10,
+  0x82, 0xf3, 0x5c, 0x97, 0xbe, 0x1c, 0x22, 0x16, 0x2b, 0x4b, 0x89, 0xb8, 0xf9, 0xc0, 0xf4, 0x8b,
+  0x32, 0x2d, 0xef, 0x95, 0x4e, 0x71, 0xcc, 0x8d, 0x28, 0x0d, 0x31, 0xb4, 0x61, 0x49, 0x71, 0xbb,
+  0x41, 0x0b, 0x17, 0xa1, 0x2c, 0x62, 0xaf, 0xc7, 0xf1, 0x65, 0x55, 0xcd, 0x30, 0xbb, 0x9a, 0xbe,
+  0xc7, 0x73, 0x83, 0xd8, 0x56, 0xe7, 0x6f, 0xa4, 0xd3, 0x07, 0xbe, 0xae, 0x31, 0xf2, 0x08, 0xd8,
+  0xeb, 0x7f, 0x19, 0x7e, 0x3e, 0xde, 0xba, 0x3b, 0xfd, 0x5c, 0x25, 0xe7, 0x0e, 0xfa, 0xc8, 0xf5,
+  0xac, 0xd5, 0xa6, 0xdf, 0xbb, 0x77, 0xca, 0xd6, 0x5d, 0xf0, 0xce, 0x36, 0x06, 0x9d, 0x2b, 0xe1,
+  0xc4, 0xbd, 0x30, 0xdc, 0x06, 0xc4, 0x1c, 0xdb, 0x3a, 0xd9, 0x1e, 0x2b, 0x58, 0x81, 0xce, 0xa5,
+  0x58, 0x0b, 0xde, 0xf5, 0x29, 0xf6, 0xd8, 0x08, 0x8f, 0x1a, 0xc6, 0xff, 0x2b, 0x42, 0x62, 0xb2,
+  0xd1, 0xde, 0x2c, 0xf0, 0x2a, 0x34, 0x93, 0xbf, 0x53, 0x8f, 0x93, 0xc8, 0x8d, 0x79, 0x68, 0xa1,
+  0xb4, 0x47, 0x7a, 0xfb, 0x96, 0x45, 0x5e, 0x6b, 0x00, 0x55, 0x73, 0x09, 0xeb, 0x62, 0x6b, 0xf4,
+  0x90, 0x55, 0x0b, 0x23, 0x2b, 0xe3, 0xbf, 0xc1, 0x00, 0xfb, 0xd1, 0x1d, 0x30, 0x63, 0x31, 0x09,
+  0x52, 0x2c, 0x70, 0x3a, 0x65, 0x03, 0xb8, 0x43, 0x51, 0xcc, 0x98, 0x61, 0xd0, 0x60, 0x4b, 0x59,
+  0x32, 0xad, 0xe4, 0x3d, 0x5b, 0xa3, 0x02, 0xae, 0xde, 0xcf, 0xd1, 0xec, 0x06, 0x7b, 0xff, 0x8a,
+  0x1b, 0xa6, 0x34, 0x51, 0x78, 0x4d, 0xf0, 0x37, 0xd8, 0x01, 0x62, 0x60, 0x18, 0x27, 0x04, 0xa4,
+  0x74, 0x02, 0x01, 0xc2, 0x55, 0xcd, 0x92, 0x81, 0x91, 0xda, 0x6e, 0x62, 0xdf, 0x58, 0x9e, 0xdb,
+  0xf7, 0x9e, 0x8b, 0xcb, 0x4a, 0x03, 0xf6, 0x0d, 0x8d, 0xf5, 0x98, 0xdf, 0xdd, 0x66, 0xd2, 0x1e,
+  0xe3, 0x76, 0x80, 0x15, 0x8b, 0x7c, 0xd3, 0xce, 0x66, 0x5f, 0x28, 0x7c, 0xc3, 0xea, 0xd7, 0x64,
+  0x29, 0x53, 0xc8, 0x78, 0xc9, 0xb0, 0x09, 0xc1, 0xba, 0x2e, 0x2b, 0xba, 0xd7, 0x6b, 0x4a, 0xfe,
+  0xf7, 0x40, 0x7d, 0x5c, 0x47, 0x1c, 0xc4, 0xb5, 0x30, 0x58, 0xd3, 0x30, 0x63, 0xa3, 0x50, 0x1c,
+  0xd0, 0x7a, 0x95, 0xf7, 0x82, 0xb3, 0x5d, 0x46, 0xff, 0xe7, 0xe6, 0xc7, 0x77, 0xfd, 0x8c, 0xe7,
+  0x06, 0xba, 0x98, 0x43, 0xdc, 0xf2, 0x5e, 0x48, 0xf1, 0x40, 0x10, 0x17, 0x1e, 0xaa, 0x00, 0xc8,
+  0xbd, 0x42, 0x27, 0xb9, 0x48, 0xe2, 0x00, 0x41, 0x0c, 0xee, 0x6f, 0x2c, 0xaa, 0x44, 0x99, 0x5a,
+  0x93, 0xaf, 0x7f, 0x79, 0xfd, 0xe3, 0xcd, 0xeb, 0xef, 0x7b, 0x2d, 0x33, 0xa1, 0x09, 0xf0, 0x2f,
+  0x03, 0x69, 0x80, 0x2c, 0xd6, 0x7e, 0xa3, 0xed, 0x26, 0x6c, 0x35, 0x93, 0x81, 0x5b, 0x9e, 0x27,
+  0xb4, 0xef, 0xe2, 0xd7, 0xea, 0x6c, 0xe6, 0xe7, 0xc0, 0x6b, 0x54, 0x5b, 0xb2, 0xb7, 0x1a, 0x17,
+  0x64, 0x9d, 0x93, 0x83, 0x6f, 0xee, 0x51, 0xdb, 0x14, 0xc1, 0xcf, 0x10, 0x2c, 0x11, 0x77, 0x2c,
+  0xc6, 0xa6, 0x6e, 0xa6, 0x95, 0xee, 0x84, 0x7c, 0x3e, 0x6b, 0x2d, 0x28, 0x06, 0xe1, 0xcf, 0xf1,
+  0xc5, 0x6d, 0x9b, 0x4c, 0x24, 0xd3, 0xb2, 0x69, 0x51, 0xd1, 0xa0, 0x3b, 0xda, 0xaf, 0xb0, 0x54,
+  0xb9, 0x27, 0xea, 0x16, 0x25, 0x55, 0x3a, 0x23, 0x0c, 0xbd, 0x91, 0x8c, 0xc8, 0xaf, 0xc9, 0xd5,
+  0xaf, 0xc1, 0x81, 0xa9, 0x8f, 0xf4, 0x1b, 0x50, 0xb8, 0xf4, 0xb1, 0xcb, 0x4d, 0x26, 0x06, 0xe6,
+  0x58, 0x97, 0x52, 0x1c, 0x92, 0xe8, 0x66, 0x1a, 0x55, 0x99, 0x8a, 0xbc, 0x52, 0xb0, 0x2b, 0x8d,
+  0x8c, 0x33, 0x9a, 0x82, 0x4a, 0x29, 0xe9, 0xa7, 0xdf, 0xe1, 0xfe, 0xab, 0xf4, 0x5a, 0xb1, 0x4d,
+  0x1a, 0x8d, 0xaa, 0x3d, 0x6e, 0xe2, 0x66, 0x4b, 0x66, 0xef, 0x33, 0x98, 0x46, 0xaa, 0x48, 0xe7,
+  0xd8, 0x8b, 0xd0, 0x03, 0x90, 0x4d, 0xa3, 0x61, 0xff, 0x34, 0x0a, 0xbf, 0x83, 0xf8, 0x42, 0xf8,
+  0xb7, 0x2e, 0xef, 0x68, 0x0c, 0xfb, 0xad, 0x10, 0x38, 0x57, 0xcc, 0x36, 0x6b, 0x5f, 0xc5, 0xa8,
+  0x34, 0x1a, 0xb7, 0x25, 0xb7, 0xf4, 0xe2, 0xb9, 0xdc, 0x86, 0x2d, 0x76, 0xa1, 0xfb, 0xee, 0x61,
+  0x58, 0x19, 0xbd, 0x4e, 0xd2, 0x14, 0x73, 0x1c, 0xac, 0x22, 0xbf, 0x99, 0x4e, 0xc3, 0x34, 0x10,
+  0x24, 0xa9, 0x59, 0xb3, 0xf2, 0x8d, 0xdf, 0xe3, 0xc9, 0x60, 0x03, 0x32, 0xed, 0xec, 0x90, 0x7b,
+  0x36, 0x35, 0x66, 0xdb, 0x37, 0x59, 0xa5, 0x7c, 0x98, 0x17, 0xaa, 0xd5, 0x96, 0x6d, 0x02, 0xa3,
+  0x35, 0x51, 0x94, 0x71, 0x31, 0x19, 0x64, 0x81, 0xab, 0x5b, 0xd5, 0xa7, 0x51, 0xe3, 0x97, 0x1e,
+  0x8e, 0xf9, 0xcb, 0xd9, 0x45, 0x61, 0x75, 0x8a, 0x1c, 0xe3, 0x16, 0xf3, 0x97, 0xfb, 0x03, 0xe3,
+  0xb6, 0x2a, 0x80, 0xdb, 0x21, 0xf2, 0x84, 0xdd, 0x6e, 0xc0, 0xb2, 0xca, 0x93, 0x86, 0xd5, 0x96,
+  0xaa, 0x67, 0x59, 0xee, 0x09, 0x1d, 0xde, 0xfa, 0x99, 0xe8, 0x4f, 0x28, 0x70, 0xeb, 0x67, 0xa1,
+  0x83, 0xa1, 0xbe, 0x63, 0x03, 0x64, 0xdd, 0x4f, 0xcf, 0x8e, 0x41, 0x0a, 0x42, 0xe7, 0xa8, 0xcd,
+  0x68, 0x16, 0x82, 0xb2, 0x31, 0x7a, 0x05, 0xff, 0xfd, 0xf9, 0xd0, 0x24, 0x13, 0x07, 0x63, 0x94,
+  0xc1, 0x70, 0xc8, 0xb4, 0x07, 0x62, 0xf3, 0x6d, 0x21, 0xad, 0x08, 0x5d, 0x7f, 0x57, 0x74, 0xfe,
+  0x2c, 0x30, 0x09, 0xec, 0x5a, 0x53, 0xcf, 0x4a, 0x75, 0x0e, 0xcc, 0xf7, 0x5d, 0xc6, 0x59, 0xbc,
+  0xe2, 0xd8, 0x79, 0x25, 0x0d, 0x07, 0xc6, 0xb5, 0x33, 0x1c, 0xa3, 0x68, 0x88, 0x76, 0x13, 0x06,
+  0x4e, 0x0d, 0x68, 0x1c, 0x9e, 0xd0, 0x16, 0x43, 0x6f, 0x7b, 0xa7, 0x0b, 0x3e, 0xd7, 0x38, 0x8f,
+  0xf8, 0x48, 0xde, 0x14, 0xc9, 0xd0, 0xdc, 0x6b, 0x45, 0x92, 0x22, 0x39, 0x49, 0x98, 0x1b, 0x64,
+  0xa8, 0x4e, 0xb4, 0xea, 0xec, 0x81, 0x78, 0x70, 0xf4, 0x0e, 0x07, 0x81, 0xd7, 0xa8, 0xe6, 0x74,
+  0x03, 0x12, 0x97, 0xd6, 0xd2, 0x95, 0xfe, 0x19, 0xa5, 0xd2, 0x99, 0x93, 0x3d, 0x38, 0xc5, 0x17,
+  0xb8, 0xd9, 0xa6, 0x4e, 0x4e, 0x06, 0x1e, 0xa0, 0x0d, 0xb8, 0x49, 0xab, 0x59, 0x6b, 0xec, 0xd8,
+  0x60, 0x0c, 0x3c, 0xcb, 0x5d, 0x55, 0xf2, 0x03, 0x6d, 0x66, 0xa0, 0xb0, 0x4b, 0x7f, 0x22, 0x7a,
+  0xdf, 0x5c, 0x1f, 0x9d, 0x14, 0xff, 0x43, 0xf0, 0x55, 0xf6, 0xdf, 0x1b, 0x73, 0xce, 0x4d, 0x6e,
+  0xb0, 0x62, 0x57, 0xc2, 0x1e, 0xf0, 0xc9, 0x42, 0xfc, 0x25, 0x1e, 0xf9, 0x16, 0x67, 0x3c, 0xcb,
+  0x0d, 0xa8, 0xd9, 0x3e, 0x79, 0x48, 0xa5, 0x36, 0x9f, 0x4c, 0x40, 0x0c, 0x6b, 0x61, 0xb0, 0x6c,
+  0xbf, 0x2f, 0x8f, 0x0c, 0x07, 0x11, 0x2c, 0x0b, 0xfb, 0x44, 0xa3, 0x3d, 0xe4, 0x0c, 0xc1, 0xab,
+  0x75, 0xa4, 0xda, 0x44, 0xce, 0x9e, 0x42, 0x39, 0xdf, 0x89, 0x72, 0xfe, 0xb4, 0x52, 0xcf, 0xad,
+  0x3a, 0x57, 0xe2, 0x90, 0xdb, 0x5d, 0x05, 0xf5, 0x8b, 0xc6, 0x01, 0xcf, 0xe3, 0xec, 0x0f, 0x3b,
+  0x7c, 0xff, 0x17, 0xbb, 0xf6, 0x49, 0x95, 0x9d, 0x36, 0x4f, 0x28, 0x5c, 0x16, 0x57, 0x37, 0x35,
+  0xa2, 0xba, 0xf4, 0xbf, 0x30, 0x7f, 0x00, 0x74, 0x3c, 0x93, 0x68, 0x8c, 0x19, 0x00, 0x00,
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "AcquisitionEngine.h"
+#include <math.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "esp_timer.h"
+
+uint16_t ArduinoAdcSource::read(uint8_t pin) {
+  return analogRead(pin);
+}
+
+// esp_timer is driven by a hardware timer and dispatches callbacks from its
+// own high-priority task, where analogRead() is safe to call.
+static void acquisitionTimerCallback(void* arg) {
+  static_cast<AcquisitionEngine*>(arg)->sampleTick();
+}
+#endif
+
+AcquisitionEngine::AcquisitionEngine(AdcSource& adc)
+  : _adc(adc), _numChannels(0), _periodUs(0), _timer(nullptr) {
+  for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+    _channels[i].pin = 0;
+    _channels[i].head.store(0);
+  }
+}
+
+int AcquisitionEngine::addChannel(uint8_t pin) {
+  if (_numChannels >= MAX_CHANNELS) return -1;
+  _channels[_numChannels].pin = pin;
+  _channels[_numChannels].head.store(0);
+  return _numChannels++;
+}
+
+bool AcquisitionEngine::begin(uint32_t samplePeriodUs) {
+  _periodUs = samplePeriodUs;
+#ifdef ARDUINO
+  if (_timer) return true;
+
+  esp_timer_create_args_t args = {};
+  args.callback = acquisitionTimerCallback;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "acq";
+
+  esp_timer_handle_t handle;
+  if (esp_timer_create(&args, &handle) != ESP_OK) return false;
+  if (esp_timer_start_periodic(handle, samplePeriodUs) != ESP_OK) {
+    esp_timer_delete(handle);
+    return false;
+  }
+  _timer = handle;
+#endif
+  return true;
+}
+
+void AcquisitionEngine::end() {
+#ifdef ARDUINO
+  if (_timer) {
+    esp_timer_handle_t handle = static_cast<esp_timer_handle_t>(_timer);
+    esp_timer_stop(handle);
+    esp_timer_delete(handle);
+    _timer = nullptr;
+  }
+#endif
+}
+
+void AcquisitionEngine::sampleTick() {
+  for (uint8_t i = 0; i < _numChannels; i++) {
+    Channel& ch = _channels[i];
+    uint32_t head = ch.head.load(std::memory_order_relaxed);
+    ch.ring[head & (RING_SIZE - 1)] = _adc.read(ch.pin);
+    ch.head.store(head + 1, std::memory_order_release);
+  }
+}
+
+uint32_t AcquisitionEngine::sampleCount(uint8_t channel) const {
+  if (channel >= _numChannels) return 0;
+  return _channels[channel].head.load(std::memory_order_acquire);
+}
+
+uint16_t AcquisitionEngine::latest(uint8_t channel, uint16_t n, uint16_t* out) const {
+  if (channel >= _numChannels) return 0;
+  const Channel& ch = _channels[channel];
+  if (n > RING_SIZE / 2) n = RING_SIZE / 2;
+
+  // Retry if the producer lapped the slots we were copying. At exactly
+  // RING_SIZE ahead it may be writing the slot at start.
+  for (;;) {
+    uint32_t head = ch.head.load(std::memory_order_acquire);
+    uint16_t count = head < n ? head : n;
+    uint32_t start = head - count;
+    for (uint16_t i = 0; i < count; i++) {
+      out[i] = ch.ring[(start + i) & (RING_SIZE - 1)];
+    }
+    uint32_t after = ch.head.load(std::memory_order_acquire);
+    if (after - start < RING_SIZE) return count;
+  }
+}
+
+uint16_t AcquisitionEngine::mean(uint8_t channel, uint16_t n, float& out) const {
+  uint16_t samples[RING_SIZE / 2];
+  uint16_t count = latest(channel, n, samples);
+  if (count == 0) return 0;
+
+  uint32_t sum = 0;
+  for (uint16_t i = 0; i < count; i++) sum += samples[i];
+  out = sum / (float)count;
+  return count;
+}
+
+// Two-sided 95% Student t for 1..10 degrees of freedom; normal beyond
+static float t95(uint16_t dof) {
+  static const float table[] = { 12.71f, 4.30f, 3.18f, 2.78f, 2.57f, 2.45f, 2.36f, 2.31f, 2.26f, 2.23f };
+  if (dof == 0) return 0;
+  return dof <= 10 ? table[dof - 1] : 1.96f;
+}
+
+bool AcquisitionEngine::adaptiveMean(uint8_t channel, uint16_t minN, uint16_t maxN,
+                                     float tolerance, AdaptiveMean& out) const {
+  uint16_t samples[RING_SIZE / 2];
+  uint16_t count = latest(channel, maxN, samples);
+  if (minN < 2) minN = 2;
+
+  out.mean = 0;
+  out.stdError = 0;
+  out.ci95 = 0;
+  out.samples = 0;
+  out.converged = false;
+  if (count == 0) return false;
+
+  // Welford's running mean and variance, newest sample first
+  double mean = 0;
+  double m2 = 0;
+  uint16_t n = 0;
+  while (n < count) {
+    double x = samples[count - 1 - n];
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+
+    if (n >= minN && m2 / (n - 1) / n <= (double)tolerance * tolerance) {
+      out.converged = true;
+      break;
+    }
+  }
+
+  out.mean = mean;
+  out.samples = n;
+  out.stdError = n > 1 ? sqrt(m2 / (n - 1) / n) : 0;
+  out.ci95 = t95(n - 1) * out.stdError;
+  return out.converged;
+}
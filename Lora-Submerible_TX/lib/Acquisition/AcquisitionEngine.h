@@ -0,0 +1,74 @@
+#ifndef ACQUISITION_ENGINE_H
+#define ACQUISITION_ENGINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "AdcSource.h"
+
+// Result of AcquisitionEngine::adaptiveMean(), in ADC counts.
+struct AdaptiveMean {
+  float mean;
+  float stdError;      // standard error of the mean
+  float ci95;          // half-width of the 95% confidence interval
+  uint16_t samples;
+  bool converged;      // stdError reached the tolerance
+};
+
+// Background ADC acquisition. A periodic timer calls sampleTick(), which
+// reads every registered channel once (interleaved) and appends the result
+// to that channel's ring buffer. Readers only look at the rings, so they
+// never wait on the ADC.
+//
+// Single producer (the timer callback), any number of readers.
+class AcquisitionEngine {
+public:
+  static const uint8_t MAX_CHANNELS = 2;
+  static const uint16_t RING_SIZE = 256;   // samples per channel, power of two
+
+  explicit AcquisitionEngine(AdcSource& adc);
+
+  // Register a pin before begin(). Returns the channel index, or -1 if full.
+  int addChannel(uint8_t pin);
+
+  // Start periodic sampling. On the host there is no timer; call
+  // sampleTick() directly instead.
+  bool begin(uint32_t samplePeriodUs);
+  void end();
+
+  // One interleaved sweep over all channels.
+  void sampleTick();
+
+  // Total samples ever written to a channel (wraps at 2^32).
+  uint32_t sampleCount(uint8_t channel) const;
+
+  // Copy up to n of the newest samples, oldest first. Returns the number
+  // copied, which is less than n while the ring is still filling.
+  uint16_t latest(uint8_t channel, uint16_t n, uint16_t* out) const;
+
+  // Mean of up to n newest samples. Returns the number of samples used.
+  uint16_t mean(uint8_t channel, uint16_t n, float& out) const;
+
+  // Mean of the newest samples, walking back until the standard error
+  // falls to tolerance (ADC counts) or maxN samples are used, and never
+  // fewer than minN. Quiet signals stop early; noisy ones use more.
+  // Returns false while the tolerance was not reached.
+  bool adaptiveMean(uint8_t channel, uint16_t minN, uint16_t maxN, float tolerance,
+                    AdaptiveMean& out) const;
+
+  uint32_t samplePeriodUs() const { return _periodUs; }
+
+private:
+  struct Channel {
+    uint8_t pin;
+    uint16_t ring[RING_SIZE];
+    std::atomic<uint32_t> head;
+  };
+
+  AdcSource& _adc;
+  Channel _channels[MAX_CHANNELS];
+  uint8_t _numChannels;
+  uint32_t _periodUs;
+  void* _timer;
+};
+
+#endif
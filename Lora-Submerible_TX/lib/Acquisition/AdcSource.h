@@ -0,0 +1,21 @@
+#ifndef ADC_SOURCE_H
+#define ADC_SOURCE_H
+
+#include <stdint.h>
+
+// Minimal ADC hardware abstraction used by the acquisition engine.
+// The firmware uses ArduinoAdcSource; host builds substitute a fake.
+class AdcSource {
+public:
+  virtual ~AdcSource() {}
+  virtual uint16_t read(uint8_t pin) = 0;
+};
+
+#ifdef ARDUINO
+class ArduinoAdcSource : public AdcSource {
+public:
+  uint16_t read(uint8_t pin) override;
+};
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+#include "Calibration.h"
+#include <math.h>
+#include <string.h>
+
+void CalibrationCurve::clear() {
+  memset(_points, 0, sizeof(_points));
+  _count = 0;
+  _fit = FIT_PIECEWISE;
+  _degree = 0;
+}
+
+bool CalibrationCurve::addPoint(uint16_t raw, float value) {
+  uint8_t i = 0;
+  while (i < _count && _points[i].raw < raw) i++;
+
+  if (i < _count && _points[i].raw == raw) {
+    _points[i].value = value;
+    return true;
+  }
+  if (_count >= MAX_POINTS) return false;
+
+  memmove(&_points[i + 1], &_points[i], (_count - i) * sizeof(Point));
+  _points[i].raw = raw;
+  _points[i].value = value;
+  _count++;
+  return true;
+}
+
+void CalibrationCurve::setFit(Fit fit, uint8_t degree) {
+  _fit = fit;
+  if (degree < 1) degree = 1;
+  if (degree > MAX_DEGREE) degree = MAX_DEGREE;
+  _degree = degree;
+}
+
+bool CalibrationCurve::valid() const {
+  if (_count > MAX_POINTS) return false;
+  if (_fit != FIT_PIECEWISE && _fit != FIT_POLYNOMIAL) return false;
+  if (_degree > MAX_DEGREE) return false;
+  if (_fit == FIT_POLYNOMIAL && _degree < 1) return false;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (isnan(_points[i].value) || isinf(_points[i].value)) return false;
+    if (i > 0 && _points[i].raw <= _points[i - 1].raw) return false;
+  }
+  return true;
+}
+
+float CalibrationCurve::evaluate(float raw) const {
+  if (_count == 0) return 0;
+  if (_count == 1) return _points[0].value;
+
+  if (_fit == FIT_POLYNOMIAL) {
+    double c[MAX_DEGREE + 1];
+    uint8_t degree;
+    if (solvePolynomial(c, degree)) {
+      // Fitted on raw / 4095 to keep the normal equations well conditioned
+      double x = raw / 4095.0;
+      double y = 0;
+      for (int8_t k = degree; k >= 0; k--) y = y * x + c[k];
+      return (float)y;
+    }
+  }
+
+  uint8_t i = 1;
+  while (i < _count - 1 && raw > _points[i].raw) i++;
+  const Point& a = _points[i - 1];
+  const Point& b = _points[i];
+  return a.value + (raw - a.raw) * (b.value - a.value) / (float)(b.raw - a.raw);
+}
+
+bool CalibrationCurve::solvePolynomial(double* c, uint8_t& degree) const {
+  degree = _degree < _count - 1 ? _degree : _count - 1;
+  uint8_t n = degree + 1;
+
+  // Normal equations A c = r, solved by Gaussian elimination
+  double a[MAX_DEGREE + 1][MAX_DEGREE + 2];
+  memset(a, 0, sizeof(a));
+  for (uint8_t p = 0; p < _count; p++) {
+    double x = _points[p].raw / 4095.0;
+    double powers[2 * MAX_DEGREE + 1];
+    powers[0] = 1;
+    for (uint8_t k = 1; k <= 2 * degree; k++) powers[k] = powers[k - 1] * x;
+    for (uint8_t row = 0; row < n; row++) {
+      for (uint8_t col = 0; col < n; col++) a[row][col] += powers[row + col];
+      a[row][n] += powers[row] * _points[p].value;
+    }
+  }
+
+  for (uint8_t col = 0; col < n; col++) {
+    uint8_t pivot = col;
+    for (uint8_t row = col + 1; row < n; row++) {
+      if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+    }
+    if (fabs(a[pivot][col]) < 1e-12) return false;
+    if (pivot != col) {
+      for (uint8_t k = 0; k <= n; k++) {
+        double t = a[col][k];
+        a[col][k] = a[pivot][k];
+        a[pivot][k] = t;
+      }
+    }
+    for (uint8_t row = 0; row < n; row++) {
+      if (row == col) continue;
+      double f = a[row][col] / a[col][col];
+      for (uint8_t k = col; k <= n; k++) a[row][k] -= f * a[col][k];
+    }
+  }
+  for (uint8_t k = 0; k < n; k++) c[k] = a[k][n] / a[k][k];
+  return true;
+}
+
+CalibrationTable::CalibrationTable() {
+  memset(_table, 0, sizeof(_table));
+}
+
+void CalibrationTable::compile(const CalibrationCurve& curve, float minValue, float maxValue) {
+  for (uint16_t i = 0; i < ENTRIES; i++) {
+    float v = curve.evaluate((float)(i << SEGMENT_BITS));
+    if (v < minValue) v = minValue;
+    if (v > maxValue) v = maxValue;
+    _table[i] = (int32_t)lroundf(v * SCALE);
+  }
+}
+
+int32_t CalibrationTable::lookup(uint32_t rawQ4) const {
+  const uint8_t shift = SEGMENT_BITS + RAW_FRACTION_BITS;
+  uint32_t index = rawQ4 >> shift;
+  if (index >= ENTRIES - 1) return _table[ENTRIES - 1];
+
+  int32_t frac = rawQ4 & ((1 << shift) - 1);
+  int32_t a = _table[index];
+  int32_t b = _table[index + 1];
+  return a + (int32_t)(((int64_t)(b - a) * frac) >> shift);
+}
+
+float CalibrationTable::value(float raw) const {
+  if (raw < 0) raw = 0;
+  return lookup((uint32_t)(raw * (1 << RAW_FRACTION_BITS) + 0.5f)) / (float)SCALE;
+}
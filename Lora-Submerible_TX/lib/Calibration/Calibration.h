@@ -0,0 +1,78 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+
+// Calibration points for one channel: raw ADC counts against the value a
+// reference instrument showed. Plain data with no constructor, so it can
+// be stored with EEPROM.put() or kept in RTC memory; all-zero is an empty
+// piecewise curve. Call clear() before using a local instance.
+class CalibrationCurve {
+public:
+  static const uint8_t MAX_POINTS = 8;
+  static const uint8_t MAX_DEGREE = 3;
+
+  enum Fit : uint8_t {
+    FIT_PIECEWISE = 0,    // straight lines between neighbouring points
+    FIT_POLYNOMIAL = 1    // least-squares polynomial through all points
+  };
+
+  struct Point {
+    uint16_t raw;
+    float value;
+  };
+
+  void clear();
+
+  // Insert in raw order; a point at an existing raw value replaces it.
+  // Returns false when the curve is full.
+  bool addPoint(uint16_t raw, float value);
+
+  void setFit(Fit fit, uint8_t degree);
+
+  // Rejects uninitialised or corrupt storage.
+  bool valid() const;
+
+  uint8_t count() const { return _count; }
+  const Point& point(uint8_t index) const { return _points[index]; }
+  Fit fit() const { return (Fit)_fit; }
+  uint8_t degree() const { return _degree; }
+
+  // Float evaluation of the fitted curve. Linear extrapolation past the
+  // end points (piecewise), or the polynomial itself. Needs 2+ points.
+  float evaluate(float raw) const;
+
+private:
+  bool solvePolynomial(double* coefficients, uint8_t& degree) const;
+
+  Point _points[MAX_POINTS];
+  uint8_t _count;
+  uint8_t _fit;
+  uint8_t _degree;
+};
+
+// A curve sampled at fixed ADC steps into an integer table. A conversion
+// is one shift, one multiply and one add, with no float maths.
+class CalibrationTable {
+public:
+  static const uint8_t SEGMENT_BITS = 5;     // 32 ADC counts per segment
+  static const uint16_t ENTRIES = (4096 >> SEGMENT_BITS) + 1;
+  static const uint8_t RAW_FRACTION_BITS = 4;
+  static const int32_t SCALE = 100;          // table holds value * SCALE
+
+  CalibrationTable();
+
+  // Sample the curve, clamped to [minValue, maxValue].
+  void compile(const CalibrationCurve& curve, float minValue, float maxValue);
+
+  // rawQ4 is the ADC reading with RAW_FRACTION_BITS of fraction (raw * 16),
+  // so averaged readings keep their sub-count resolution.
+  int32_t lookup(uint32_t rawQ4) const;
+
+  float value(float raw) const;
+
+private:
+  int32_t _table[ENTRIES];
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "ChunkedResponse.h"
+#include <stdarg.h>
+
+ChunkedResponse::ChunkedResponse(WebServer& server) : _server(server), _length(0) {}
+
+void ChunkedResponse::begin(int code, const char* contentType) {
+  _length = 0;
+  _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server.send(code, contentType, "");
+}
+
+void ChunkedResponse::print(const char* text) {
+  size_t length = strlen(text);
+  while (length > 0) {
+    size_t room = BUFFER_SIZE - _length;
+    if (room == 0) {
+      flush();
+      continue;
+    }
+    size_t n = length < room ? length : room;
+    memcpy(_buffer + _length, text, n);
+    _length += n;
+    text += n;
+    length -= n;
+  }
+}
+
+void ChunkedResponse::printf(const char* format, ...) {
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    size_t room = BUFFER_SIZE - _length;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(_buffer + _length, room, format, args);
+    va_end(args);
+    if (n < 0) return;
+
+    if ((size_t)n < room) {
+      _length += n;
+      return;
+    }
+    if (_length == 0) {
+      // Longer than the whole buffer: keep what fitted
+      _length = BUFFER_SIZE - 1;
+      return;
+    }
+    flush();
+  }
+}
+
+void ChunkedResponse::end() {
+  flush();
+  _server.sendContent("", 0);
+}
+
+void ChunkedResponse::flush() {
+  if (_length == 0) return;
+  _server.sendContent(_buffer, _length);
+  _length = 0;
+}
@@ -0,0 +1,29 @@
+#ifndef CHUNKED_RESPONSE_H
+#define CHUNKED_RESPONSE_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Builds an HTTP response in one fixed buffer and streams it out with
+// chunked transfer encoding whenever the buffer fills, so a page of any
+// length is sent without growing a String on the heap.
+class ChunkedResponse {
+public:
+  static const size_t BUFFER_SIZE = 512;
+
+  explicit ChunkedResponse(WebServer& server);
+
+  void begin(int code, const char* contentType);
+  void print(const char* text);
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  void end();
+
+private:
+  void flush();
+
+  WebServer& _server;
+  char _buffer[BUFFER_SIZE];
+  size_t _length;
+};
+
+#endif
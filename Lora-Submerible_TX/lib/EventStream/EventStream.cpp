@@ -0,0 +1,82 @@
+#include "EventStream.h"
+#include <lwip/sockets.h>
+
+EventStream::EventStream() : _lastWrite(0), _dropped(0) {
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    _open[i] = false;
+  }
+}
+
+bool EventStream::accept(WiFiClient client) {
+  maintain();
+
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    if (_open[i]) continue;
+
+    _clients[i] = client;
+    _clients[i].setNoDelay(true);
+    _open[i] = true;
+
+    char header[192];
+    int length = snprintf(header, sizeof(header),
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-store\r\n"
+      "Connection: keep-alive\r\n"
+      "\r\n"
+      "retry: %lu\n\n", RETRY_MS);
+    return write(i, header, length);
+  }
+  return false;
+}
+
+void EventStream::send(const char* event, const char* data) {
+  char line[896];
+  int length = snprintf(line, sizeof(line), "event: %s\ndata: %s\n\n", event, data);
+  if (length <= 0 || (size_t)length >= sizeof(line)) return;
+
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    if (_open[i]) write(i, line, length);
+  }
+  _lastWrite = millis();
+}
+
+void EventStream::maintain() {
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    if (_open[i] && !_clients[i].connected()) drop(i);
+  }
+
+  if (clients() > 0 && millis() - _lastWrite >= KEEPALIVE_MS) {
+    static const char comment[] = ": keepalive\n\n";
+    for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+      if (_open[i]) write(i, comment, sizeof(comment) - 1);
+    }
+    _lastWrite = millis();
+  }
+}
+
+uint8_t EventStream::clients() const {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    if (_open[i]) n++;
+  }
+  return n;
+}
+
+bool EventStream::write(uint8_t slot, const char* text, size_t length) {
+  // WiFiClient::write() retries for seconds on a full socket; go straight
+  // to lwIP without waiting instead. A partial event would corrupt the
+  // stream, so anything short of a full write drops the client.
+  int sent = ::send(_clients[slot].fd(), text, length, MSG_DONTWAIT);
+  if (sent != (int)length) {
+    drop(slot);
+    _dropped++;
+    return false;
+  }
+  return true;
+}
+
+void EventStream::drop(uint8_t slot) {
+  _clients[slot].stop();
+  _open[slot] = false;
+}
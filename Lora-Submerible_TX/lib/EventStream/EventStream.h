@@ -0,0 +1,44 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+// Server-Sent Events broadcaster. A WebServer handler hands its client over
+// with accept(); from then on every send() is one small write per client.
+// Writes never block: a client whose socket buffer cannot take the whole
+// event is disconnected (the browser reconnects by itself), so a stalled
+// phone cannot hold up the measurement or radio path.
+class EventStream {
+public:
+  static const uint8_t MAX_CLIENTS = 4;
+  static const unsigned long KEEPALIVE_MS = 15000;
+  static const unsigned long RETRY_MS = 2000;
+
+  EventStream();
+
+  // Take over the connection of the current request and send the stream
+  // headers. Returns false when every slot is in use.
+  bool accept(WiFiClient client);
+
+  // Send one event to every client. data must not contain newlines.
+  void send(const char* event, const char* data);
+
+  // Call from loop(): drops closed connections and keeps idle ones open
+  // through proxies with a comment line.
+  void maintain();
+
+  uint8_t clients() const;
+  uint32_t dropped() const { return _dropped; }
+
+private:
+  bool write(uint8_t slot, const char* text, size_t length);
+  void drop(uint8_t slot);
+
+  WiFiClient _clients[MAX_CLIENTS];
+  bool _open[MAX_CLIENTS];
+  unsigned long _lastWrite;
+  uint32_t _dropped;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "NodeUplink.h"
+#include <string.h>
+#include <LoRaAirtime.h>
+#include <Metrics.h>
+#include <RadioProfile.h>
+
+METRIC_HISTOGRAM(encodeLatency, "tx_encode_seconds", "Encoding a reading or batch frame");
+METRIC_HISTOGRAM(transmitLatency, "tx_transmit_seconds", "LoRa transmission until endPacket() returns");
+
+NodeUplink::NodeUplink(RadioDriver& radio, const NodeUplinkConfig& config, NodeUplinkListener& listener)
+  : _radio(&radio), _config(config), _listener(&listener),
+    _dutyCycle(*config.region, config.airtimePolicy), _batchCount(0), _flushing(false),
+    _seq(0), _epoch(0), _profile(RADIO_PROFILE_SAFE), _uplinksSinceDownlink(0), _rssi(0),
+    _listening(false), _windowStarted(false), _windowStart(0),
+    _airtimeDeferred(false), _airtimeResumeAt(0) {}
+
+void NodeUplink::begin() {
+  setProfile(_profile, false);
+}
+
+void NodeUplink::saveState(SavedState& out) const {
+  _sender.saveState(out.sender);
+  _dutyCycle.saveState(out.dutyCycle);
+  memcpy(out.batch, _batch, sizeof(_batch));
+  out.batchCount = _batchCount;
+  out.flushing = _flushing;
+  out.seq = _seq;
+  out.epoch = _epoch;
+  out.profile = _profile;
+  out.uplinksSinceDownlink = _uplinksSinceDownlink;
+  out.rssi = _rssi;
+  out.listening = _listening;
+  out.windowStarted = _windowStarted;
+  out.windowStart = _windowStart;
+  out.airtimeDeferred = _airtimeDeferred;
+  out.airtimeResumeAt = _airtimeResumeAt;
+}
+
+void NodeUplink::restoreState(const SavedState& in) {
+  _sender.restoreState(in.sender);
+  _dutyCycle.restoreState(in.dutyCycle);
+  memcpy(_batch, in.batch, sizeof(_batch));
+  _batchCount = in.batchCount < BATCH_CAPACITY ? in.batchCount : BATCH_CAPACITY;
+  _flushing = in.flushing;
+  _seq = in.seq;
+  _epoch = in.epoch;
+  _profile = in.profile;
+  _uplinksSinceDownlink = in.uplinksSinceDownlink;
+  _rssi = in.rssi;
+  _listening = in.listening;
+  _windowStarted = in.windowStarted;
+  _windowStart = in.windowStart;
+  _airtimeDeferred = in.airtimeDeferred;
+  _airtimeResumeAt = in.airtimeResumeAt;
+}
+
+void NodeUplink::queue(const FrameReading& reading, uint32_t capturedAt) {
+  if (_batchCount == BATCH_CAPACITY) dropReadings(1);
+  _batch[_batchCount].reading = reading;
+  _batch[_batchCount].capturedAt = capturedAt;
+  _batchCount++;
+}
+
+bool NodeUplink::batchDue(uint32_t now) const {
+  if (_batchCount == 0) return false;
+  if (_batchCount >= _config.batchSize) return true;
+  return now - _batch[0].capturedAt >= _config.batchMaxLatencyMs;
+}
+
+bool NodeUplink::service(uint32_t now) {
+  if (_listening) {
+    if (!_windowStarted) {
+      _windowStarted = true;
+      _windowStart = now;
+    }
+    if (now - _windowStart < _config.rxWindowMs && !pollDownlink()) return true;
+    closeWindow();
+  }
+
+  if (!_flushing && batchDue(now)) _flushing = true;
+  if (_flushing) flushBatch(now);
+  if (_batchCount == 0) _flushing = false;
+
+  if (_config.reliable) serviceRetransmits(now);
+  return _listening;
+}
+
+uint32_t NodeUplink::frameAirtimeUs(size_t length) const {
+  const RadioProfile& p = radioProfile(_profile);
+  return loraTimeOnAirUs(length, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+}
+
+// Batches are cut to this length, so on the slow profiles they carry
+// fewer readings per frame.
+size_t NodeUplink::maxFrameLength() const {
+  uint32_t dwellUs = _config.region->maxDwellUs;
+  if (dwellUs == 0) return FRAME_MAX_SIZE;
+  const RadioProfile& p = radioProfile(_profile);
+  size_t limit = loraMaxPayload(dwellUs, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+  return limit < FRAME_MAX_SIZE ? limit : FRAME_MAX_SIZE;
+}
+
+// As many of the oldest readings as fit in one frame. Returns the length,
+// 0 if not even one reading fits, and the number of readings in sent.
+size_t NodeUplink::encodeBatch(FrameHeader& header, uint8_t* frame, size_t& sent, uint32_t now) {
+  header.flags = _config.reliable ? FRAME_FLAG_ACK_REQUEST : 0;
+  header.nodeId = _config.nodeId;
+  header.seq = _seq;
+  header.epoch = _epoch;
+
+  size_t cap = maxFrameLength();
+  size_t length = 0;
+  sent = 0;
+
+  METRIC_STAMP(encodeStart);
+  if (_batchCount > 1) {
+    FrameSample samples[BATCH_CAPACITY];
+    for (uint8_t i = 0; i < _batchCount; i++) {
+      samples[i].reading = _batch[i].reading;
+      samples[i].ageDs = (now - _batch[i].capturedAt) / 100;
+    }
+    header.type = FRAME_BATCH;
+    length = frameEncodeBatch(header, samples, _batchCount, frame, cap, sent);
+  }
+  // One reading, or only one fits the dwell limit: a plain reading is shorter
+  if (sent <= 1) {
+    header.type = FRAME_READING;
+    length = frameEncodeReading(header, _batch[0].reading, frame, cap);
+    sent = 1;
+  }
+  METRIC_SINCE(encodeLatency, encodeStart);
+  return length;
+}
+
+void NodeUplink::dropReadings(size_t count) {
+  memmove(_batch, _batch + count, (_batchCount - count) * sizeof(PendingReading));
+  _batchCount -= count;
+}
+
+// In reliable mode frames go to the retransmit queue while it has room;
+// otherwise one frame goes straight out and the rest wait for its receive
+// window to close. Readings stay queued while the airtime budget defers
+// them, and without reliable mode when the transmission fails.
+void NodeUplink::flushBatch(uint32_t now) {
+  while (_batchCount > 0) {
+    if (_config.reliable && (_sender.full() || deferred(now))) return;
+
+    uint8_t frame[FRAME_MAX_SIZE];
+    FrameHeader header;
+    size_t sent;
+    size_t length = encodeBatch(header, frame, sent, now);
+    if (length == 0) {
+      _flushing = false;
+      return;
+    }
+
+    // Reliable frames keep their encoded ages; a retransmission reports
+    // readings as slightly newer than they are
+    if (_config.reliable) {
+      _sender.enqueue(frame, length, header.seq, now);
+    } else if (!airtimeAvailable(length, now)) {
+      return;
+    } else if (!transmit(frame, length, header.seq, 1, now)) {
+      _flushing = false;
+      return;
+    }
+
+    _listener->frameQueued(header.seq, sent);
+    _seq++;
+    dropReadings(sent);
+    if (_listening) return;
+  }
+}
+
+// Transmit the first reliable frame whose first attempt or retry is due
+// and fits the airtime budget. Returns true when one went out.
+bool NodeUplink::serviceRetransmits(uint32_t now) {
+  if (_listening) return false;
+
+  ReliableSender::Entry* entry;
+  while ((entry = _sender.due(now)) != nullptr) {
+    if (!_dutyCycle.fitsDwell(frameAirtimeUs(entry->length))) {
+      requeue(entry, now);
+      continue;
+    }
+    if (!airtimeAvailable(entry->length, now)) return false;
+
+    uint8_t attempt = entry->attempts + 1;
+    _sender.transmitted(entry, now);
+    return transmit(entry->frame, entry->length, entry->seq, attempt, now);
+  }
+  return false;
+}
+
+// A frame encoded on a faster profile can be too long for the dwell limit
+// after a move to a slower one. Its readings go back to the front of the
+// batch to be sent in frames that fit. Their ages count from the first
+// transmission, so they are reported slightly newer than they are.
+void NodeUplink::requeue(ReliableSender::Entry* entry, uint32_t now) {
+  FrameHeader header;
+  FrameSample samples[FRAME_BATCH_MAX];
+  size_t count;
+  frameDecodeUplink(entry->frame, entry->length, header, samples, FRAME_BATCH_MAX, count);
+  uint16_t seq = entry->seq;
+  _sender.release(entry);
+  _listener->frameRequeued(seq, count);
+
+  // Older than every reading waiting; the newest BATCH_CAPACITY are kept
+  size_t drop = _batchCount + count > BATCH_CAPACITY ? _batchCount + count - BATCH_CAPACITY : 0;
+  size_t added = count - drop;
+  memmove(_batch + added, _batch, _batchCount * sizeof(PendingReading));
+  for (size_t i = 0; i < added; i++) {
+    _batch[i].reading = samples[drop + i].reading;
+    _batch[i].capturedAt = now - samples[drop + i].ageDs * 100;
+  }
+  _batchCount += added;
+  _flushing = _batchCount > 0;
+}
+
+bool NodeUplink::deferred(uint32_t now) const {
+  return _airtimeDeferred && (int32_t)(now - _airtimeResumeAt) < 0;
+}
+
+// False while the budget of the sub-band has no room for a frame of this
+// length. The caller keeps the frame (or its readings) and nothing is
+// re-checked until the window has freed enough airtime.
+bool NodeUplink::airtimeAvailable(size_t length, uint32_t now) {
+  if (deferred(now)) return false;
+
+  uint32_t wait = _dutyCycle.waitMs(_config.frequencyHz, frameAirtimeUs(length), now);
+  _airtimeDeferred = wait > 0;
+  if (!_airtimeDeferred) return true;
+
+  // A frame longer than the whole budget waits for a profile change
+  if (wait == DutyCycle::NEVER) wait = DutyCycle::BUCKET_MS;
+  _airtimeResumeAt = now + wait;
+  _dutyCycle.deferred();
+  _listener->airtimeDeferred(wait);
+  return false;
+}
+
+bool NodeUplink::transmit(const uint8_t* frame, size_t length, uint16_t seq, uint8_t attempt, uint32_t now) {
+  uint32_t airtimeUs = frameAirtimeUs(length);
+  _listener->transmitting(seq, attempt, length, airtimeUs);
+
+  METRIC_STAMP(transmitStart);
+  bool ok = _radio->transmit(frame, length);
+  METRIC_SINCE(transmitLatency, transmitStart);
+  _dutyCycle.record(_config.frequencyHz, airtimeUs, now);
+  _listener->transmitted(ok);
+  if (!ok) return false;
+
+  if (_uplinksSinceDownlink < 255) _uplinksSinceDownlink++;
+  _listening = true;
+  _windowStarted = false;
+  return true;
+}
+
+// A downlink (ADR or ACK) for this node moves it to the profile the
+// gateway chose, and an ACK also releases the acknowledged frame from the
+// retransmit queue. Returns true when the window can close.
+bool NodeUplink::pollDownlink() {
+  uint8_t packet[FRAME_MAX_SIZE];
+  size_t length = _radio->receive(packet, sizeof(packet));
+  if (length == 0) return false;
+  _rssi = _radio->packetRssi();
+
+  FrameHeader header;
+  uint8_t profile;
+  if (frameDecodeDownlink(packet, length, header, profile) != FRAME_OK || header.nodeId != _config.nodeId) {
+    return false;
+  }
+
+  _uplinksSinceDownlink = 0;
+  // An ACK from before a restart would match a new frame's seq
+  if (header.type == FRAME_ACK && header.epoch == _epoch && _sender.acknowledge(header.seq)) {
+    _listener->acknowledged(header.seq);
+  }
+  _listener->downlink(_rssi, _radio->packetSnr());
+  if (profile != _profile) setProfile(profile, false);
+  return true;
+}
+
+// A run of uplinks without a downlink drops the node back to the safe
+// profile so both ends can find each other again.
+void NodeUplink::closeWindow() {
+  _listening = false;
+  if (_uplinksSinceDownlink >= _config.lostUplinks && _profile != RADIO_PROFILE_SAFE) {
+    setProfile(RADIO_PROFILE_SAFE, true);
+  }
+  _radio->idle();
+}
+
+void NodeUplink::setProfile(uint8_t profile, bool fallback) {
+  _profile = profile < RADIO_PROFILE_COUNT ? profile : RADIO_PROFILE_SAFE;
+  _radio->applyProfile(_profile);
+  _listener->profileChanged(_profile, fallback);
+}
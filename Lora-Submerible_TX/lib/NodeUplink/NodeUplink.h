@@ -0,0 +1,153 @@
+#ifndef NODE_UPLINK_H
+#define NODE_UPLINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <DutyCycle.h>
+#include <RadioDriver.h>
+#include <ReliableLink.h>
+#include <SubmersibleFrame.h>
+
+// The node's radio side, shared by the firmware and the host simulator:
+// readings are batched into frames no longer than the region's dwell limit
+// allows on the current profile, sent within the airtime budget (and in
+// reliable mode retransmitted until ACKed), and every uplink is followed
+// by a receive window for the gateway's ACK or ADR downlink.
+//
+// Nothing here reads a clock or blocks. The caller passes the time and
+// calls service() until it returns false:
+//
+//   uplink.queue(reading, now);
+//   while (uplink.service(now())) delay(1);
+//
+// saveState() and restoreState() carry it across deep sleep.
+
+struct NodeUplinkConfig {
+  uint8_t nodeId;
+  bool reliable;                 // ask for ACKs and retransmit until one comes
+  uint32_t frequencyHz;
+  const DutyCycleRegion* region;
+  float airtimePolicy;           // see DutyCycle
+  uint8_t batchSize;             // readings that make a batch due
+  uint32_t batchMaxLatencyMs;    // or the age of the oldest one
+  uint32_t rxWindowMs;           // listening after every uplink
+  uint8_t lostUplinks;           // uplinks without a downlink before the safe profile
+};
+
+// A reading waiting for the next frame
+struct PendingReading {
+  FrameReading reading;
+  uint32_t capturedAt;
+};
+
+// Progress reports, for the firmware's log. Every method defaults to
+// doing nothing.
+class NodeUplinkListener {
+public:
+  virtual ~NodeUplinkListener() {}
+
+  virtual void frameQueued(uint16_t seq, size_t readings) {}
+  // A frame too long for the dwell limit after a profile change, its
+  // readings put back to be sent in shorter frames
+  virtual void frameRequeued(uint16_t seq, size_t readings) {}
+  virtual void airtimeDeferred(uint32_t waitMs) {}
+  // attempt counts from 1
+  virtual void transmitting(uint16_t seq, uint8_t attempt, size_t length, uint32_t airtimeUs) {}
+  virtual void transmitted(bool ok) {}
+  virtual void downlink(int rssi, float snr) {}
+  virtual void acknowledged(uint16_t seq) {}
+  // fallback is true when no downlink came for lostUplinks uplinks
+  virtual void profileChanged(uint8_t profile, bool fallback) {}
+};
+
+class NodeUplink {
+public:
+  static const uint8_t BATCH_CAPACITY = 16;
+
+  // Everything but the radio, config and listener, as plain data for RTC
+  // memory
+  struct SavedState {
+    ReliableSender::SavedState sender;
+    DutyCycle::SavedState dutyCycle;
+    PendingReading batch[BATCH_CAPACITY];
+    uint8_t batchCount;
+    bool flushing;
+    uint16_t seq;
+    uint8_t epoch;
+    uint8_t profile;
+    uint8_t uplinksSinceDownlink;
+    int rssi;
+    bool listening;
+    bool windowStarted;
+    uint32_t windowStart;
+    bool airtimeDeferred;
+    uint32_t airtimeResumeAt;
+  };
+
+  NodeUplink(RadioDriver& radio, const NodeUplinkConfig& config, NodeUplinkListener& listener);
+
+  // Apply the current profile to the radio (after restoreState() too).
+  void begin();
+
+  void saveState(SavedState& out) const;
+  void restoreState(const SavedState& in);
+
+  // Boot epoch carried in every header, see SubmersibleFrame.h
+  void setEpoch(uint8_t epoch) { _epoch = epoch & FRAME_EPOCH_MASK; }
+
+  // A full batch that could not be sent keeps the newest readings.
+  void queue(const FrameReading& reading, uint32_t capturedAt);
+  bool batchDue(uint32_t now) const;
+
+  // One step: the receive window of the last uplink, then the next frame
+  // that is due and fits the airtime budget. Returns true while there is
+  // more to do straight away (a window is open).
+  bool service(uint32_t now);
+
+  uint8_t profile() const { return _profile; }
+  uint8_t uplinksSinceDownlink() const { return _uplinksSinceDownlink; }
+  int rssi() const { return _rssi; }
+  uint8_t batchCount() const { return _batchCount; }
+  uint16_t sequence() const { return _seq; }
+  const ReliableSender& sender() const { return _sender; }
+  DutyCycle& dutyCycle() { return _dutyCycle; }
+
+  // Time on air of a frame on the current profile, and the longest frame
+  // the dwell limit lets through on it.
+  uint32_t frameAirtimeUs(size_t length) const;
+  size_t maxFrameLength() const;
+
+private:
+  size_t encodeBatch(FrameHeader& header, uint8_t* frame, size_t& sent, uint32_t now);
+  void dropReadings(size_t count);
+  void flushBatch(uint32_t now);
+  bool serviceRetransmits(uint32_t now);
+  void requeue(ReliableSender::Entry* entry, uint32_t now);
+  bool deferred(uint32_t now) const;
+  bool airtimeAvailable(size_t length, uint32_t now);
+  bool transmit(const uint8_t* frame, size_t length, uint16_t seq, uint8_t attempt, uint32_t now);
+  bool pollDownlink();
+  void closeWindow();
+  void setProfile(uint8_t profile, bool fallback);
+
+  RadioDriver* _radio;
+  NodeUplinkConfig _config;
+  NodeUplinkListener* _listener;
+  ReliableSender _sender;
+  DutyCycle _dutyCycle;
+  PendingReading _batch[BATCH_CAPACITY];
+  uint8_t _batchCount;
+  bool _flushing;                // batch was due, sending until it is empty
+  uint16_t _seq;                 // starts at 0 after every restart
+  uint8_t _epoch;
+  uint8_t _profile;              // changed only by the gateway's downlinks
+  uint8_t _uplinksSinceDownlink;
+  int _rssi;
+  bool _listening;
+  bool _windowStarted;           // the window opens at the first service() after transmit
+  uint32_t _windowStart;
+  bool _airtimeDeferred;
+  uint32_t _airtimeResumeAt;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "SensorPipeline.h"
+#include <math.h>
+
+#define ADC_COUNTS 4095.0f
+#define ADC_VOLTS 3.3f
+
+SensorPipeline::SensorPipeline(const SensorFrontEnd& frontEnd, const FilterConfig& depthFilter,
+                               const FilterConfig& turbidityFilter)
+  : _frontEnd(frontEnd), _depthFilter(depthFilter), _turbidityFilter(turbidityFilter) {}
+
+void SensorPipeline::compile(const CalibrationCurve& depthCurve, float current4ma, float depthRange,
+                             const CalibrationCurve& turbidityCurve, float clearWaterVoltage) {
+  if (depthCurve.count() >= 2) {
+    _depthTable.compile(depthCurve, 0, _frontEnd.maxDepth);
+  } else {
+    float rawPerMA = ADC_COUNTS / ADC_VOLTS * _frontEnd.resistorOhms / 1000.0f;
+    CalibrationCurve line;
+    line.clear();
+    line.addPoint(lroundf(current4ma * rawPerMA), _frontEnd.depthAt4mA);
+    line.addPoint(lroundf((current4ma + _frontEnd.currentRangeMa) * rawPerMA), _frontEnd.depthAt4mA + depthRange);
+    _depthTable.compile(line, 0, _frontEnd.maxDepth);
+  }
+
+  if (turbidityCurve.count() >= 2) {
+    _turbidityTable.compile(turbidityCurve, 0, _frontEnd.maxNtu);
+  } else {
+    CalibrationCurve line;
+    line.clear();
+    line.addPoint(0, _frontEnd.maxNtu);
+    line.addPoint(lroundf(clearWaterVoltage / ADC_VOLTS * ADC_COUNTS), 0);
+    _turbidityTable.compile(line, 0, _frontEnd.maxNtu);
+  }
+}
+
+LevelReading SensorPipeline::level(const AdaptiveMean& adc) const {
+  LevelReading result;
+  result.raw = adc.mean;
+  result.samples = adc.samples;
+
+  float voltage = (result.raw / ADC_COUNTS) * ADC_VOLTS;
+  result.current = (voltage / _frontEnd.resistorOhms) * 1000.0f;
+  result.depth = _depthTable.value(result.raw);
+  result.depthCi = fabsf(_depthTable.value(result.raw + adc.ci95) - _depthTable.value(result.raw - adc.ci95)) / 2;
+  return result;
+}
+
+TurbidityReading SensorPipeline::turbidity(const AdaptiveMean& adc) const {
+  TurbidityReading result;
+  result.rawADC = (int)adc.mean;
+  result.actualVoltage = (result.rawADC / ADC_COUNTS) * ADC_VOLTS;
+  result.ntu = _turbidityTable.value(adc.mean);
+  result.ntuCi = fabsf(_turbidityTable.value(adc.mean + adc.ci95) - _turbidityTable.value(adc.mean - adc.ci95)) / 2;
+  result.samples = adc.samples;
+  return result;
+}
+
+void SensorPipeline::filter(LevelReading& level, TurbidityReading& turbidity, uint32_t now) {
+  level.depth = _depthFilter.update(level.depth, now);
+  turbidity.ntu = _turbidityFilter.update(turbidity.ntu, now);
+}
+
+void SensorPipeline::estimate(LevelReading& level, TurbidityReading& turbidity) const {
+  if (_depthFilter.state().samples > 0) level.depth = _depthFilter.value();
+  if (_turbidityFilter.state().samples > 0) turbidity.ntu = _turbidityFilter.value();
+}
+
+FrameReading SensorPipeline::frame(const LevelReading& level, float temperature,
+                                   const TurbidityReading& turbidity) const {
+  FrameReading reading;
+  frameReadingFromValues(reading, level.current, level.depth, temperature, temperature != -127,
+                         turbidity.actualVoltage, turbidity.ntu);
+  if (_depthFilter.state().gated) reading.flags |= FRAME_FLAG_DEPTH_GATED;
+  if (_turbidityFilter.state().gated) reading.flags |= FRAME_FLAG_TURB_GATED;
+  return reading;
+}
@@ -0,0 +1,82 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stdint.h>
+#include <AcquisitionEngine.h>
+#include <Calibration.h>
+#include <SignalFilter.h>
+#include <SubmersibleFrame.h>
+
+// The node's measurement chain from ADC means to the reading it sends:
+// calibration tables, then the depth and turbidity filters. The firmware
+// and the host simulator both measure through it.
+//
+// Only measurement cycles feed the filters (filter()); live samples for
+// the portal read their estimates (estimate()), so an open portal does not
+// change what the node transmits. Not thread-safe: the firmware holds its
+// calibration mutex around compile(), level() and turbidity().
+
+// Analog front end: the level sensor's 4-20 mA loop read across a shunt,
+// and the turbidity sensor's voltage, both on the 12-bit ADC at 3.3 V.
+struct SensorFrontEnd {
+  float resistorOhms;
+  float currentRangeMa;      // 16 mA from 4 to 20 mA
+  float depthAt4mA;
+  float maxDepth;            // tables clamp to 0..maxDepth cm, 0..maxNtu
+  float maxNtu;
+};
+
+struct LevelReading {
+  float raw;
+  float current;
+  float depth;
+  float depthCi;       // 95% confidence half-width, cm
+  uint16_t samples;
+};
+
+struct TurbidityReading {
+  int rawADC;
+  float actualVoltage;
+  float ntu;
+  float ntuCi;         // 95% confidence half-width, NTU
+  uint16_t samples;
+};
+
+class SensorPipeline {
+public:
+  SensorPipeline(const SensorFrontEnd& frontEnd, const FilterConfig& depthFilter,
+                 const FilterConfig& turbidityFilter);
+
+  // Rebuild both lookup tables. A channel with fewer than two curve points
+  // uses the straight line of its single-point calibration.
+  void compile(const CalibrationCurve& depthCurve, float current4ma, float depthRange,
+               const CalibrationCurve& turbidityCurve, float clearWaterVoltage);
+
+  // Unfiltered conversion of the channel means
+  LevelReading level(const AdaptiveMean& adc) const;
+  TurbidityReading turbidity(const AdaptiveMean& adc) const;
+
+  // Measurement cycle: feed the filters and replace depth and NTU with
+  // their estimates. now must keep running across deep sleep.
+  void filter(LevelReading& level, TurbidityReading& turbidity, uint32_t now);
+
+  // Live sample: the estimates of the last filter(), filters untouched
+  void estimate(LevelReading& level, TurbidityReading& turbidity) const;
+
+  // temperature is -127 without a probe. Flags the fields the rate gate
+  // held back in the last filter().
+  FrameReading frame(const LevelReading& level, float temperature,
+                     const TurbidityReading& turbidity) const;
+
+  SignalFilter& depthFilter() { return _depthFilter; }
+  SignalFilter& turbidityFilter() { return _turbidityFilter; }
+
+private:
+  SensorFrontEnd _frontEnd;
+  CalibrationTable _depthTable;
+  CalibrationTable _turbidityTable;
+  SignalFilter _depthFilter;
+  SignalFilter _turbidityFilter;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Latest-value cell for one writer and any number of readers, without
+// locks. The writer never waits; a reader that overlaps a write copies
+// again. T must be trivially copyable.
+//
+// A reader must not preempt the writer on the writer's own core (give
+// readers there a lower priority), or it would spin on an odd sequence.
+template <typename T>
+class Seqlock {
+public:
+  Seqlock() : _sequence(0), _value() {}
+
+  void write(const T& value) {
+    uint32_t seq = _sequence.load(std::memory_order_relaxed);
+    _sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _value = value;
+    _sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  // Copy the latest value. Returns its version: even, and 0 until the
+  // first write.
+  uint32_t read(T& out) const {
+    for (;;) {
+      uint32_t before = _sequence.load(std::memory_order_acquire);
+      if (before & 1) continue;
+      out = _value;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_sequence.load(std::memory_order_relaxed) == before) return before;
+    }
+  }
+
+  // Changes on every write; cheap check for "anything new?".
+  uint32_t version() const { return _sequence.load(std::memory_order_acquire) & ~1u; }
+
+private:
+  std::atomic<uint32_t> _sequence;
+  T _value;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "SignalFilter.h"
+#include <math.h>
+#include <string.h>
+
+SignalFilter::SignalFilter(const FilterConfig& config) : _config(config) {
+  if (_config.medianWindow < 1) _config.medianWindow = 1;
+  if (_config.medianWindow > MAX_MEDIAN) _config.medianWindow = MAX_MEDIAN;
+  reset();
+}
+
+void SignalFilter::reset() {
+  memset(_window, 0, sizeof(_window));
+  memset(&_state, 0, sizeof(_state));
+  _windowCount = 0;
+  _windowHead = 0;
+  _gateCount = 0;
+  _started = false;
+  _lastMs = 0;
+}
+
+void SignalFilter::saveState(SavedState& out) const {
+  memcpy(out.window, _window, sizeof(_window));
+  out.windowCount = _windowCount;
+  out.windowHead = _windowHead;
+  out.gateCount = _gateCount;
+  out.started = _started;
+  out.lastMs = _lastMs;
+  out.state = _state;
+}
+
+void SignalFilter::restoreState(const SavedState& in) {
+  memcpy(_window, in.window, sizeof(_window));
+  _windowCount = in.windowCount < _config.medianWindow ? in.windowCount : _config.medianWindow;
+  _windowHead = in.windowHead % _config.medianWindow;
+  _gateCount = in.gateCount;
+  _started = in.started;
+  _lastMs = in.lastMs;
+  _state = in.state;
+}
+
+float SignalFilter::update(float value, uint32_t nowMs) {
+  _state.input = value;
+  _state.samples++;
+
+  _window[_windowHead] = value;
+  _windowHead = (_windowHead + 1) % _config.medianWindow;
+  if (_windowCount < _config.medianWindow) _windowCount++;
+  float m = median();
+  _state.median = m;
+
+  if (!_started) {
+    _started = true;
+    _lastMs = nowMs;
+    _state.estimate = m;
+    _state.variance = _config.mode == SMOOTH_KALMAN ? _config.measurementNoise : 0;
+    _state.gated = false;
+    return _state.estimate;
+  }
+
+  float dt = (nowMs - _lastMs) / 1000.0f;
+  _lastMs = nowMs;
+
+  if (_config.maxRatePerS > 0 && fabsf(m - _state.estimate) > _config.maxRatePerS * dt) {
+    _state.rejected++;
+    if (++_gateCount < _config.gateLimit) {
+      _state.gated = true;
+      return _state.estimate;
+    }
+    // Still there after gateLimit inputs: a real step, restart from it
+    _gateCount = 0;
+    _state.gated = false;
+    _state.estimate = m;
+    _state.variance = _config.mode == SMOOTH_KALMAN ? _config.measurementNoise : 0;
+    return _state.estimate;
+  }
+  _gateCount = 0;
+  _state.gated = false;
+
+  switch (_config.mode) {
+    case SMOOTH_EMA: {
+      float alpha = _config.emaTimeConstantS > 0 ? 1.0f - expf(-dt / _config.emaTimeConstantS) : 1.0f;
+      _state.estimate += alpha * (m - _state.estimate);
+      break;
+    }
+    case SMOOTH_KALMAN: {
+      float p = _state.variance + _config.processNoise * dt;
+      float k = p / (p + _config.measurementNoise);
+      _state.estimate += k * (m - _state.estimate);
+      _state.variance = (1.0f - k) * p;
+      break;
+    }
+    default:
+      _state.estimate = m;
+      break;
+  }
+  return _state.estimate;
+}
+
+float SignalFilter::median() const {
+  // Insertion sort of at most MAX_MEDIAN values
+  float sorted[MAX_MEDIAN];
+  for (uint8_t i = 0; i < _windowCount; i++) {
+    float v = _window[i];
+    int8_t j = i - 1;
+    while (j >= 0 && sorted[j] > v) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = v;
+  }
+  return sorted[_windowCount / 2];
+}
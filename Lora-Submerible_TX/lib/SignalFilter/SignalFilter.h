@@ -0,0 +1,80 @@
+#ifndef SIGNAL_FILTER_H
+#define SIGNAL_FILTER_H
+
+#include <stdint.h>
+
+enum SmoothingMode : uint8_t {
+  SMOOTH_NONE = 0,
+  SMOOTH_EMA = 1,
+  SMOOTH_KALMAN = 2
+};
+
+struct FilterConfig {
+  uint8_t medianWindow;      // odd, 1 disables, up to SignalFilter::MAX_MEDIAN
+  SmoothingMode mode;
+  float emaTimeConstantS;    // EMA: time constant in seconds
+  float processNoise;        // Kalman: variance the true value gains per second
+  float measurementNoise;    // Kalman: variance of one input value
+  float maxRatePerS;         // rate-of-change gate in units per second, 0 disables
+  uint8_t gateLimit;         // consecutive gated inputs accepted as a real step
+};
+
+struct FilterState {
+  float input;               // last value given to update()
+  float median;              // after the median prefilter
+  float estimate;            // filter output
+  float variance;            // Kalman error variance, 0 for the other modes
+  bool gated;                // last input was rejected by the rate gate
+  uint32_t samples;
+  uint32_t rejected;
+};
+
+// One channel of the filter stage between acquisition and transmission:
+// a median-of-N prefilter against single spikes, a rate-of-change gate
+// against physically impossible jumps (a bubble on the turbidity optics),
+// then EMA or 1-D Kalman smoothing. Fixed memory and constant work per
+// input. Smoothing uses the real time between inputs, so the filter can be
+// fed at an irregular rate.
+class SignalFilter {
+public:
+  static const uint8_t MAX_MEDIAN = 7;
+
+  // Everything carried from one input to the next, as plain data for RTC
+  // memory; the config stays with the owner
+  struct SavedState {
+    float window[MAX_MEDIAN];
+    uint8_t windowCount;
+    uint8_t windowHead;
+    uint8_t gateCount;
+    bool started;
+    uint32_t lastMs;
+    FilterState state;
+  };
+
+  explicit SignalFilter(const FilterConfig& config);
+
+  void reset();
+
+  void saveState(SavedState& out) const;
+  void restoreState(const SavedState& in);
+
+  // Filter one value taken at nowMs and return the new estimate.
+  float update(float value, uint32_t nowMs);
+
+  float value() const { return _state.estimate; }
+  const FilterState& state() const { return _state; }
+
+private:
+  float median() const;
+
+  FilterConfig _config;
+  float _window[MAX_MEDIAN];
+  uint8_t _windowCount;
+  uint8_t _windowHead;
+  uint8_t _gateCount;
+  bool _started;
+  uint32_t _lastMs;
+  FilterState _state;
+};
+
+#endif
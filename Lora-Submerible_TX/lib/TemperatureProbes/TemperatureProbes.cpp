@@ -0,0 +1,109 @@
+#include "TemperatureProbes.h"
+
+TemperatureProbes::TemperatureProbes(DallasTemperature& bus)
+  : _bus(bus), _count(0), _converting(false), _conversionStart(0),
+    _conversionTime(0), _lastUpdate(0), _lastScan(0) {
+  for (uint8_t i = 0; i < MAX_PROBES; i++) {
+    _celsius[i] = DEVICE_DISCONNECTED_C;
+  }
+}
+
+void TemperatureProbes::begin() {
+  _bus.setWaitForConversion(false);
+  scan();
+  startConversion();
+}
+
+void TemperatureProbes::begin(const DeviceAddress* addresses, uint8_t count) {
+  if (count == 0) {
+    begin();
+    return;
+  }
+  
+  // DallasTemperature::begin() would search the bus, so skip it
+  _bus.setWaitForConversion(false);
+  _count = count < MAX_PROBES ? count : MAX_PROBES;
+  for (uint8_t i = 0; i < _count; i++) {
+    memcpy(_addresses[i], addresses[i], sizeof(DeviceAddress));
+  }
+  _lastScan = millis();
+  _conversionTime = _bus.millisToWaitForConversion(_bus.getResolution(_addresses[0]));
+  startConversion();
+}
+
+void TemperatureProbes::scan() {
+  _lastScan = millis();
+  _count = 0;
+
+  _bus.begin();
+  uint8_t found = _bus.getDeviceCount();
+  for (uint8_t i = 0; i < found && _count < MAX_PROBES; i++) {
+    if (_bus.getAddress(_addresses[_count], i)) {
+      _count++;
+    }
+  }
+
+  // All probes share one conversion, so wait for the slowest resolution
+  _conversionTime = _bus.millisToWaitForConversion(_bus.getResolution());
+
+  Serial.print("Temperature probes found: ");
+  Serial.println(_count);
+}
+
+void TemperatureProbes::startConversion() {
+  if (_count == 0) {
+    _converting = false;
+    return;
+  }
+  _bus.requestTemperatures();
+  _conversionStart = millis();
+  _converting = true;
+}
+
+bool TemperatureProbes::poll() {
+  if (_count == 0) {
+    if (millis() - _lastScan >= RESCAN_INTERVAL_MS) {
+      scan();
+      startConversion();
+    }
+    return false;
+  }
+
+  if (!_converting) {
+    startConversion();
+    return false;
+  }
+
+  // Parasite-powered probes cannot report completion, so fall back to time
+  if (millis() - _conversionStart < _conversionTime) {
+    if (_bus.isParasitePowerMode() || !_bus.isConversionComplete()) {
+      return false;
+    }
+  }
+
+  uint8_t failures = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    _celsius[i] = _bus.getTempC(_addresses[i]);
+    if (_celsius[i] == DEVICE_DISCONNECTED_C) failures++;
+  }
+  _lastUpdate = millis();
+
+  // Every probe vanished: re-enumerate on the next poll
+  if (failures == _count) {
+    _count = 0;
+    _lastScan = 0;
+  }
+
+  startConversion();
+  return true;
+}
+
+float TemperatureProbes::celsius(uint8_t index) const {
+  if (index >= _count) return DEVICE_DISCONNECTED_C;
+  return _celsius[index];
+}
+
+const uint8_t* TemperatureProbes::address(uint8_t index) const {
+  if (index >= _count) return nullptr;
+  return _addresses[index];
+}
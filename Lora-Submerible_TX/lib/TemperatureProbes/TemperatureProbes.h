@@ -0,0 +1,50 @@
+#ifndef TEMPERATURE_PROBES_H
+#define TEMPERATURE_PROBES_H
+
+#include <Arduino.h>
+#include <DallasTemperature.h>
+
+// Pipelined DS18B20 reader. ROM addresses are enumerated once and cached;
+// every probe on the bus converts in parallel from a single broadcast
+// request, and results are collected on a later poll() instead of waiting
+// for the conversion to finish. Adding probes does not add latency.
+class TemperatureProbes {
+public:
+  static const uint8_t MAX_PROBES = 8;
+  static const unsigned long RESCAN_INTERVAL_MS = 30000;
+
+  explicit TemperatureProbes(DallasTemperature& bus);
+
+  // Enumerate probes, cache their addresses and start the first conversion.
+  void begin();
+
+  // Start from addresses cached earlier (e.g. across deep sleep) without
+  // searching the bus. Falls back to begin() when count is 0.
+  void begin(const DeviceAddress* addresses, uint8_t count);
+
+  // Call often. Collects finished conversions and immediately starts the
+  // next one. Returns true when new values were stored.
+  bool poll();
+
+  uint8_t count() const { return _count; }
+  float celsius(uint8_t index) const;
+  const uint8_t* address(uint8_t index) const;
+  unsigned long lastUpdate() const { return _lastUpdate; }
+  bool hasReading() const { return _lastUpdate != 0; }
+
+private:
+  void scan();
+  void startConversion();
+
+  DallasTemperature& _bus;
+  DeviceAddress _addresses[MAX_PROBES];
+  float _celsius[MAX_PROBES];
+  uint8_t _count;
+  bool _converting;
+  unsigned long _conversionStart;
+  unsigned long _conversionTime;
+  unsigned long _lastUpdate;
+  unsigned long _lastScan;
+};
+
+#endif
@@ -6,12 +6,83 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <EEPROM.h>
+#include <sys/time.h>
+#include "esp_sleep.h"
+#include "driver/rtc_io.h"
+#include <AcquisitionEngine.h>
+#include <TemperatureProbes.h>
+#include <SubmersibleFrame.h>
+#include <LoRaAirtime.h>
+#include <DutyCycle.h>
+#include <RadioProfile.h>
+#include <RadioDriver.h>
+#include <ReliableLink.h>
+#include <EventStream.h>
+#include <ChunkedResponse.h>
+#include <Calibration.h>
+#include <SignalFilter.h>
+#include <SensorPipeline.h>
+#include <NodeUplink.h>
+#include <ConfigStore.h>
+#include <Preferences.h>
+#include <Seqlock.h>
+#include <Metrics.h>
+#include <atomic>
+#include <type_traits>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "index_html_gz.h"
 
 // LoRa pins
 #define LORA_SS 5
 #define LORA_RST 14
 #define LORA_DIO0 2
 
+// Downlink handling: the gateway answers in a short receive window after
+// each uplink. Without any downlink for ADR_LOST_UPLINKS frames the node
+// assumes contact is lost and returns to the safe profile.
+#define RX_WINDOW_MS 500
+#define ADR_LOST_UPLINKS 8
+
+// Node identity in every frame
+#define NODE_ID 1
+
+// Batching: readings are collected and sent together in one FRAME_BATCH
+// once BATCH_SIZE are queued or the oldest is BATCH_MAX_LATENCY_MS old.
+// A BATCH_SIZE of 1 sends every reading in its own FRAME_READING. While
+// the airtime budget defers sending, up to NodeUplink::BATCH_CAPACITY
+// readings wait and go out coalesced into fewer, fuller frames.
+#define BATCH_SIZE 8
+#define BATCH_MAX_LATENCY_MS 60000
+
+// Reliable mode: frames request an ACK and are retransmitted with
+// exponential backoff until the gateway confirms them.
+#define RELIABLE_MODE 1
+
+// Low-power mode: wake from deep sleep every SLEEP_INTERVAL_S, measure,
+// transmit and sleep again. The calibration portal only starts after a
+// wake from WAKE_BUTTON_PIN (button or reed switch to GND) and stays up
+// for PORTAL_TIMEOUT_MS.
+#define LOW_POWER_MODE 0
+#define SLEEP_INTERVAL_S 60
+#define WAKE_BUTTON_PIN 33
+#define PORTAL_TIMEOUT_MS 300000
+
+// Task layout. The radio task owns LoRa, the batch and the retransmit
+// queue; the acquisition task owns the probes and the filters and shares
+// the radio core one priority below it. The web task owns the HTTP
+// server, the event stream and the config store on the WiFi core, so a
+// slow client never delays a transmission or a measurement.
+#define RADIO_CORE 1
+#define WEB_CORE 0
+#define RADIO_TASK_PRIORITY 3
+#define ACQ_TASK_PRIORITY 2
+#define WEB_TASK_PRIORITY 1
+#define READING_QUEUE_LENGTH 8   // 16 s of measurement cycles
+#define RADIO_POLL_MS 100
+#define ACQ_POLL_MS 10
+#define WEB_POLL_MS 5
+
 // Sensor pins
 #define LEVEL_SENSOR_PIN 34
 #define TEMP_SENSOR_PIN 4
@@ -23,18 +94,29 @@ const char* password = "12345677";
 
 // Web server
 WebServer server(80);
+EventStream events;
+ChunkedResponse response(server);
 
-// EEPROM configuration
-#define EEPROM_SIZE 32
+// Legacy EEPROM layout, only read once to migrate into the config record
+#define EEPROM_SIZE 256
 #define ADDR_CURRENT_4MA 0
 #define ADDR_DEPTH_RANGE 4
-#define ADDR_TURB_CAL_A 8
-#define ADDR_TURB_CAL_B 12
 #define ADDR_CLEAR_WATER_VOLTAGE 16
+#define ADDR_DEPTH_CURVE 32
+#define ADDR_TURBIDITY_CURVE (ADDR_DEPTH_CURVE + sizeof(CalibrationCurve))
+
+// Configuration record schema; bump when TxConfig changes layout
+#define TX_CONFIG_SCHEMA 1
 
 // Sensor configuration constants
 const float RESISTOR_VALUE = 150.0;
-const int NUM_SAMPLES = 10;
+// Adaptive oversampling: each reading averages the newest ADC samples
+// until the standard error of the mean is within the channel's tolerance
+// (in ADC counts), using at least MIN_SAMPLES and at most MAX_SAMPLES.
+const uint16_t MIN_SAMPLES = 4;
+const uint16_t MAX_SAMPLES = 64;
+const float LEVEL_TOLERANCE = 1.0;       // ~0.17 cm at the default range
+const float TURBIDITY_TOLERANCE = 2.0;
 const float CURRENT_4MA = 3.40;
 const float DEPTH_AT_4MA = 0;
 const float CURRENT_RANGE = 16.0;
@@ -42,120 +124,566 @@ const float DEPTH_RANGE = 500.0;
 const float SENSOR_VCC = 3.3;
 const float ESP32_VCC = 3.3;
 const float CLEAR_WATER_VOLTAGE = 1.45;  // Voltage reading in clear water
+const float MAX_DEPTH = 10000.0;
+const float MAX_NTU = 3000.0;
+const uint32_t SAMPLE_PERIOD_US = 10000; // Background ADC sweep every 10 ms
+const unsigned long MEASURE_INTERVAL_MS = 2000;  // Measurement and LoRa cycle
+const unsigned long LIVE_INTERVAL_MS = 250;      // Event stream rate while clients are connected
+
+// Per-stage latency, served at /metrics; build with -DMETRICS_ENABLED=0
+// to leave the probes out. Encoding and transmission are timed in
+// NodeUplink.
+METRIC_HISTOGRAM(adcLatency, "tx_adc_sample_seconds", "One ADC conversion in the sampling timer");
+METRIC_HISTOGRAM(temperatureLatency, "tx_temperature_read_seconds", "Collecting finished DS18B20 conversions and starting the next");
+METRIC_HISTOGRAM(httpLatency, "tx_http_handler_seconds", "Web page and API handler run time");
+METRIC_COUNTER(httpRequests, "tx_http_requests_total", "Requests handled by the web server");
 
 // Initialize sensors
 OneWire oneWire(TEMP_SENSOR_PIN);
 DallasTemperature tempSensor(&oneWire);
+TemperatureProbes tempProbes(tempSensor);
+
+// Times every conversion the sampling timer makes
+class TimedAdcSource : public AdcSource {
+public:
+  explicit TimedAdcSource(AdcSource& adc) : _adc(adc) {}
+  uint16_t read(uint8_t pin) override {
+    METRIC_TIME(adcLatency);
+    return _adc.read(pin);
+  }
+
+private:
+  AdcSource& _adc;
+};
+
+// Background ADC acquisition
+ArduinoAdcSource arduinoAdc;
+TimedAdcSource adcSource(arduinoAdc);
+AcquisitionEngine acquisition(adcSource);
+int levelChannel = -1;
+int turbidityChannel = -1;
+
+// Everything the portal can change, stored as one CRC-checked record.
+// Multi-point calibration: with two or more points a channel uses its
+// fitted curve; otherwise the single-point values apply. Either way the
+// conversion is compiled into a table and readings only interpolate.
+struct TxConfig {
+  float current4ma;
+  float depthRange;
+  float clearWaterVoltage;
+  CalibrationCurve depthCurve;
+  CalibrationCurve turbidityCurve;
+};
+TxConfig nodeConfig = { CURRENT_4MA, DEPTH_RANGE, CLEAR_WATER_VOLTAGE };
+ConfigStore configStore("tx", TX_CONFIG_SCHEMA, &nodeConfig, sizeof(nodeConfig));
 
-// Global calibration values
-float g_current_4ma = CURRENT_4MA;
-float g_depth_range = DEPTH_RANGE;
-float g_turb_cal_a = 0.0;
-float g_turb_cal_b = 0.0;
-float clearWaterVoltage = CLEAR_WATER_VOLTAGE;
-
-struct TurbidityReading {
-  int rawADC;
-  float actualVoltage;
-  float ntu;
+// Filter stage between acquisition and transmission, fed by the
+// measurement cycles only
+const FilterConfig DEPTH_FILTER = {
+  5,              // median of the last 5 readings
+  SMOOTH_KALMAN,
+  0,
+  0.5,            // process noise, cm^2 per second
+  4.0,            // measurement noise, cm^2
+  20.0,           // faster than 20 cm/s is not water level
+  3               // three gated readings in a row are a real step
 };
+const FilterConfig TURBIDITY_FILTER = {
+  5,
+  SMOOTH_EMA,
+  10.0,           // EMA time constant, seconds
+  0,
+  0,
+  200.0,          // NTU per second
+  3
+};
+const SensorFrontEnd FRONT_END = { RESISTOR_VALUE, CURRENT_RANGE, DEPTH_AT_4MA, MAX_DEPTH, MAX_NTU };
+SensorPipeline pipeline(FRONT_END, DEPTH_FILTER, TURBIDITY_FILTER);
+
+LoRaRadioDriver radio;
+
+// Serial log of the radio side
+class NodeLog : public NodeUplinkListener {
+public:
+  void frameQueued(uint16_t seq, size_t readings) override {
+    Serial.print("Packet queued: seq ");
+    Serial.print(seq);
+    Serial.print(", readings ");
+    Serial.println(readings);
+  }
+
+  void frameRequeued(uint16_t seq, size_t readings) override {
+    Serial.print("Seq ");
+    Serial.print(seq);
+    Serial.print(" exceeds the dwell limit on this profile, re-sending ");
+    Serial.print(readings);
+    Serial.println(" readings");
+  }
+
+  void airtimeDeferred(uint32_t waitMs) override {
+    Serial.print("Airtime budget used up, deferring for ");
+    Serial.print(waitMs / 1000);
+    Serial.println(" s");
+  }
+
+  void transmitting(uint16_t seq, uint8_t attempt, size_t length, uint32_t airtimeUs) override {
+    if (attempt > 1) {
+      Serial.print("Retransmitting seq ");
+      Serial.print(seq);
+      Serial.print(", attempt ");
+      Serial.println(attempt);
+    }
+    Serial.print("Packet size: ");
+    Serial.print(length);
+    Serial.print(" bytes, ");
+    Serial.print(airtimeUs / 1000.0, 1);
+    Serial.println(" ms on air");
+    Serial.println("Attempting to send packet...");
+  }
+
+  void transmitted(bool ok) override {
+    Serial.println(ok ? "✓ Packet transmitted successfully" : "✗ Transmission failed!");
+  }
+
+  void downlink(int rssi, float snr) override {
+    Serial.print("Downlink: RSSI ");
+    Serial.print(rssi);
+    Serial.print(" dBm, SNR ");
+    Serial.print(snr, 1);
+    Serial.println(" dB");
+  }
+
+  void acknowledged(uint16_t seq) override {
+    Serial.print("✓ ACK for seq ");
+    Serial.println(seq);
+  }
+
+  void profileChanged(uint8_t profile, bool fallback) override {
+    if (fallback) Serial.println("No downlink from gateway, falling back to safe profile");
+    const RadioProfile& p = radioProfile(profile);
+    Serial.print("Radio profile ");
+    Serial.print(profile);
+    Serial.print(": SF");
+    Serial.print(p.spreadingFactor);
+    Serial.print(", ");
+    Serial.print(p.bandwidthHz / 1000);
+    Serial.print(" kHz, CR 4/");
+    Serial.print(p.codingRate);
+    Serial.print(", ");
+    Serial.print(p.txPowerDbm);
+    Serial.println(" dBm");
+  }
+};
+NodeLog nodeLog;
+
+// Batching, reliable delivery, the airtime budget and the receive windows.
+// Frames carry the boot epoch next to the sequence number, which starts at
+// 0 after every restart: the restart count kept in NVS, modulo 4
+// (FRAME_EPOCH_MASK).
+const NodeUplinkConfig UPLINK = {
+  NODE_ID,
+  RELIABLE_MODE,
+  (uint32_t)RADIO_FREQUENCY,
+  &RADIO_DUTY_REGION,
+  RADIO_AIRTIME_POLICY,
+  BATCH_SIZE,
+  BATCH_MAX_LATENCY_MS,
+  RX_WINDOW_MS,
+  ADR_LOST_UPLINKS
+};
+NodeUplink uplink(radio, UPLINK, nodeLog);
+
+// State kept in RTC slow memory across deep sleep, so a timer wake neither
+// re-reads the configuration nor searches the OneWire bus. The bootloader reloads
+// this section on every other kind of reset, which clears the magic.
+// The libraries' state goes through their saveState()/restoreState().
+#define RTC_STATE_MAGIC 0x57A7E001
+struct RtcState {
+  uint32_t magic;
+  uint32_t wakeCount;
+  uint32_t lastAwakeMs;
+  uint32_t totalAwakeMs;
+  TxConfig config;
+  uint8_t probeCount;
+  DeviceAddress probes[TemperatureProbes::MAX_PROBES];
+  NodeUplink::SavedState uplink;
+  SignalFilter::SavedState depthFilter;
+  SignalFilter::SavedState turbidityFilter;
+};
+// No constructor may run over it at wake-up, and it is copied as bytes
+static_assert(std::is_trivial<RtcState>::value, "RtcState must be plain data");
+RTC_DATA_ATTR RtcState rtcState;
+unsigned long portalStart = 0;
+
+// Latest reading, served by the web handlers so a page load never
+// touches the sensors and every client sees the same values
+struct SensorSnapshot {
+  float current;
+  float depth;
+  float depthCi;
+  uint16_t levelSamples;
+  float temperature;
+  uint8_t probeCount;
+  float probes[TemperatureProbes::MAX_PROBES];
+  TurbidityReading turbidity;
+  FilterState depthFilter;
+  FilterState turbidityFilter;
+  unsigned long takenAt;
+  bool valid;
+};
+Seqlock<SensorSnapshot> latestSnapshot;
+
+// Radio state as published by the radio task for the other tasks
+struct LinkStatus {
+  ReliableSenderStats stats;
+  uint8_t pending;
+  uint8_t profile;
+  uint8_t uplinksSinceDownlink;
+  int16_t rssi;
+  DutyCycleStats airtime;
+  uint32_t airtimeWindowUs;
+  uint32_t airtimeLimitUs;
+};
+Seqlock<LinkStatus> linkStatus;
+
+// Measurement cycles on their way from the acquisition to the radio task
+QueueHandle_t readingQueue = NULL;
+volatile uint32_t droppedReadings = 0;
+
+// The web task rebuilds the calibration tables while the acquisition
+// task interpolates in them
+SemaphoreHandle_t calibrationMutex = NULL;
+
+// Event stream clients, so the acquisition task knows to take live samples
+std::atomic<uint8_t> liveClients(0);
+
+// Before deep sleep every task parks itself at the top of its loop
+volatile bool stopRequested = false;
+EventGroupHandle_t parkedTasks = NULL;
 
 // Function prototypes
-float readCurrentMA();
-float convertToDepth(float current_mA);
+LevelReading readLevel();
 float readTemperature();
 TurbidityReading readTurbidity();
+void setupAcquisition();
 void handleCalibrationServer();
 void setupWiFiAP();
 void handleRoot();
 void handleCalibrate();
-void loadCalibrationValues();
+void loadConfiguration();
 void setupCalibration();
-String generateReadingsHtml();
+void compileCalibration();
+void configChanged();
+void handleCalibrationPoint();
+void handleCalibrationFit();
+void handleCalibrationReset();
+void handleApiCalibration();
+CalibrationCurve* curveForRequest();
+void sendCurveJson(const char* name, const CalibrationCurve& curve);
+void sendReadingsHtml();
 void handleTurbidityCalibration();
 void handleReadings();
+void handleApiReadings();
+void handleEvents();
+size_t buildReadingsJson(const SensorSnapshot& snapshot, char* json, size_t size);
+void publishSnapshot();
+void publishLiveSample();
+void updateSnapshot(const LevelReading& level, float temperature, const TurbidityReading& turbidity);
+void filterReadings(LevelReading& level, TurbidityReading& turbidity);
+void printAirtimeComparison();
+unsigned long nodeMillis();
+void countBoot();
+bool restoreRtcState();
+void saveRtcState();
+void enterDeepSleep();
+void measureAndSend();
+void printLinkStatus();
+FrameReading measure();
+void sendReading(const FrameReading& reading, uint32_t capturedAt);
+void serviceUplink();
+void publishLinkStatus();
+void acquisitionTask(void* arg);
+void radioTask(void* arg);
+void webTask(void* arg);
+void startTasks();
+void stopTasks();
+void parkIfStopping(uint8_t index);
+void taskWorked(uint8_t index, int64_t start);
+void printTaskStats();
+void handleApiTasks();
+void handleMetrics();
+WebServer::THandlerFunction timed(void (*handler)());
+
+// Per-task statistics. Busy time is wall time inside each work unit,
+// blocking waits within it included (the radio's receive window counts);
+// the Arduino core builds FreeRTOS without run-time counters.
+enum { TASK_ACQ, TASK_RADIO, TASK_WEB, TASK_COUNT };
+struct TaskInfo {
+  const char* name;
+  TaskFunction_t entry;
+  uint32_t stackSize;
+  UBaseType_t priority;
+  BaseType_t core;
+  TaskHandle_t handle;
+  volatile uint32_t busyMs;
+  uint32_t busyUs;          // below one millisecond, carried over
+  volatile uint32_t loops;
+};
+TaskInfo tasks[TASK_COUNT] = {
+  { "acq", acquisitionTask, 4096, ACQ_TASK_PRIORITY, RADIO_CORE },
+  { "radio", radioTask, 4096, RADIO_TASK_PRIORITY, RADIO_CORE },
+  { "web", webTask, 8192, WEB_TASK_PRIORITY, WEB_CORE },
+};
 
 // Sensor Reading Functions
-float readCurrentMA() {
-  long sum = 0;
+void setupAcquisition() {
+  levelChannel = acquisition.addChannel(LEVEL_SENSOR_PIN);
+  turbidityChannel = acquisition.addChannel(TURBIDITY_SENSOR_PIN);
   
-  for(int i = 0; i < NUM_SAMPLES; i++) {
-    sum += analogRead(LEVEL_SENSOR_PIN);
-    delay(10);
+  if (!acquisition.begin(SAMPLE_PERIOD_US)) {
+    Serial.println("Error: Could not start ADC acquisition timer");
+    return;
   }
   
-  float average = sum / (float)NUM_SAMPLES;
-  float voltage = (average / 4095.0) * 3.3;
-  float current = (voltage / RESISTOR_VALUE) * 1000.0;
-  
-  return current;
+  // Wait until both channels have a trustworthy mean. Quiet water gets
+  // there after MIN_SAMPLES, which shortens every low-power wake.
+  AdaptiveMean level, turbidity;
+  while (acquisition.sampleCount(turbidityChannel) < MAX_SAMPLES &&
+         !(acquisition.adaptiveMean(levelChannel, MIN_SAMPLES, MAX_SAMPLES, LEVEL_TOLERANCE, level) &&
+           acquisition.adaptiveMean(turbidityChannel, MIN_SAMPLES, MAX_SAMPLES, TURBIDITY_TOLERANCE, turbidity))) {
+    delay(SAMPLE_PERIOD_US / 1000);
+  }
 }
 
-float convertToDepth(float current_mA) {
-  float current_diff = current_mA - g_current_4ma;
-  float depth = DEPTH_AT_4MA + (current_diff * (g_depth_range / CURRENT_RANGE));
+LevelReading readLevel() {
+  AdaptiveMean adc;
+  acquisition.adaptiveMean(levelChannel, MIN_SAMPLES, MAX_SAMPLES, LEVEL_TOLERANCE, adc);
+  xSemaphoreTake(calibrationMutex, portMAX_DELAY);
+  LevelReading result = pipeline.level(adc);
+  xSemaphoreGive(calibrationMutex);
   
-  if (depth < 0) depth = 0;
-  return depth;
+  return result;
 }
 
+// Returns the latest completed conversion of the first probe; the probes
+// are converted in the background by tempProbes.poll() in the acquisition task.
 float readTemperature() {
-  tempSensor.requestTemperatures();
-  float tempC = tempSensor.getTempCByIndex(0);
+  float tempC = tempProbes.celsius(0);
   
   if(tempC == DEVICE_DISCONNECTED_C) {
-    Serial.println("Error: Could not read temperature data");
+    if (tempProbes.hasReading()) {
+      Serial.println("Error: Could not read temperature data");
+    }
     return -127;
   }
   
   return tempC;
 }
 
+// Replace depth and NTU with the filtered estimates. Called once per
+// measurement cycle only. Timestamps come from the RTC clock so the
+// filters keep their timing across deep sleep.
+void filterReadings(LevelReading& level, TurbidityReading& turbidity) {
+  pipeline.filter(level, turbidity, nodeMillis());
+}
+
 TurbidityReading readTurbidity() {
-  long sum = 0;
-  TurbidityReading result;
+  AdaptiveMean adc;
+  acquisition.adaptiveMean(turbidityChannel, MIN_SAMPLES, MAX_SAMPLES, TURBIDITY_TOLERANCE, adc);
+  xSemaphoreTake(calibrationMutex, portMAX_DELAY);
+  TurbidityReading result = pipeline.turbidity(adc);
+  xSemaphoreGive(calibrationMutex);
   
-  for(int i = 0; i < NUM_SAMPLES; i++) {
-    sum += analogRead(TURBIDITY_SENSOR_PIN);
-    delay(10);
+  return result;
+}
+
+void updateSnapshot(const LevelReading& level, float temperature, const TurbidityReading& turbidity) {
+  SensorSnapshot snapshot;
+  snapshot.current = level.current;
+  snapshot.depth = level.depth;
+  snapshot.depthCi = level.depthCi;
+  snapshot.levelSamples = level.samples;
+  snapshot.temperature = temperature;
+  snapshot.probeCount = tempProbes.count();
+  for (uint8_t i = 0; i < snapshot.probeCount; i++) {
+    snapshot.probes[i] = tempProbes.celsius(i);
   }
-  
-  result.rawADC = sum / NUM_SAMPLES;
-  result.actualVoltage = (result.rawADC / 4095.0) * 3.3;
-  result.ntu = 3000 * (1 - (result.actualVoltage / clearWaterVoltage));
-  
-  if(result.actualVoltage > clearWaterVoltage) {
-    result.ntu = 0;
+  snapshot.turbidity = turbidity;
+  snapshot.depthFilter = pipeline.depthFilter().state();
+  snapshot.turbidityFilter = pipeline.turbidityFilter().state();
+  snapshot.takenAt = millis();
+  snapshot.valid = true;
+  latestSnapshot.write(snapshot);
+}
+
+// Streamed from a fixed buffer: nothing is allocated per request
+void sendReadingsHtml() {
+  SensorSnapshot snapshot;
+  latestSnapshot.read(snapshot);
+  response.begin(200, "text/html");
+  response.print("<div class='reading'><h3>Current Readings</h3>");
+  if (!snapshot.valid) {
+    response.print("<p>Waiting for the first measurement...</p></div>");
+    response.end();
+    return;
+  }
+  response.print("<table>");
+  response.printf("<tr><td>Current Reading:</td><td>%.2f mA</td></tr>", snapshot.current);
+  response.printf("<tr><td>Water Depth:</td><td>%.1f &plusmn; %.2f cm (n=%u)</td></tr>",
+                  snapshot.depth, snapshot.depthCi, snapshot.levelSamples);
+  response.printf("<tr><td>Temperature:</td><td>%.1f °C</td></tr>", snapshot.temperature);
+  for (uint8_t i = 1; i < snapshot.probeCount; i++) {
+    response.printf("<tr><td>Temperature %u:</td><td>%.1f °C</td></tr>", i + 1, snapshot.probes[i]);
+  }
+  response.printf("<tr><td>Turbidity:</td><td>%.1f &plusmn; %.2f NTU (n=%u, Voltage: %.3fV)</td></tr>",
+                  snapshot.turbidity.ntu, snapshot.turbidity.ntuCi, snapshot.turbidity.samples,
+                  snapshot.turbidity.actualVoltage);
+  response.printf("<tr><td>Clear Water Voltage:</td><td>%.3fV</td></tr>", nodeConfig.clearWaterVoltage);
+  response.printf("<tr><td>Filter Input:</td><td>%.1f cm%s, %.1f NTU%s</td></tr>",
+                  snapshot.depthFilter.input, snapshot.depthFilter.gated ? " (gated)" : "",
+                  snapshot.turbidityFilter.input, snapshot.turbidityFilter.gated ? " (gated)" : "");
+  LinkStatus status;
+  linkStatus.read(status);
+  if (RELIABLE_MODE) {
+    const ReliableSenderStats& link = status.stats;
+    response.printf("<tr><td>LoRa Link:</td><td>%lu/%lu acked, %lu retries, %lu lost</td></tr>",
+                    (unsigned long)link.acked, (unsigned long)link.sent,
+                    (unsigned long)link.retries, (unsigned long)link.lost);
+  }
+  response.printf("<tr><td>Airtime:</td><td>%.1f s in the last hour", status.airtimeWindowUs / 1e6);
+  if (status.airtimeLimitUs != DutyCycle::NEVER) {
+    response.printf(" of %.0f s", status.airtimeLimitUs / 1e6);
+  }
+  response.printf(", %lu frames, %lu deferred</td></tr>",
+                  (unsigned long)status.airtime.frames, (unsigned long)status.airtime.deferred);
+  response.printf("<tr><td>Heap:</td><td>%u free, %u minimum, %u largest block</td></tr>",
+                  ESP.getFreeHeap(), ESP.getMinFreeHeap(),
+                  heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  response.print("</table>");
+  response.printf("<p>Updated %.1f s ago</p>", (millis() - snapshot.takenAt) / 1000.0);
+  response.print("</div>");
+  response.end();
+}
+
+void handleReadings() {
+  sendReadingsHtml();
+}
+
+// The snapshot as JSON, shared by /api/readings and the event stream.
+// Returns the length written, or 0 if the buffer was too small.
+size_t buildReadingsJson(const SensorSnapshot& snapshot, char* json, size_t size) {
+  size_t len = snprintf(json, size,
+    "{\"age_ms\":%lu,\"current\":%.2f,\"depth\":%.1f,\"depth_ci\":%.2f,\"depth_n\":%u,\"temps\":[",
+    millis() - snapshot.takenAt, snapshot.current, snapshot.depth, snapshot.depthCi, snapshot.levelSamples);
+  for (uint8_t i = 0; i < snapshot.probeCount && len < size; i++) {
+    if (snapshot.probes[i] == DEVICE_DISCONNECTED_C) {
+      len += snprintf(json + len, size - len, "%snull", i ? "," : "");
+    } else {
+      len += snprintf(json + len, size - len, "%s%.2f", i ? "," : "", snapshot.probes[i]);
+    }
+  }
+  if (len < size) {
+    len += snprintf(json + len, size - len,
+      "],\"turb_ntu\":%.1f,\"turb_ci\":%.2f,\"turb_n\":%u,\"turb_v\":%.3f,\"turb_raw\":%d,\"clear_water_v\":%.3f",
+      snapshot.turbidity.ntu, snapshot.turbidity.ntuCi, snapshot.turbidity.samples,
+      snapshot.turbidity.actualVoltage, snapshot.turbidity.rawADC, nodeConfig.clearWaterVoltage);
+  }
+  LinkStatus status;
+  linkStatus.read(status);
+  if (RELIABLE_MODE && len < size) {
+    const ReliableSenderStats& link = status.stats;
+    len += snprintf(json + len, size - len,
+      ",\"link\":{\"sent\":%lu,\"acked\":%lu,\"retries\":%lu,\"lost\":%lu,\"pending\":%u}",
+      (unsigned long)link.sent, (unsigned long)link.acked, (unsigned long)link.retries,
+      (unsigned long)link.lost, status.pending);
+  }
+  if (len < size) {
+    // limit_ms is null where neither the region nor the policy caps airtime
+    char limit[12] = "null";
+    if (status.airtimeLimitUs != DutyCycle::NEVER) {
+      snprintf(limit, sizeof(limit), "%lu", (unsigned long)(status.airtimeLimitUs / 1000));
+    }
+    len += snprintf(json + len, size - len,
+      ",\"airtime\":{\"window_ms\":%lu,\"limit_ms\":%s,\"total_ms\":%lu,\"frames\":%lu,"
+      "\"max_frame_ms\":%.1f,\"deferred\":%lu,\"over_dwell\":%lu}",
+      (unsigned long)(status.airtimeWindowUs / 1000), limit,
+      (unsigned long)(status.airtime.airtimeUs / 1000), (unsigned long)status.airtime.frames,
+      status.airtime.maxFrameUs / 1000.0, (unsigned long)status.airtime.deferred,
+      (unsigned long)status.airtime.overDwell);
+  }
+  if (len < size) {
+    len += snprintf(json + len, size - len,
+      ",\"filter\":{\"depth\":{\"input\":%.1f,\"median\":%.1f,\"variance\":%.3f,\"gated\":%s,\"rejected\":%lu},"
+      "\"turbidity\":{\"input\":%.1f,\"median\":%.1f,\"gated\":%s,\"rejected\":%lu}}",
+      snapshot.depthFilter.input, snapshot.depthFilter.median, snapshot.depthFilter.variance,
+      snapshot.depthFilter.gated ? "true" : "false", (unsigned long)snapshot.depthFilter.rejected,
+      snapshot.turbidityFilter.input, snapshot.turbidityFilter.median,
+      snapshot.turbidityFilter.gated ? "true" : "false", (unsigned long)snapshot.turbidityFilter.rejected);
+  }
+  if (len < size) {
+    // min_free is the heap high-water mark; a shrinking largest block
+    // next to steady free space means fragmentation
+    len += snprintf(json + len, size - len,
+      ",\"heap\":{\"free\":%u,\"min_free\":%u,\"largest\":%u}",
+      ESP.getFreeHeap(), ESP.getMinFreeHeap(),
+      heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  }
+  if (len < size) {
+    len += snprintf(json + len, size - len, "}");
+  }
+  return len < size ? len : 0;
+}
+
+// Same snapshot as /readings, as JSON for the static page and for scripts
+void handleApiReadings() {
+  SensorSnapshot snapshot;
+  latestSnapshot.read(snapshot);
+  char json[1024];
+  if (!snapshot.valid || buildReadingsJson(snapshot, json, sizeof(json)) == 0) {
+    server.send_P(503, "application/json", "{\"error\":\"no reading yet\"}");
+    return;
   }
   
-  if(result.ntu < 0) result.ntu = 0;
-  if(result.ntu > 3000) result.ntu = 3000;
-  
-  return result;
+  server.sendHeader("Cache-Control", "no-store");
+  server.send_P(200, "application/json", json, strlen(json));
 }
 
-String generateReadingsHtml() {
-  float current = readCurrentMA();
-  float depth = convertToDepth(current);
-  float temperature = readTemperature();
-  TurbidityReading turb = readTurbidity();
+// Long-lived Server-Sent Events connection; the socket is handed over to
+// the EventStream and released by the WebServer straight away.
+void handleEvents() {
+  if (!events.accept(server.client())) {
+    server.send_P(503, "text/plain", "Too many live clients");
+    return;
+  }
+  server.client().stop();
+  publishSnapshot();
+}
+
+void publishSnapshot() {
+  if (events.clients() == 0) return;
   
-  String html = "<div class='reading'>";
-  html += "<h3>Current Readings</h3>";
-  html += "<table>";
-  html += "<tr><td>Current Reading:</td><td>" + String(current, 2) + " mA</td></tr>";
-  html += "<tr><td>Water Depth:</td><td>" + String(depth, 1) + " cm</td></tr>";
-  html += "<tr><td>Temperature:</td><td>" + String(temperature, 1) + " °C</td></tr>";
-  html += "<tr><td>Turbidity:</td><td>" + String(turb.ntu, 1) + " NTU (Voltage: " + String(turb.actualVoltage, 3) + "V)</td></tr>";
-  html += "<tr><td>Clear Water Voltage:</td><td>" + String(clearWaterVoltage, 3) + "V</td></tr>";
-  html += "</table>";
-  html += "</div>";
+  SensorSnapshot snapshot;
+  latestSnapshot.read(snapshot);
+  if (!snapshot.valid) return;
   
-  return html;
+  char json[1024];
+  if (buildReadingsJson(snapshot, json, sizeof(json)) > 0) {
+    events.send("reading", json);
+  }
 }
 
-void handleReadings() {
-  server.send(200, "text/html", generateReadingsHtml());
+// Between measurement cycles the ADC rings and the last probe conversion
+// already hold fresh values, so live clients get them without a new read.
+// The web task streams the new snapshot. Depth and NTU are the filters'
+// estimates from the last measure(): only measurement cycles feed the
+// filters, so an open portal does not change what the node transmits.
+void publishLiveSample() {
+  LevelReading level = readLevel();
+  TurbidityReading turbidity = readTurbidity();
+  pipeline.estimate(level, turbidity);
+  float temperature = tempProbes.celsius(0);
+  if (temperature == DEVICE_DISCONNECTED_C) temperature = -127;
+  updateSnapshot(level, temperature, turbidity);
 }
 
 void setupWiFiAP() {
@@ -165,66 +693,11 @@ void setupWiFiAP() {
   Serial.println(WiFi.softAPIP());
 }
 
+// The page is static: web/index.html, gzipped into flash at build time by
+// tools/embed_web.py. It fills itself in from /api/readings.
 void handleRoot() {
-  String html = "<html><head>";
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-  html += "<script>";
-  html += "function updateReadings() {";
-  html += "  fetch('/readings')";
-  html += "    .then(response => response.text())";
-  html += "    .then(data => {";
-  html += "      document.getElementById('readings').innerHTML = data;";
-  html += "    });";
-  html += "}";
-  html += "setInterval(updateReadings, 2000);";
-  html += "</script>";
-  html += "<style>";
-  html += "body{font-family:Arial;margin:20px;max-width:800px;margin:auto;padding:20px}";
-  html += ".reading{background:#f0f0f0;padding:20px;margin:20px 0;border-radius:8px}";
-  html += ".config{background:#e0e0e0;padding:20px;margin:20px 0;border-radius:8px}";
-  html += "table{width:100%;border-collapse:collapse;margin:10px 0}";
-  html += "td,th{padding:8px;text-align:left;border:1px solid #ddd}";
-  html += ".button{background-color:#4CAF50;border:none;color:white;padding:10px 20px;text-align:center;margin:10px 0;cursor:pointer;border-radius:4px}";
-  html += ".status{padding:10px;margin:10px 0;border-radius:4px}";
-  html += ".success{background-color:#dff0d8;color:#3c763d;border:1px solid #d6e9c6}";
-  html += "</style></head><body>";
-  html += "<h2>Water Level Monitoring System</h2>";
-  
-  html += "<div id='readings'>";
-  html += generateReadingsHtml();
-  html += "</div>";
-  
-  html += "<div class='config'>";
-  html += "<h3>Depth Sensor Calibration</h3>";
-  html += "<form action='/calibrate' method='post'>";
-  html += "<table>";
-  html += "<tr><td>Known Depth (cm):</td><td><input type='number' step='0.1' name='known_depth' required></td></tr>";
-  html += "<tr><td>Current at Depth (mA):</td><td><input type='number' step='0.01' name='known_current' required></td></tr>";
-  html += "</table>";
-  html += "<input type='submit' value='Update Depth Calibration' class='button'>";
-  html += "</form></div>";
-  
-  html += "<div class='config'>";
-  html += "<h3>Turbidity Calibration</h3>";
-  html += "<p>Current Voltage Reading: <span id='currentVoltage'>" + String(readTurbidity().actualVoltage, 3) + "V</span></p>";
-  html += "<div style='margin:20px 0'>";
-  html += "<h4>Automatic Calibration</h4>";
-  html += "<form action='/calibrate_turbidity' method='post'>";
-  html += "<input type='submit' value='Set Current as Clear Water' class='button'>";
-  html += "</form></div>";
-  html += "<div style='margin:20px 0'>";
-  html += "<h4>Manual Calibration</h4>";
-  html += "<form action='/calibrate_turbidity_manual' method='post'>";
-  html += "<table>";
-  html += "<tr><td>Clear Water Voltage (V):</td><td><input type='number' step='0.001' name='clear_water_voltage' value='" + String(clearWaterVoltage, 3) + "' required></td></tr>";
-  html += "</table>";
-  html += "<input type='submit' value='Set Manual Voltage' class='button'>";
-  html += "</form></div>";
-  html += "</div>";
-  
-  html += "</body></html>";
-  
-  server.send(200, "text/html", html);
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html", (const char*)INDEX_HTML_GZ, INDEX_HTML_GZ_LEN);
 }
 
 void handleCalibrate() {
@@ -237,13 +710,9 @@ void handleCalibrate() {
   float known_current = server.arg("known_current").toFloat();
   
   // Calculate new calibration values
-  g_current_4ma = known_current - ((known_depth / DEPTH_RANGE) * CURRENT_RANGE);
-  g_depth_range = (known_depth / (known_current - g_current_4ma)) * CURRENT_RANGE;
-  
-  // Save to EEPROM
-  EEPROM.writeFloat(ADDR_CURRENT_4MA, g_current_4ma);
-  EEPROM.writeFloat(ADDR_DEPTH_RANGE, g_depth_range);
-  EEPROM.commit();
+  nodeConfig.current4ma = known_current - ((known_depth / DEPTH_RANGE) * CURRENT_RANGE);
+  nodeConfig.depthRange = (known_depth / (known_current - nodeConfig.current4ma)) * CURRENT_RANGE;
+  configChanged();
   
   server.sendHeader("Location", "/");
   server.send(303);
@@ -251,28 +720,140 @@ void handleCalibrate() {
 
 void handleTurbidityCalibration() {
   TurbidityReading currentReading = readTurbidity();
-  clearWaterVoltage = currentReading.actualVoltage;
-  EEPROM.writeFloat(ADDR_CLEAR_WATER_VOLTAGE, clearWaterVoltage);
-  EEPROM.commit();
+  nodeConfig.clearWaterVoltage = currentReading.actualVoltage;
+  configChanged();
+  
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+// Load the config record, or on first boot after an update migrate the
+// legacy EEPROM fields into it. Falls back to defaults per field.
+void loadConfiguration() {
+  if (!configStore.begin()) {
+    Serial.println("No configuration record, migrating EEPROM");
+    EEPROM.begin(EEPROM_SIZE);
+    nodeConfig.current4ma = EEPROM.readFloat(ADDR_CURRENT_4MA);
+    nodeConfig.depthRange = EEPROM.readFloat(ADDR_DEPTH_RANGE);
+    nodeConfig.clearWaterVoltage = EEPROM.readFloat(ADDR_CLEAR_WATER_VOLTAGE);
+    EEPROM.get(ADDR_DEPTH_CURVE, nodeConfig.depthCurve);
+    EEPROM.get(ADDR_TURBIDITY_CURVE, nodeConfig.turbidityCurve);
+    EEPROM.end();
+    configStore.markDirty();
+  }
+  
+  if (isnan(nodeConfig.current4ma) || nodeConfig.current4ma < 0 || nodeConfig.current4ma > 20) {
+    nodeConfig.current4ma = CURRENT_4MA;
+  }
+  if (isnan(nodeConfig.depthRange) || nodeConfig.depthRange <= 0 || nodeConfig.depthRange > 1000) {
+    nodeConfig.depthRange = DEPTH_RANGE;
+  }
+  if (isnan(nodeConfig.clearWaterVoltage) || nodeConfig.clearWaterVoltage <= 0 || nodeConfig.clearWaterVoltage > 3.3) {
+    nodeConfig.clearWaterVoltage = CLEAR_WATER_VOLTAGE;
+  }
+  if (!nodeConfig.depthCurve.valid()) nodeConfig.depthCurve.clear();
+  if (!nodeConfig.turbidityCurve.valid()) nodeConfig.turbidityCurve.clear();
+  
+  compileCalibration();
+}
+
+// Rebuild both lookup tables. Channels with fewer than two points fall
+// back to the straight lines of the single-point calibration.
+void compileCalibration() {
+  xSemaphoreTake(calibrationMutex, portMAX_DELAY);
+  pipeline.compile(nodeConfig.depthCurve, nodeConfig.current4ma, nodeConfig.depthRange,
+                   nodeConfig.turbidityCurve, nodeConfig.clearWaterVoltage);
+  xSemaphoreGive(calibrationMutex);
+}
+
+// Handlers only touch RAM; configStore.service() in the web task writes the
+// record once the edits have settled
+void configChanged() {
+  configStore.markDirty();
+  compileCalibration();
+}
+
+CalibrationCurve* curveForRequest() {
+  String channel = server.arg("channel");
+  if (channel == "depth") return &nodeConfig.depthCurve;
+  if (channel == "turbidity") return &nodeConfig.turbidityCurve;
+  return nullptr;
+}
+
+// Adds the live reading of a channel as a point for the value the
+// reference instrument shows
+void handleCalibrationPoint() {
+  CalibrationCurve* curve = curveForRequest();
+  if (!curve || !server.hasArg("value")) {
+    server.send(400, "text/plain", "Bad Request");
+    return;
+  }
+  
+  // A calibration point deserves the full sample budget
+  float raw = 0;
+  acquisition.mean(curve == &nodeConfig.depthCurve ? levelChannel : turbidityChannel, MAX_SAMPLES, raw);
+  if (!curve->addPoint(lroundf(raw), server.arg("value").toFloat())) {
+    server.send(409, "text/plain", "Calibration table full");
+    return;
+  }
+  configChanged();
   
   server.sendHeader("Location", "/");
   server.send(303);
 }
 
-void loadCalibrationValues() {
-  g_current_4ma = EEPROM.readFloat(ADDR_CURRENT_4MA);
-  g_depth_range = EEPROM.readFloat(ADDR_DEPTH_RANGE);
-  float savedClearWaterVoltage = EEPROM.readFloat(ADDR_CLEAR_WATER_VOLTAGE);
+void handleCalibrationFit() {
+  CalibrationCurve* curve = curveForRequest();
+  if (!curve) {
+    server.send(400, "text/plain", "Bad Request");
+    return;
+  }
   
-  if (isnan(g_current_4ma) || g_current_4ma < 0 || g_current_4ma > 20) {
-    g_current_4ma = CURRENT_4MA;
+  String fit = server.arg("fit");
+  if (fit == "poly2") {
+    curve->setFit(CalibrationCurve::FIT_POLYNOMIAL, 2);
+  } else if (fit == "poly3") {
+    curve->setFit(CalibrationCurve::FIT_POLYNOMIAL, 3);
+  } else {
+    curve->setFit(CalibrationCurve::FIT_PIECEWISE, 1);
   }
-  if (isnan(g_depth_range) || g_depth_range <= 0 || g_depth_range > 1000) {
-    g_depth_range = DEPTH_RANGE;
+  configChanged();
+  
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+void handleCalibrationReset() {
+  CalibrationCurve* curve = curveForRequest();
+  if (!curve) {
+    server.send(400, "text/plain", "Bad Request");
+    return;
   }
-  if (!isnan(savedClearWaterVoltage) && savedClearWaterVoltage > 0) {
-    clearWaterVoltage = savedClearWaterVoltage;
+  curve->clear();
+  configChanged();
+  
+  server.sendHeader("Location", "/");
+  server.send(303);
+}
+
+void sendCurveJson(const char* name, const CalibrationCurve& curve) {
+  response.printf("\"%s\":{\"fit\":\"%s\",\"degree\":%u,\"points\":[", name,
+                  curve.fit() == CalibrationCurve::FIT_POLYNOMIAL ? "polynomial" : "piecewise",
+                  curve.degree());
+  for (uint8_t i = 0; i < curve.count(); i++) {
+    response.printf("%s[%u,%.3f]", i ? "," : "", curve.point(i).raw, curve.point(i).value);
   }
+  response.print("]}");
+}
+
+void handleApiCalibration() {
+  response.begin(200, "application/json");
+  response.print("{");
+  sendCurveJson("depth", nodeConfig.depthCurve);
+  response.print(",");
+  sendCurveJson("turbidity", nodeConfig.turbidityCurve);
+  response.print("}");
+  response.end();
 }
 
 //trubid manual calibration
@@ -286,9 +867,8 @@ void handleTurbidityCalibrationManual() {
   
   // Validate the input
   if (newVoltage > 0 && newVoltage <= 3.3) {  // 3.3V is max for ESP32
-    clearWaterVoltage = newVoltage;
-    EEPROM.writeFloat(ADDR_CLEAR_WATER_VOLTAGE, clearWaterVoltage);
-    EEPROM.commit();
+    nodeConfig.clearWaterVoltage = newVoltage;
+    configChanged();
   }
   
   server.sendHeader("Location", "/");
@@ -296,15 +876,24 @@ void handleTurbidityCalibrationManual() {
 }
 
 void setupCalibration() {
-  EEPROM.begin(EEPROM_SIZE);
-  loadCalibrationValues();
+  loadConfiguration();
   setupWiFiAP();
   
-  server.on("/", handleRoot);
-  server.on("/readings", handleReadings);
-  server.on("/calibrate", handleCalibrate);
-  server.on("/calibrate_turbidity", HTTP_POST, handleTurbidityCalibration);
-  server.on("/calibrate_turbidity_manual", HTTP_POST, handleTurbidityCalibrationManual);  // Add this line
+  server.on("/", timed(handleRoot));
+  server.on("/readings", timed(handleReadings));
+  server.on("/api/readings", timed(handleApiReadings));
+  server.on("/events", timed(handleEvents));
+  server.on("/calibrate", timed(handleCalibrate));
+  server.on("/calibrate_point", HTTP_POST, timed(handleCalibrationPoint));
+  server.on("/calibrate_fit", HTTP_POST, timed(handleCalibrationFit));
+  server.on("/calibrate_reset", HTTP_POST, timed(handleCalibrationReset));
+  server.on("/api/calibration", timed(handleApiCalibration));
+  server.on("/api/tasks", timed(handleApiTasks));
+#if METRICS_ENABLED
+  server.on("/metrics", handleMetrics);
+#endif
+  server.on("/calibrate_turbidity", HTTP_POST, timed(handleTurbidityCalibration));
+  server.on("/calibrate_turbidity_manual", HTTP_POST, timed(handleTurbidityCalibrationManual));  // Add this line
   server.begin();
 }
 
@@ -312,74 +901,191 @@ void setup() {
   Serial.begin(115200);
   while (!Serial);
   Serial.println("LoRa Water Monitoring System - Sender");
+  calibrationMutex = xSemaphoreCreateMutex();
   
   analogReadResolution(12);
   analogSetAttenuation(ADC_11db);
+  setupAcquisition();
   
-  tempSensor.begin();
+  esp_sleep_wakeup_cause_t wakeCause = esp_sleep_get_wakeup_cause();
+  bool restored = LOW_POWER_MODE && restoreRtcState();
+  
+  if (restored) {
+    tempProbes.begin(rtcState.probes, rtcState.probeCount);
+  } else {
+    tempProbes.begin();
+    countBoot();
+  }
+  
+  // Collect the first conversion so the first packet carries a temperature
+  unsigned long tempStart = millis();
+  while (tempProbes.count() > 0 && !tempProbes.poll() && millis() - tempStart < 1000) {
+    delay(10);
+  }
   
   LoRa.setPins(LORA_SS, LORA_RST, LORA_DIO0);
   
-  while (!LoRa.begin(915E6)) {
+  while (!LoRa.begin(RADIO_FREQUENCY)) {
     Serial.println(".");
     delay(500);
   }
   
-  LoRa.setTxPower(20);
-  LoRa.setSignalBandwidth(500E3);
-  LoRa.setSpreadingFactor(7);
-  LoRa.setCodingRate4(5);
-  LoRa.setSyncWord(0xF0);
-  LoRa.enableCrc();
+  uplink.begin();
+  
+  // Timer wake (or first power-up) in low-power mode: one measurement
+  // cycle and straight back to sleep
+  if (LOW_POWER_MODE && wakeCause != ESP_SLEEP_WAKEUP_EXT0) {
+    if (!restored) {
+      loadConfiguration();
+    }
+    measureAndSend();
+    enterDeepSleep();
+  }
   
   setupCalibration();
+  portalStart = millis();
   
   Serial.println("LoRa Initializing OK!");
+  printAirtimeComparison();
+  publishLinkStatus();
+  startTasks();
 }
 
-// In the loop() function, replace handleCalibrationServer() with server.handleClient()
+// Milliseconds on the RTC-backed system clock, which keeps running through
+// deep sleep, so batch ages and retransmit timers stay valid across wakes.
+unsigned long nodeMillis() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (unsigned long)((uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
 
-void loop() {
-  float current = readCurrentMA();
-  float depth = convertToDepth(current);
-  float temperature = readTemperature();
-  TurbidityReading turbidity = readTurbidity();
+// One NVS write per restart (not per deep-sleep wake)
+void countBoot() {
+  Preferences prefs;
+  prefs.begin("boot", false);
+  uint32_t boots = prefs.getUInt("count", 0) + 1;
+  prefs.putUInt("count", boots);
+  prefs.end();
+  uplink.setEpoch(boots & FRAME_EPOCH_MASK);
   
-  String dataPacket = "{\"current\":";
-  dataPacket += String(current, 2);
-  dataPacket += ",\"depth\":";
-  dataPacket += String(depth, 1);
-  dataPacket += ",\"temp\":";
-  dataPacket += String(temperature, 1);
-  dataPacket += ",\"turb_v\":";
-  dataPacket += String(turbidity.actualVoltage, 2);
-  dataPacket += ",\"turb_ntu\":";
-  dataPacket += String(turbidity.ntu, 1);
-  dataPacket += ",\"id\":1}";
-
-  Serial.print("Packet size: ");
-  Serial.print(dataPacket.length());
-  Serial.println(" bytes");
-
-  Serial.println("Attempting to send packet...");
-  
-  LoRa.beginPacket();
-  LoRa.print(dataPacket);
-  bool transmitted = LoRa.endPacket();
-  delay(50);
-  
-  if (transmitted) {
-    Serial.println("✓ Packet transmitted successfully");
-  } else {
-    Serial.println("✗ Transmission failed!");
+  Serial.print("Boot #");
+  Serial.print(boots);
+  Serial.print(", epoch ");
+  Serial.println(boots & FRAME_EPOCH_MASK);
+}
+
+bool restoreRtcState() {
+  if (rtcState.magic != RTC_STATE_MAGIC) return false;
+  
+  nodeConfig = rtcState.config;
+  compileCalibration();
+  uplink.restoreState(rtcState.uplink);
+  pipeline.depthFilter().restoreState(rtcState.depthFilter);
+  pipeline.turbidityFilter().restoreState(rtcState.turbidityFilter);
+  rtcState.wakeCount++;
+  
+  Serial.print("Wake #");
+  Serial.print(rtcState.wakeCount);
+  Serial.print(", last awake ");
+  Serial.print(rtcState.lastAwakeMs);
+  Serial.print(" ms, average ");
+  Serial.print(rtcState.totalAwakeMs / rtcState.wakeCount);
+  Serial.println(" ms");
+  return true;
+}
+
+void saveRtcState() {
+  if (rtcState.magic != RTC_STATE_MAGIC) {
+    rtcState.wakeCount = 0;
+    rtcState.lastAwakeMs = 0;
+    rtcState.totalAwakeMs = 0;
+  }
+  rtcState.config = nodeConfig;
+  rtcState.probeCount = tempProbes.count();
+  for (uint8_t i = 0; i < rtcState.probeCount; i++) {
+    memcpy(rtcState.probes[i], tempProbes.address(i), sizeof(DeviceAddress));
   }
+  uplink.saveState(rtcState.uplink);
+  pipeline.depthFilter().saveState(rtcState.depthFilter);
+  pipeline.turbidityFilter().saveState(rtcState.turbidityFilter);
+  rtcState.magic = RTC_STATE_MAGIC;
+}
+
+void enterDeepSleep() {
+  if (configStore.dirty()) configStore.commit();
+  saveRtcState();
+  acquisition.end();
+  radio.sleep();
+  
+  uint32_t awakeMs = millis();
+  rtcState.lastAwakeMs = awakeMs;
+  rtcState.totalAwakeMs += awakeMs;
+  Serial.print("Wake-to-sleep: ");
+  Serial.print(awakeMs);
+  Serial.print(" ms, sleeping ");
+  Serial.print(SLEEP_INTERVAL_S);
+  Serial.println(" s");
+  Serial.flush();
+  
+  esp_sleep_enable_timer_wakeup((uint64_t)SLEEP_INTERVAL_S * 1000000ULL);
+  rtc_gpio_pullup_en((gpio_num_t)WAKE_BUTTON_PIN);
+  rtc_gpio_pulldown_dis((gpio_num_t)WAKE_BUTTON_PIN);
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)WAKE_BUTTON_PIN, 0);
+  esp_deep_sleep_start();
+}
+
+// Compare the binary frame against the legacy JSON packet at the current
+// radio settings, using a representative reading.
+void printAirtimeComparison() {
+  char legacy[128];
+  int legacyLength = snprintf(legacy, sizeof(legacy),
+    "{\"current\":%.2f,\"depth\":%.1f,\"temp\":%.1f,\"turb_v\":%.2f,\"turb_ntu\":%.1f,\"id\":%d}",
+    12.34, 234.5, 27.5, 1.23, 456.7, NODE_ID);
+  
+  uint32_t binaryUs = uplink.frameAirtimeUs(FRAME_READING_SIZE);
+  uint32_t legacyUs = uplink.frameAirtimeUs(legacyLength);
+  
+  Serial.println("\n--- Time on Air ---");
+  Serial.print("Binary frame: ");
+  Serial.print(FRAME_READING_SIZE);
+  Serial.print(" bytes, ");
+  Serial.print(binaryUs / 1000.0, 2);
+  Serial.println(" ms");
+  Serial.print("Legacy JSON: ");
+  Serial.print(legacyLength);
+  Serial.print(" bytes, ");
+  Serial.print(legacyUs / 1000.0, 2);
+  Serial.println(" ms");
+  Serial.println("--------------------\n");
+}
+
+// Acquisition side of a measurement cycle: read, filter, publish the
+// snapshot and log the reading. Returns the frame for the radio.
+FrameReading measure() {
+  LevelReading level = readLevel();
+  TurbidityReading turbidity = readTurbidity();
+  filterReadings(level, turbidity);
+  float current = level.current;
+  float depth = level.depth;
+  float temperature = readTemperature();
+  
+  FrameReading reading = pipeline.frame(level, temperature, turbidity);
+  const FilterState& depthState = pipeline.depthFilter().state();
+  const FilterState& turbidityState = pipeline.turbidityFilter().state();
+  updateSnapshot(level, temperature, turbidity);
 
   Serial.println("\n--- Sensor Readings ---");
   Serial.print("Water Level - Current: ");
   Serial.print(current, 2);
   Serial.print(" mA, Depth: ");
   Serial.print(depth, 1);
-  Serial.println(" cm");
+  Serial.print(" cm (raw ");
+  Serial.print(depthState.input, 1);
+  Serial.print(" +/- ");
+  Serial.print(level.depthCi, 2);
+  Serial.print(", n=");
+  Serial.print(level.samples);
+  Serial.println(depthState.gated ? ", gated)" : ")");
   
   Serial.print("Temperature: ");
   if(temperature != -127) {
@@ -388,28 +1094,349 @@ void loop() {
   } else {
     Serial.println("Error reading temperature");
   }
+  for (uint8_t i = 1; i < tempProbes.count(); i++) {
+    Serial.print("Temperature ");
+    Serial.print(i + 1);
+    Serial.print(": ");
+    Serial.print(tempProbes.celsius(i), 1);
+    Serial.println(" °C");
+  }
   
   Serial.print("Turbidity - Raw ADC: ");
   Serial.print(turbidity.rawADC);
   Serial.print(", Actual Voltage: ");
   Serial.print(turbidity.actualVoltage, 2);
   Serial.print("V, NTU: ");
-  Serial.println(turbidity.ntu, 1);
+  Serial.print(turbidity.ntu, 1);
+  Serial.print(" (raw ");
+  Serial.print(turbidityState.input, 1);
+  Serial.print(" +/- ");
+  Serial.print(turbidity.ntuCi, 2);
+  Serial.print(", n=");
+  Serial.print(turbidity.samples);
+  Serial.println(turbidityState.gated ? ", gated)" : ")");
   
-  Serial.print("Packet sent: ");
-  Serial.println(dataPacket);
   Serial.println("--------------------");
+  return reading;
+}
+
+// Radio side of a measurement cycle: queue the reading and transmit
+// whatever is due, each uplink followed by its receive window.
+void sendReading(const FrameReading& reading, uint32_t capturedAt) {
+  uplink.queue(reading, capturedAt);
+  
+  if (!uplink.batchDue(nodeMillis())) {
+    Serial.print("Reading queued for batch (");
+    Serial.print(uplink.batchCount());
+    Serial.print("/");
+    Serial.print(BATCH_SIZE);
+    Serial.println(")");
+  }
+  serviceUplink();
+}
+
+void serviceUplink() {
+  while (uplink.service(nodeMillis())) {
+    delay(1);
+  }
+  publishLinkStatus();
+}
+
+// One synchronous cycle for a timer wake, before any task exists
+void measureAndSend() {
+  FrameReading reading = measure();
+  sendReading(reading, nodeMillis());
+}
+
+void publishLinkStatus() {
+  LinkStatus status;
+  status.stats = uplink.sender().stats();
+  status.pending = uplink.sender().pending();
+  status.profile = uplink.profile();
+  status.uplinksSinceDownlink = uplink.uplinksSinceDownlink();
+  status.rssi = uplink.rssi();
+  status.airtime = uplink.dutyCycle().stats();
+  status.airtimeWindowUs = uplink.dutyCycle().usedUs(RADIO_FREQUENCY, nodeMillis());
+  status.airtimeLimitUs = uplink.dutyCycle().limitUs(RADIO_FREQUENCY);
+  linkStatus.write(status);
+}
+
+void acquisitionTask(void* arg) {
+  unsigned long lastMeasure = 0;
+  unsigned long lastLive = 0;
+  for (;;) {
+    parkIfStopping(TASK_ACQ);
+    int64_t start = esp_timer_get_time();
+    METRIC_STAMP(pollStart);
+    if (tempProbes.poll()) {
+      METRIC_SINCE(temperatureLatency, pollStart);
+    }
+    
+    if (lastMeasure == 0 || millis() - lastMeasure >= MEASURE_INTERVAL_MS) {
+      lastMeasure = millis();
+      lastLive = lastMeasure;
+      PendingReading pending;
+      pending.reading = measure();
+      pending.capturedAt = nodeMillis();
+      // A radio stuck in a long retransmit run must not stall sampling
+      if (xQueueSend(readingQueue, &pending, 0) != pdTRUE) {
+        droppedReadings++;
+        Serial.println("Radio busy, reading dropped");
+      }
+    } else if (liveClients > 0 && millis() - lastLive >= LIVE_INTERVAL_MS) {
+      lastLive = millis();
+      publishLiveSample();
+    }
+    
+    taskWorked(TASK_ACQ, start);
+    vTaskDelay(pdMS_TO_TICKS(ACQ_POLL_MS));
+  }
+}
 
+void radioTask(void* arg) {
+  for (;;) {
+    parkIfStopping(TASK_RADIO);
+    PendingReading pending;
+    bool received = xQueueReceive(readingQueue, &pending, pdMS_TO_TICKS(RADIO_POLL_MS)) == pdTRUE;
+    int64_t start = esp_timer_get_time();
+    
+    if (received) {
+      sendReading(pending.reading, pending.capturedAt);
+    } else if (uplink.sender().pending() > 0 || uplink.batchCount() > 0) {
+      // Retries and deferred readings come due between measurement cycles too
+      serviceUplink();
+    }
+    
+    taskWorked(TASK_RADIO, start);
+  }
+}
+
+void webTask(void* arg) {
+  uint32_t publishedVersion = 0;
+  for (;;) {
+    parkIfStopping(TASK_WEB);
+    int64_t start = esp_timer_get_time();
+    
+    server.handleClient();
+    events.maintain();
+    liveClients = events.clients();
+    
+    uint32_t version = latestSnapshot.version();
+    if (version != publishedVersion) {
+      publishedVersion = version;
+      publishSnapshot();
+    }
+    configStore.service();
+    
+    taskWorked(TASK_WEB, start);
+    vTaskDelay(pdMS_TO_TICKS(WEB_POLL_MS));
+  }
+}
+
+void startTasks() {
+  readingQueue = xQueueCreate(READING_QUEUE_LENGTH, sizeof(PendingReading));
+  parkedTasks = xEventGroupCreate();
+  
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    TaskInfo& t = tasks[i];
+    if (xTaskCreatePinnedToCore(t.entry, t.name, t.stackSize, NULL, t.priority, &t.handle, t.core) != pdPASS) {
+      Serial.print("Error: Could not start task ");
+      Serial.println(t.name);
+    }
+  }
+}
+
+// Wait until every task has parked, so nothing touches the radio, the
+// config store or the probes while they are put to sleep
+void stopTasks() {
+  stopRequested = true;
+  EventBits_t all = (1 << TASK_COUNT) - 1;
+  if ((xEventGroupWaitBits(parkedTasks, all, pdFALSE, pdTRUE, pdMS_TO_TICKS(5000)) & all) != all) {
+    Serial.println("Warning: tasks did not park");
+  }
+}
+
+void parkIfStopping(uint8_t index) {
+  if (!stopRequested) return;
+  xEventGroupSetBits(parkedTasks, 1 << index);
+  vTaskSuspend(NULL);
+}
+
+void taskWorked(uint8_t index, int64_t start) {
+  TaskInfo& t = tasks[index];
+  t.busyUs += esp_timer_get_time() - start;
+  t.busyMs += t.busyUs / 1000;
+  t.busyUs %= 1000;
+  t.loops++;
+}
+
+// Busy share over the last interval and the stack never touched so far;
+// on the ESP32 the watermark is in bytes
+void printTaskStats() {
+  static uint32_t lastBusyMs[TASK_COUNT];
+  static unsigned long lastPrint = 0;
+  unsigned long now = millis();
+  unsigned long interval = now - lastPrint;
+  
+  Serial.println("--- Tasks ---");
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    TaskInfo& t = tasks[i];
+    if (!t.handle) continue;
+    uint32_t busyMs = t.busyMs;
+    Serial.print(t.name);
+    Serial.print(": core ");
+    Serial.print(t.core);
+    Serial.print(", busy ");
+    Serial.print(interval ? 100.0 * (busyMs - lastBusyMs[i]) / interval : 0, 1);
+    Serial.print(" %, stack free ");
+    Serial.print(uxTaskGetStackHighWaterMark(t.handle));
+    Serial.print("/");
+    Serial.print(t.stackSize);
+    Serial.print(" bytes, loops ");
+    Serial.println(t.loops);
+    lastBusyMs[i] = busyMs;
+  }
+  Serial.print("Readings dropped: ");
+  Serial.println(droppedReadings);
+  Serial.println("--------------------\n");
+  lastPrint = now;
+}
+
+void handleApiTasks() {
+  response.begin(200, "application/json");
+  response.printf("{\"uptime_ms\":%lu,\"dropped\":%lu,\"tasks\":[",
+                  millis(), (unsigned long)droppedReadings);
+  for (uint8_t i = 0; i < TASK_COUNT; i++) {
+    const TaskInfo& t = tasks[i];
+    response.printf("%s{\"name\":\"%s\",\"core\":%d,\"priority\":%u,\"stack\":%lu,"
+                    "\"stack_free\":%u,\"busy_ms\":%lu,\"loops\":%lu}",
+                    i ? "," : "", t.name, (int)t.core, (unsigned)t.priority,
+                    (unsigned long)t.stackSize,
+                    t.handle ? (unsigned)uxTaskGetStackHighWaterMark(t.handle) : 0,
+                    (unsigned long)t.busyMs, (unsigned long)t.loops);
+  }
+  response.print("]}");
+  response.end();
+}
+
+// Wraps a web handler so its run time lands in httpLatency. /metrics
+// itself is left out, so scrapes do not show up in what they measure.
+WebServer::THandlerFunction timed(void (*handler)()) {
+  return [handler]() {
+    METRIC_COUNT(httpRequests);
+    METRIC_TIME(httpLatency);
+    handler();
+  };
+}
+
+#if METRICS_ENABLED
+// Prometheus text format: the per-stage histograms and counters, then the
+// link, airtime and queue statistics the firmware keeps anyway
+void handleMetrics() {
+  LinkStatus status;
+  linkStatus.read(status);
+  
+  response.begin(200, "text/plain; version=0.0.4");
+  metricsWrite(response);
+  
+  char text[192];
+  const struct {
+    const char* name;
+    const char* type;
+    const char* help;
+    double value;
+  } values[] = {
+    { "tx_frames_sent_total", "counter", "Reliable frames handed to the radio", (double)status.stats.sent },
+    { "tx_frames_acked_total", "counter", "Reliable frames acknowledged by the gateway", (double)status.stats.acked },
+    { "tx_retransmits_total", "counter", "Retransmissions after a missing ACK", (double)status.stats.retries },
+    { "tx_frames_lost_total", "counter", "Frames given up after the last retry", (double)status.stats.lost },
+    { "tx_frames_pending", "gauge", "Frames waiting for an ACK", (double)status.pending },
+    { "tx_readings_dropped_total", "counter", "Readings dropped while the radio task was busy", (double)droppedReadings },
+    { "tx_airtime_seconds_total", "counter", "Time on air since boot", status.airtime.airtimeUs / 1e6 },
+    { "tx_airtime_window_seconds", "gauge", "Time on air in the duty-cycle window", status.airtimeWindowUs / 1e6 },
+    { "tx_airtime_deferred_total", "counter", "Sends held back by the airtime budget", (double)status.airtime.deferred },
+    { "tx_radio_profile", "gauge", "Radio profile chosen by ADR", (double)status.profile },
+    { "tx_rssi_dbm", "gauge", "RSSI of the last downlink", (double)status.rssi },
+    { "tx_heap_free_bytes", "gauge", "Free heap", (double)ESP.getFreeHeap() },
+  };
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    metricsFormatValue(text, sizeof(text), values[i].name, values[i].type, values[i].help, values[i].value);
+    response.print(text);
+  }
+  response.end();
+}
+#endif
+
+void printLinkStatus() {
+  LinkStatus status;
+  linkStatus.read(status);
+  Serial.println("\n--- LoRa Status ---");
+  Serial.print("RSSI: ");
+  Serial.print(status.rssi);
+  Serial.println(" dBm");
+  Serial.print("Profile: ");
+  Serial.print(status.profile);
+  Serial.print(", uplinks since downlink: ");
+  Serial.println(status.uplinksSinceDownlink);
+  if (RELIABLE_MODE) {
+    const ReliableSenderStats& link = status.stats;
+    Serial.print("Link: sent ");
+    Serial.print(link.sent);
+    Serial.print(", acked ");
+    Serial.print(link.acked);
+    Serial.print(", retries ");
+    Serial.print(link.retries);
+    Serial.print(", lost ");
+    Serial.print(link.lost);
+    Serial.print(", pending ");
+    Serial.println(status.pending);
+  }
+  const DutyCycleStats& air = status.airtime;
+  Serial.print("Airtime: ");
+  Serial.print(status.airtimeWindowUs / 1e6, 1);
+  Serial.print(" s in window");
+  if (status.airtimeLimitUs != DutyCycle::NEVER) {
+    Serial.print(" of ");
+    Serial.print(status.airtimeLimitUs / 1e6, 0);
+    Serial.print(" s");
+  }
+  Serial.print(", ");
+  Serial.print(air.airtimeUs / 1e6, 1);
+  Serial.print(" s total over ");
+  Serial.print(air.frames);
+  Serial.print(" frames, longest ");
+  Serial.print(air.maxFrameUs / 1000.0, 1);
+  Serial.print(" ms, deferred ");
+  Serial.print(air.deferred);
+  if (air.overDwell > 0) {
+    Serial.print(", over dwell limit ");
+    Serial.print(air.overDwell);
+  }
+  Serial.println();
+  Serial.print("Heap: free ");
+  Serial.print(ESP.getFreeHeap());
+  Serial.print(", minimum ");
+  Serial.print(ESP.getMinFreeHeap());
+  Serial.print(", largest block ");
+  Serial.println(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  Serial.println("--------------------\n");
+}
+
+// The work runs in the tasks started by setup(); loop() only reports and
+// ends a portal session
+void loop() {
   static unsigned long lastParamPrint = 0;
   if (millis() - lastParamPrint > 10000) {
-    Serial.println("\n--- LoRa Status ---");
-    Serial.print("RSSI: ");
-    Serial.print(LoRa.packetRssi());
-    Serial.println(" dBm");
-    Serial.println("--------------------\n");
+    printLinkStatus();
+    printTaskStats();
     lastParamPrint = millis();
   }
-
-  server.handleClient(); // Changed this line from handleCalibrationServer()
-  delay(2000);
-}
\ No newline at end of file
+  
+  // Portal session after a button wake ends back in deep sleep
+  if (LOW_POWER_MODE && millis() - portalStart >= PORTAL_TIMEOUT_MS) {
+    Serial.println("Calibration portal timeout");
+    stopTasks();
+    enterDeepSleep();
+  }
+  delay(100);
+}
@@ -0,0 +1,66 @@
+"""Compress web/ pages into PROGMEM headers under include/.
+
+Runs as a PlatformIO pre-build script (see extra_scripts in platformio.ini)
+and can also be run by hand: python tools/embed_web.py
+"""
+
+import gzip
+import os
+import re
+
+PAGES = [
+    ("web/index.html", "include/index_html_gz.h", "INDEX_HTML_GZ"),
+]
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def minify(html):
+    # Leading indentation and blank lines are all that is safe to drop
+    lines = (line.strip() for line in html.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def embed(root, source, target, symbol):
+    with open(os.path.join(root, source), encoding="utf-8") as f:
+        html = minify(f.read())
+
+    # mtime=0 keeps the output identical between builds
+    data = gzip.compress(html.encode("utf-8"), compresslevel=9, mtime=0)
+
+    guard = re.sub(r"[^A-Z0-9]", "_", os.path.basename(target).upper())
+    lines = [
+        "// Generated by tools/embed_web.py from %s - do not edit." % source,
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        "#include <Arduino.h>",
+        "",
+        "const size_t %s_LEN = %d;" % (symbol, len(data)),
+        "const uint8_t %s[] PROGMEM = {" % symbol,
+    ]
+    for i in range(0, len(data), 16):
+        chunk = ", ".join("0x%02x" % b for b in data[i:i + 16])
+        lines.append("  %s," % chunk)
+    lines += ["};", "", "#endif", ""]
+    output = "\r\n".join(lines)
+
+    path = os.path.join(root, target)
+    if os.path.exists(path):
+        with open(path, encoding="utf-8", newline="") as f:
+            if f.read() == output:
+                return
+    with open(path, "w", encoding="utf-8", newline="") as f:
+        f.write(output)
+    print("embed_web: %s -> %s (%d bytes gzipped)" % (source, target, len(data)))
+
+
+root = project_dir()
+for source, target, symbol in PAGES:
+    embed(root, source, target, symbol)
@@ -0,0 +1,25 @@
+#include "SimAdc.h"
+
+SimAdc::SimAdc(SimClock& clock, SimRandom& random)
+  : _clock(clock), _random(random), _reads(0) {
+  for (uint8_t i = 0; i < MAX_PINS; i++) {
+    _signals[i] = nullptr;
+    _noise[i] = 0;
+  }
+}
+
+void SimAdc::setSignal(uint8_t pin, Signal signal, float noiseCounts) {
+  if (pin >= MAX_PINS) return;
+  _signals[pin] = signal;
+  _noise[pin] = noiseCounts;
+}
+
+uint16_t SimAdc::read(uint8_t pin) {
+  _reads++;
+  if (pin >= MAX_PINS || !_signals[pin]) return 0;
+
+  float counts = _signals[pin](pin, _clock.micros()) + _noise[pin] * _random.gaussian();
+  if (counts < 0) return 0;
+  if (counts > 4095) return 4095;
+  return (uint16_t)(counts + 0.5f);
+}
@@ -0,0 +1,29 @@
+#ifndef SIM_ADC_H
+#define SIM_ADC_H
+
+#include <AdcSource.h>
+#include "SimClock.h"
+
+// AdcSource for the host: each pin follows a signal function of simulated
+// time (in ADC counts) plus gaussian noise, clamped to 12 bits.
+class SimAdc : public AdcSource {
+public:
+  typedef float (*Signal)(uint8_t pin, uint64_t us);
+  static const uint8_t MAX_PINS = 40;
+
+  SimAdc(SimClock& clock, SimRandom& random);
+
+  void setSignal(uint8_t pin, Signal signal, float noiseCounts);
+
+  uint16_t read(uint8_t pin) override;
+  uint32_t reads() const { return _reads; }
+
+private:
+  SimClock& _clock;
+  SimRandom& _random;
+  Signal _signals[MAX_PINS];
+  float _noise[MAX_PINS];
+  uint32_t _reads;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "SimChannel.h"
+#include <math.h>
+#include <string.h>
+#include <LoRaAirtime.h>
+#include <RadioProfile.h>
+
+// Lowest SNR the SX127x demodulates at each spreading factor
+static float demodulationFloorDb(uint8_t spreadingFactor) {
+  return -2.5f * (spreadingFactor - 4);
+}
+
+SimChannel::SimChannel(SimClock& clock, SimRandom& random, const SimChannelConfig& config)
+  : _clock(clock), _random(random), _config(config), _count(0) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void SimChannel::attach(SimRadio* radio) {
+  if (_count < MAX_RADIOS) _radios[_count++] = radio;
+}
+
+void SimChannel::broadcast(SimRadio* from, const uint8_t* packet, size_t length, uint64_t arrivalUs) {
+  const RadioProfile& p = radioProfile(from->profile());
+  float noise = -174.0f + 10.0f * log10f((float)p.bandwidthHz) + _config.noiseFigureDb;
+
+  for (uint8_t i = 0; i < _count; i++) {
+    SimRadio* to = _radios[i];
+    if (to == from) continue;
+    _stats.sent++;
+
+    if (to->profile() != from->profile()) {
+      _stats.mismatched++;
+      continue;
+    }
+
+    float rssi = p.txPowerDbm - _config.pathLossDb + _config.fadingDb * _random.gaussian();
+    float snr = rssi - noise;
+    if (snr < demodulationFloorDb(p.spreadingFactor)) {
+      _stats.weak++;
+      continue;
+    }
+    if (_random.uniform() < _config.lossProbability) {
+      _stats.dropped++;
+      continue;
+    }
+
+    // Packet RSSI bottoms out at the noise floor, as on the real chip
+    int reported = (int)lroundf(rssi > noise ? rssi : noise);
+    to->deliver(packet, length, arrivalUs, reported, snr);
+    _stats.delivered++;
+  }
+}
+
+SimRadio::SimRadio(SimChannel& channel)
+  : _channel(channel), _head(0), _count(0), _profile(RADIO_PROFILE_SAFE),
+    _listening(false), _listenSinceUs(0), _rssi(0), _snr(0),
+    _airtimeUs(0), _transmissions(0), _missed(0) {
+  channel.attach(this);
+}
+
+bool SimRadio::transmit(const uint8_t* packet, size_t length) {
+  const RadioProfile& p = radioProfile(_profile);
+  uint32_t airtime = loraTimeOnAirUs(length, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+
+  _listening = false;
+  _channel.broadcast(this, packet, length, _channel.clock().micros() + airtime);
+  _channel.clock().advanceUs(airtime);
+  _airtimeUs += airtime;
+  _transmissions++;
+  return true;
+}
+
+size_t SimRadio::receive(uint8_t* buf, size_t cap) {
+  uint64_t now = _channel.clock().micros();
+  if (!_listening) {
+    _listening = true;
+    _listenSinceUs = now;
+  }
+
+  while (_count > 0) {
+    Packet& packet = _inbox[_head];
+    if (packet.arrivalUs > now) return 0;
+
+    _head = (_head + 1) % INBOX_SIZE;
+    _count--;
+    // The preamble went by while the radio was not in receive mode
+    if (packet.arrivalUs < _listenSinceUs) {
+      _missed++;
+      continue;
+    }
+
+    size_t length = packet.length < cap ? packet.length : cap;
+    memcpy(buf, packet.data, length);
+    _rssi = packet.rssi;
+    _snr = packet.snr;
+    return length;
+  }
+  return 0;
+}
+
+void SimRadio::applyProfile(uint8_t index) {
+  _profile = index < RADIO_PROFILE_COUNT ? index : RADIO_PROFILE_SAFE;
+}
+
+void SimRadio::deliver(const uint8_t* packet, size_t length, uint64_t arrivalUs, int rssi, float snr) {
+  if (_count == INBOX_SIZE) {
+    _missed++;
+    return;
+  }
+
+  Packet& slot = _inbox[(_head + _count) % INBOX_SIZE];
+  slot.length = length < MAX_PACKET ? length : MAX_PACKET;
+  memcpy(slot.data, packet, slot.length);
+  slot.arrivalUs = arrivalUs;
+  slot.rssi = rssi;
+  slot.snr = snr;
+  _count++;
+}
@@ -0,0 +1,101 @@
+#ifndef SIM_CHANNEL_H
+#define SIM_CHANNEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <RadioDriver.h>
+#include "SimClock.h"
+
+// Link budget between every pair of radios on the channel. Each packet
+// gets its own fading draw; it arrives when its SNR clears the demodulation
+// floor of the spreading factor, the receiver is on the same profile, and
+// the extra random loss spares it.
+struct SimChannelConfig {
+  float pathLossDb;
+  float fadingDb;            // standard deviation of per-packet fading
+  float noiseFigureDb;
+  float lossProbability;     // interference, collisions
+};
+
+struct SimChannelStats {
+  uint32_t sent;             // packet copies, one per receiver
+  uint32_t delivered;
+  uint32_t weak;             // below the demodulation floor
+  uint32_t mismatched;       // receiver on another profile
+  uint32_t dropped;          // random loss
+};
+
+class SimRadio;
+
+class SimChannel {
+public:
+  static const uint8_t MAX_RADIOS = 4;
+
+  SimChannel(SimClock& clock, SimRandom& random, const SimChannelConfig& config);
+
+  void attach(SimRadio* radio);
+  void broadcast(SimRadio* from, const uint8_t* packet, size_t length, uint64_t arrivalUs);
+
+  SimClock& clock() { return _clock; }
+  SimChannelConfig& config() { return _config; }
+  const SimChannelStats& stats() const { return _stats; }
+
+private:
+  SimClock& _clock;
+  SimRandom& _random;
+  SimChannelConfig _config;
+  SimRadio* _radios[MAX_RADIOS];
+  uint8_t _count;
+  SimChannelStats _stats;
+};
+
+// RadioDriver on a SimChannel. Half duplex like the SX127x: a packet is
+// only received if the radio was listening (polling receive()) from before
+// it arrived, and transmit() advances the shared clock by the time on air.
+class SimRadio : public RadioDriver {
+public:
+  static const uint8_t INBOX_SIZE = 16;
+  static const uint16_t MAX_PACKET = 255;
+
+  explicit SimRadio(SimChannel& channel);
+
+  bool transmit(const uint8_t* packet, size_t length) override;
+  size_t receive(uint8_t* buf, size_t cap) override;
+  int packetRssi() override { return _rssi; }
+  float packetSnr() override { return _snr; }
+  void applyProfile(uint8_t index) override;
+  void idle() override { _listening = false; }
+  void sleep() override { _listening = false; }
+
+  uint8_t profile() const { return _profile; }
+  uint64_t airtimeUs() const { return _airtimeUs; }
+  uint32_t transmissions() const { return _transmissions; }
+  uint32_t missed() const { return _missed; }
+
+  // Called by the channel for a packet that survived the link
+  void deliver(const uint8_t* packet, size_t length, uint64_t arrivalUs, int rssi, float snr);
+
+private:
+  struct Packet {
+    uint8_t data[MAX_PACKET];
+    uint16_t length;
+    uint64_t arrivalUs;
+    int16_t rssi;
+    float snr;
+  };
+
+  SimChannel& _channel;
+  Packet _inbox[INBOX_SIZE];
+  uint8_t _head;
+  uint8_t _count;
+  uint8_t _profile;
+  bool _listening;
+  uint64_t _listenSinceUs;
+  int _rssi;
+  float _snr;
+  uint64_t _airtimeUs;
+  uint32_t _transmissions;
+  uint32_t _missed;          // arrived while transmitting, idle or full
+};
+
+#endif
@@ -0,0 +1,9 @@
+#include "SimClock.h"
+#include <math.h>
+
+float SimRandom::gaussian() {
+  float u1 = uniform();
+  float u2 = uniform();
+  if (u1 < 1e-7f) u1 = 1e-7f;
+  return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
@@ -0,0 +1,45 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdint.h>
+
+// Simulated time, shared by every simulated device. Nothing advances it
+// except the scenario loop and SimRadio::transmit(), which takes as long
+// as the packet's time on air.
+class SimClock {
+public:
+  SimClock() : _us(0) {}
+
+  uint64_t micros() const { return _us; }
+  uint32_t millis() const { return (uint32_t)(_us / 1000); }
+
+  void advanceUs(uint64_t us) { _us += us; }
+  void advanceMs(uint32_t ms) { _us += (uint64_t)ms * 1000; }
+
+private:
+  uint64_t _us;
+};
+
+// Small deterministic generator, so a run is reproducible from its seed.
+class SimRandom {
+public:
+  explicit SimRandom(uint32_t seed) : _state(seed ? seed : 1) {}
+
+  uint32_t next() {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+  }
+
+  // Uniform in [0, 1)
+  float uniform() { return (next() >> 8) / 16777216.0f; }
+
+  // Standard normal, Box-Muller
+  float gaussian();
+
+private:
+  uint32_t _state;
+};
+
+#endif
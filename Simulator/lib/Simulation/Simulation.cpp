@@ -0,0 +1,335 @@
+#include "Simulation.h"
+#include <AcquisitionEngine.h>
+#include <GatewayLink.h>
+#include <NodeTable.h>
+#include <NodeUplink.h>
+#include <RadioProfile.h>
+#include <SensorPipeline.h>
+#include <SimAdc.h>
+#include <SimClock.h>
+#include <SubmersibleFrame.h>
+#include <WindowStats.h>
+
+// Node (TX)
+#define RX_WINDOW_MS 500
+#define ADR_LOST_UPLINKS 8
+#define BATCH_SIZE 8
+#define BATCH_MAX_LATENCY_MS 60000
+
+const float RESISTOR_VALUE = 150.0;
+const uint16_t MIN_SAMPLES = 4;
+const uint16_t MAX_SAMPLES = 64;
+const float LEVEL_TOLERANCE = 1.0;
+const float TURBIDITY_TOLERANCE = 2.0;
+const float CURRENT_4MA = 3.40;
+const float DEPTH_AT_4MA = 0;
+const float CURRENT_RANGE = 16.0;
+const float DEPTH_RANGE = 500.0;
+const float CLEAR_WATER_VOLTAGE = 1.45;
+const float MAX_DEPTH = 10000.0;
+const float MAX_NTU = 3000.0;
+const float PROBE_TEMPERATURE = 24.5;
+const uint32_t SAMPLE_PERIOD_US = 10000;
+const uint32_t MEASURE_INTERVAL_MS = 2000;
+const uint32_t LIVE_INTERVAL_MS = 250;
+
+const FilterConfig SIM_DEPTH_FILTER = { 5, SMOOTH_KALMAN, 0, 0.5, 4.0, 20.0, 3 };
+const FilterConfig SIM_TURBIDITY_FILTER = { 5, SMOOTH_EMA, 10.0, 0, 0, 200.0, 3 };
+
+const SensorFrontEnd FRONT_END = { RESISTOR_VALUE, CURRENT_RANGE, DEPTH_AT_4MA, MAX_DEPTH, MAX_NTU };
+
+const NodeUplinkConfig UPLINK = {
+  SIM_NODE_ID,
+  true,                      // RELIABLE_MODE
+  (uint32_t)RADIO_FREQUENCY,
+  &RADIO_DUTY_REGION,
+  RADIO_AIRTIME_POLICY,
+  BATCH_SIZE,
+  BATCH_MAX_LATENCY_MS,
+  RX_WINDOW_MS,
+  ADR_LOST_UPLINKS
+};
+
+// Gateway (RX)
+#define ADR_DOWNLINK_EVERY 4
+#define ADR_LOST_MS 180000
+#define NODE_ACTIVE_MS 1800000
+#define DOWNLINK_DELAY_MS 20
+#define DOWNLINK_MAX_WAIT_MS 250
+#define NODE_TABLE_SIZE 4
+const uint32_t UPLOAD_INTERVAL_MS = 600000;
+#define WINDOW_SWEEP_MS 10000
+
+const GatewayLinkConfig GATEWAY_LINK = {
+  (uint32_t)RADIO_FREQUENCY,
+  &RADIO_DUTY_REGION,
+  RADIO_AIRTIME_POLICY,
+  ADR_DOWNLINK_EVERY,
+  ADR_LOST_MS,
+  NODE_ACTIVE_MS,
+  DOWNLINK_DELAY_MS,
+  DOWNLINK_MAX_WAIT_MS
+};
+
+float simTrueDepthCm(uint64_t us) {
+  float s = us / 1e6f;
+  float depth = 200.0f + 50.0f * sinf(6.2831853f * s / 3600.0f);
+  if (s >= 1200.0f) depth += 30.0f;
+  return depth;
+}
+
+float simTrueNtu(uint64_t us) {
+  float s = us / 1e6f;
+  return (s >= 2400.0f && s < 2700.0f) ? 500.0f : 100.0f;
+}
+
+// Inverse of the node's default single-point calibration lines
+static float levelSignal(uint8_t pin, uint64_t us) {
+  float current = CURRENT_4MA + simTrueDepthCm(us) / DEPTH_RANGE * CURRENT_RANGE;
+  return current * RESISTOR_VALUE / 1000.0f / 3.3f * 4095.0f;
+}
+
+static float turbiditySignal(uint8_t pin, uint64_t us) {
+  float clearRaw = CLEAR_WATER_VOLTAGE / 3.3f * 4095.0f;
+  return clearRaw * (1.0f - simTrueNtu(us) / MAX_NTU);
+}
+
+class NodeCounters : public NodeUplinkListener {
+public:
+  NodeCounters() : requeued(0), profileChanges(0), _profile(RADIO_PROFILE_SAFE) {}
+
+  void frameRequeued(uint16_t seq, size_t readings) override { requeued++; }
+
+  void profileChanged(uint8_t profile, bool fallback) override {
+    if (profile != _profile) profileChanges++;
+    _profile = profile;
+  }
+
+  uint32_t requeued;
+  uint8_t profileChanges;
+
+private:
+  uint8_t _profile;
+};
+
+// The TX firmware's acquisition and radio tasks in one step function
+class SimNode {
+public:
+  SimNode(SimClock& clock, SimAdc& adc, SimRadio& radio)
+    : _clock(clock), _acquisition(adc),
+      _pipeline(FRONT_END, SIM_DEPTH_FILTER, SIM_TURBIDITY_FILTER),
+      _uplink(radio, UPLINK, _counters), _nextSampleUs(0), _lastMeasure(0), _lastLive(0),
+      _measured(false), _readings(0), _liveSamples(0) {}
+
+  void begin() {
+    _levelChannel = _acquisition.addChannel(SIM_LEVEL_PIN);
+    _turbidityChannel = _acquisition.addChannel(SIM_TURBIDITY_PIN);
+    _acquisition.begin(SAMPLE_PERIOD_US);
+
+    CalibrationCurve none;
+    none.clear();
+    _pipeline.compile(none, CURRENT_4MA, DEPTH_RANGE, none, CLEAR_WATER_VOLTAGE);
+    _uplink.begin();
+  }
+
+  void step(bool portalOpen) {
+    while (_nextSampleUs <= _clock.micros()) {
+      _acquisition.sampleTick();
+      _nextSampleUs += SAMPLE_PERIOD_US;
+    }
+    uint32_t now = _clock.millis();
+
+    if (!_measured || now - _lastMeasure >= MEASURE_INTERVAL_MS) {
+      _measured = true;
+      _lastMeasure = now;
+      _lastLive = now;
+      measure(now);
+    } else if (portalOpen && now - _lastLive >= LIVE_INTERVAL_MS) {
+      _lastLive = now;
+      liveSample();
+    }
+    _uplink.service(now);
+  }
+
+  NodeUplink& uplink() { return _uplink; }
+  const NodeCounters& counters() const { return _counters; }
+  uint32_t readings() const { return _readings; }
+  uint32_t liveSamples() const { return _liveSamples; }
+
+private:
+  void read(LevelReading& level, TurbidityReading& turbidity) {
+    AdaptiveMean levelAdc, turbidityAdc;
+    _acquisition.adaptiveMean(_levelChannel, MIN_SAMPLES, MAX_SAMPLES, LEVEL_TOLERANCE, levelAdc);
+    _acquisition.adaptiveMean(_turbidityChannel, MIN_SAMPLES, MAX_SAMPLES, TURBIDITY_TOLERANCE, turbidityAdc);
+    level = _pipeline.level(levelAdc);
+    turbidity = _pipeline.turbidity(turbidityAdc);
+  }
+
+  void measure(uint32_t now) {
+    LevelReading level;
+    TurbidityReading turbidity;
+    read(level, turbidity);
+    _pipeline.filter(level, turbidity, now);
+    _uplink.queue(_pipeline.frame(level, PROBE_TEMPERATURE, turbidity), now);
+    _readings++;
+  }
+
+  void liveSample() {
+    LevelReading level;
+    TurbidityReading turbidity;
+    read(level, turbidity);
+    _pipeline.estimate(level, turbidity);
+    _liveSamples++;
+  }
+
+  SimClock& _clock;
+  AcquisitionEngine _acquisition;
+  int _levelChannel;
+  int _turbidityChannel;
+  SensorPipeline _pipeline;
+  NodeCounters _counters;
+  NodeUplink _uplink;
+  uint64_t _nextSampleUs;
+  uint32_t _lastMeasure;
+  uint32_t _lastLive;
+  bool _measured;
+  uint32_t _readings;
+  uint32_t _liveSamples;
+};
+
+struct SimNodeState {
+  NodeLink link;
+  NodeWindow window;
+};
+
+// The RX firmware's receive path: duplicates, ACK/ADR and upload windows
+class SimGateway {
+public:
+  SimGateway(SimClock& clock, SimRadio& radio)
+    : _clock(clock), _radio(radio), _link(radio, _nodes, GATEWAY_LINK, _listener),
+      _lastSweep(0), _delivered(0), _windows(0), _windowSamples(0), _ageSumMs(0),
+      _ageMaxMs(0), _depthError(), _ntuError() {}
+
+  void begin() { _link.begin(); }
+
+  void step() {
+    uint32_t now = _clock.millis();
+    _link.service(now);
+
+    uint8_t packet[SimRadio::MAX_PACKET];
+    size_t length = _radio.receive(packet, sizeof(packet));
+    if (length > 0) handleUplink(packet, length, now);
+
+    if (now - _lastSweep >= WINDOW_SWEEP_MS) {
+      for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+        if (_nodes.used(slot)) closeWindow(_nodes.at(slot), now);
+      }
+      _lastSweep = now;
+    }
+  }
+
+  void results(SimulationResults& r) {
+    r.frames = _link.totals();
+    r.gatewayAirtime = _link.dutyCycle().stats();
+    r.delivered = _delivered;
+    r.windows = _windows;
+    r.windowSamples = _windowSamples;
+    for (uint8_t slot = 0; slot < _nodes.capacity(); slot++) {
+      if (_nodes.used(slot)) r.windowSamples += _nodes.at(slot).window.current.samples;
+    }
+    r.meanAgeS = _delivered ? _ageSumMs / 1000.0 / _delivered : 0;
+    r.maxAgeS = _ageMaxMs / 1000.0f;
+    r.depthError = _depthError;
+    r.ntuError = _ntuError;
+  }
+
+private:
+  void handleUplink(const uint8_t* packet, size_t length, uint32_t now) {
+    FrameHeader header;
+    FrameSample samples[FRAME_BATCH_MAX];
+    size_t count = 0;
+    if (frameDecodeUplink(packet, length, header, samples, FRAME_BATCH_MAX, count) != FRAME_OK) return;
+
+    uint8_t slot = _nodes.touch(header.nodeId, now);
+    int rssi = _radio.packetRssi();
+    if (!_link.uplink(slot, header, rssi, _radio.packetSnr(), 0, now)) return;
+
+    SimNodeState& node = _nodes.at(slot);
+    for (size_t i = 0; i < count; i++) {
+      uint32_t ageMs = samples[i].ageDs * 100;
+      uint64_t capturedUs = (uint64_t)(now - ageMs) * 1000;
+      _depthError.add(frameDepthCm(samples[i].reading) - simTrueDepthCm(capturedUs));
+      _ntuError.add(frameTurbNtu(samples[i].reading) - simTrueNtu(capturedUs));
+      _ageSumMs += ageMs;
+      if (ageMs > _ageMaxMs) _ageMaxMs = ageMs;
+
+      SensorData data = {};
+      readingFromFrame(samples[i].reading, data);
+      data.nodeId = header.nodeId;
+      data.rssi = rssi;
+      data.isValid = true;
+      node.window.current.add(data);
+      _delivered++;
+    }
+    closeWindow(node, now);
+  }
+
+  void closeWindow(SimNodeState& node, uint32_t now) {
+    if (node.window.current.samples == 0) return;
+    ReadingWindow finished;
+    if (node.window.close(now, UPLOAD_INTERVAL_MS, finished)) {
+      _windows++;
+      _windowSamples += finished.samples;
+    }
+  }
+
+  SimClock& _clock;
+  SimRadio& _radio;
+  NodeTable<SimNodeState, NODE_TABLE_SIZE> _nodes;
+  GatewayLinkListener _listener;
+  GatewayLink<SimNodeState, NODE_TABLE_SIZE> _link;
+  uint32_t _lastSweep;
+  uint32_t _delivered;
+  uint32_t _windows;
+  uint32_t _windowSamples;
+  double _ageSumMs;
+  uint32_t _ageMaxMs;
+  ErrorStats _depthError;
+  ErrorStats _ntuError;
+};
+
+SimulationResults runSimulation(const SimulationConfig& config) {
+  SimClock clock;
+  SimRandom random(config.seed);
+  SimAdc adc(clock, random);
+  adc.setSignal(SIM_LEVEL_PIN, levelSignal, 3.0);
+  adc.setSignal(SIM_TURBIDITY_PIN, turbiditySignal, 6.0);
+
+  SimChannel channel(clock, random, config.channel);
+  SimRadio nodeRadio(channel);
+  SimRadio gatewayRadio(channel);
+  SimNode node(clock, adc, nodeRadio);
+  SimGateway gateway(clock, gatewayRadio);
+  node.begin();
+  gateway.begin();
+
+  uint64_t endUs = (uint64_t)(config.hours * 3600.0 * 1e6);
+  while (clock.micros() < endUs) {
+    node.step(config.portalOpen);
+    gateway.step();
+    clock.advanceMs(1);
+  }
+
+  SimulationResults r = {};
+  r.readings = node.readings();
+  r.liveSamples = node.liveSamples();
+  r.link = node.uplink().sender().stats();
+  r.nodeAirtime = node.uplink().dutyCycle().stats();
+  r.requeued = node.counters().requeued;
+  r.profileChanges = node.counters().profileChanges;
+  r.nodeProfile = node.uplink().profile();
+  r.channel = channel.stats();
+  r.missed = nodeRadio.missed() + gatewayRadio.missed();
+  gateway.results(r);
+  return r;
+}
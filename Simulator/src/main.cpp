@@ -0,0 +1,184 @@
+// Host simulator: the sensor node's measurement-to-radio pipeline and the
+// gateway's receive/ACK/ADR path, built for Linux and linked by a
+// simulated LoRa channel. Both ends run the firmwares' own libraries (see
+// lib/Simulation); this file only parses options and reports.
+//
+//   pio run -e native -t exec -a "--hours 2 --path-loss 132"
+//
+// Exits with status 1 when fewer than --min-delivery of the readings taken
+// reach the gateway, so a CI job can run it as an end-to-end check;
+// test/test_simulation does the same under pio test.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <AcquisitionEngine.h>
+#include <Calibration.h>
+#include <SignalFilter.h>
+#include <SubmersibleFrame.h>
+#include <LoRaAirtime.h>
+#include <ConfigStore.h>
+#include <SimAdc.h>
+#include <Simulation.h>
+
+#define BATCH_SIZE 8
+#define MIN_SAMPLES 4
+#define MAX_SAMPLES 64
+const float MAX_DEPTH = 10000.0;
+
+// Host time per call, averaged over iterations
+template <typename F>
+double nsPerCall(uint32_t iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) f(i);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+volatile uint32_t benchSink;
+
+void runBenchmarks() {
+  const uint32_t N = 200000;
+
+  SimClock clock;
+  SimRandom random(1);
+  SimAdc adc(clock, random);
+  AcquisitionEngine acquisition(adc);
+  acquisition.addChannel(SIM_LEVEL_PIN);
+  for (uint16_t i = 0; i < MAX_SAMPLES; i++) acquisition.sampleTick();
+
+  FrameSample samples[BATCH_SIZE];
+  for (uint8_t i = 0; i < BATCH_SIZE; i++) {
+    frameReadingFromValues(samples[i].reading, 12.0f + i * 0.01f, 200.0f + i * 0.1f, 24.5f, true, 1.2f, 100.0f);
+    samples[i].ageDs = (BATCH_SIZE - i) * 20;
+  }
+  FrameHeader header = { FRAME_BATCH, FRAME_FLAG_ACK_REQUEST, SIM_NODE_ID, 0, 0 };
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t encoded = 0;
+  size_t frameLength = frameEncodeBatch(header, samples, BATCH_SIZE, frame, sizeof(frame), encoded);
+
+  CalibrationCurve curve;
+  curve.clear();
+  curve.addPoint(500, 0);
+  curve.addPoint(2000, 180);
+  curve.addPoint(3500, 500);
+  curve.setFit(CalibrationCurve::FIT_POLYNOMIAL, 2);
+  CalibrationTable table;
+  table.compile(curve, 0, MAX_DEPTH);
+
+  SignalFilter kalman(SIM_DEPTH_FILTER);
+  SignalFilter ema(SIM_TURBIDITY_FILTER);
+  uint8_t config[CONFIG_MAX_PAYLOAD];
+  memset(config, 0x5A, sizeof(config));
+
+  printf("\n--- Benchmarks (host ns per call) ---\n");
+  printf("frameEncodeBatch (%u samples): %8.1f\n", BATCH_SIZE, nsPerCall(N, [&](uint32_t i) {
+    samples[0].reading.depthMm = i;
+    benchSink = frameEncodeBatch(header, samples, BATCH_SIZE, frame, sizeof(frame), encoded);
+  }));
+  frameLength = frameEncodeBatch(header, samples, BATCH_SIZE, frame, sizeof(frame), encoded);
+  printf("frameDecodeBatch (%u bytes):   %8.1f\n", (unsigned)frameLength, nsPerCall(N, [&](uint32_t i) {
+    FrameSample out[FRAME_BATCH_MAX];
+    size_t count;
+    frameDecodeBatch(frame, frameLength, header, out, FRAME_BATCH_MAX, count);
+    benchSink = count;
+  }));
+  printf("CalibrationTable::value:       %8.1f\n", nsPerCall(N, [&](uint32_t i) {
+    benchSink = (uint32_t)table.value((float)(i & 4095));
+  }));
+  printf("CalibrationCurve::evaluate:    %8.1f\n", nsPerCall(N / 10, [&](uint32_t i) {
+    benchSink = (uint32_t)curve.evaluate((float)(i & 4095));
+  }));
+  printf("SignalFilter::update (Kalman): %8.1f\n", nsPerCall(N, [&](uint32_t i) {
+    benchSink = (uint32_t)kalman.update(200.0f + (i & 7), i * 2000);
+  }));
+  printf("SignalFilter::update (EMA):    %8.1f\n", nsPerCall(N, [&](uint32_t i) {
+    benchSink = (uint32_t)ema.update(100.0f + (i & 7), i * 2000);
+  }));
+  printf("adaptiveMean (up to %u):       %8.1f\n", MAX_SAMPLES, nsPerCall(N / 10, [&](uint32_t i) {
+    AdaptiveMean mean;
+    acquisition.adaptiveMean(0, MIN_SAMPLES, MAX_SAMPLES, 0.01f, mean);
+    benchSink = mean.samples;
+  }));
+  printf("configCrc32 (%u bytes):       %8.1f\n", CONFIG_MAX_PAYLOAD, nsPerCall(N / 10, [&](uint32_t i) {
+    config[0] = i;
+    benchSink = configCrc32(config, sizeof(config));
+  }));
+  printf("loraTimeOnAirUs:               %8.1f\n", nsPerCall(N, [&](uint32_t i) {
+    benchSink = loraTimeOnAirUs(16 + (i & 63), 7 + (i & 3), 125000, 5);
+  }));
+}
+
+void usage() {
+  printf("Usage: simulator [--hours H] [--path-loss DB] [--fading DB] [--loss P]\n"
+         "                 [--seed N] [--portal] [--min-delivery R] [--bench]\n");
+}
+
+int main(int argc, char** argv) {
+  float minDelivery = 0;
+  bool bench = false;
+  SimulationConfig config = {
+    1.0,         // hours
+    {
+      130.0,     // path loss, dB
+      4.0,       // fading, dB
+      6.0,       // receiver noise figure, dB
+      0.02       // 2% of packets lost to interference
+    },
+    1,           // seed
+    false        // portal closed
+  };
+
+  for (int i = 1; i < argc; i++) {
+    bool value = i + 1 < argc;
+    if (!strcmp(argv[i], "--hours") && value) config.hours = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--path-loss") && value) config.channel.pathLossDb = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--fading") && value) config.channel.fadingDb = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--loss") && value) config.channel.lossProbability = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && value) config.seed = strtoul(argv[++i], NULL, 0);
+    else if (!strcmp(argv[i], "--portal")) config.portalOpen = true;
+    else if (!strcmp(argv[i], "--min-delivery") && value) minDelivery = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--bench")) bench = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+
+  auto wallStart = std::chrono::steady_clock::now();
+  SimulationResults r = runSimulation(config);
+  double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  float hours = config.hours;
+  printf("--- Simulation: %.2f h, path loss %.1f dB, fading %.1f dB, loss %.1f%%, seed %u ---\n",
+         hours, config.channel.pathLossDb, config.channel.fadingDb,
+         config.channel.lossProbability * 100, config.seed);
+  printf("Node:    %u readings, %u live samples, %u frames, %u retries, %u acked, %u lost\n",
+         r.readings, r.liveSamples, r.link.sent, r.link.retries, r.link.acked, r.link.lost);
+  printf("Profile: %u changes, now %u, %u frames re-sent for the dwell limit\n",
+         r.profileChanges, r.nodeProfile, r.requeued);
+  printf("Airtime: node %.1f s (%.3f%% duty), longest frame %.1f ms, %u deferred, %u over dwell\n",
+         r.nodeAirtime.airtimeUs / 1e6, r.nodeAirtime.airtimeUs / (hours * 3.6e7),
+         r.nodeAirtime.maxFrameUs / 1000.0, r.nodeAirtime.deferred, r.nodeAirtime.overDwell);
+  printf("         gateway %.1f s, %u downlinks skipped\n",
+         r.gatewayAirtime.airtimeUs / 1e6, r.gatewayAirtime.deferred);
+  printf("Channel: %u sent, %u delivered, %u weak, %u wrong profile, %u dropped, %u missed\n",
+         r.channel.sent, r.channel.delivered, r.channel.weak, r.channel.mismatched,
+         r.channel.dropped, r.missed);
+  printf("Gateway: %u frames, %u duplicates, %u missing, %u readings (%.1f%% delivered)\n",
+         r.frames.received, r.frames.duplicates, r.frames.missing, r.delivered, r.delivery() * 100);
+  printf("Windows: %u closed, %u readings in windows\n", r.windows, r.windowSamples);
+  printf("Age at delivery: mean %.1f s, max %.1f s\n", r.meanAgeS, r.maxAgeS);
+  printf("Depth error: rms %.2f cm, max %.2f cm\n", r.depthError.rms(), r.depthError.maxAbs);
+  printf("Turbidity error: rms %.2f NTU, max %.2f NTU\n", r.ntuError.rms(), r.ntuError.maxAbs);
+  printf("Simulated %.0fx faster than real time\n", hours * 3600.0 / wallS);
+
+  if (bench) runBenchmarks();
+
+  if (r.delivery() < minDelivery) {
+    printf("FAIL: delivery %.3f below %.3f\n", r.delivery(), minDelivery);
+    return 1;
+  }
+  return 0;
+}
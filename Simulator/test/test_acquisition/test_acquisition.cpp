@@ -0,0 +1,191 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <AcquisitionEngine.h>
+
+// AcquisitionEngine on a fake ADC: the ring wrapping, a reader racing a
+// producer that laps it, and adaptiveMean() stopping early or running out.
+//
+//   pio test -e native
+
+void setUp() {}
+void tearDown() {}
+
+// Counts up by one per read, so a block of samples is whole exactly when
+// its values are consecutive
+class CountingAdc : public AdcSource {
+public:
+  CountingAdc() : next(0) {}
+  uint16_t read(uint8_t pin) override { return next.fetch_add(1, std::memory_order_relaxed); }
+  std::atomic<uint16_t> next;
+};
+
+// Plays back a fixed pattern
+class PatternAdc : public AdcSource {
+public:
+  PatternAdc(const uint16_t* values, uint16_t count) : _values(values), _count(count), _i(0) {}
+  uint16_t read(uint8_t pin) override { return _values[_i++ % _count]; }
+
+private:
+  const uint16_t* _values;
+  uint16_t _count;
+  uint32_t _i;
+};
+
+static void assertConsecutive(const uint16_t* samples, uint16_t count) {
+  for (uint16_t i = 1; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT16((uint16_t)(samples[i - 1] + 1), samples[i]);
+  }
+}
+
+void test_latest_while_filling() {
+  CountingAdc adc;
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+
+  uint16_t samples[AcquisitionEngine::RING_SIZE / 2];
+  TEST_ASSERT_EQUAL_UINT16(0, engine.latest(ch, 10, samples));
+
+  for (int i = 0; i < 4; i++) engine.sampleTick();
+  TEST_ASSERT_EQUAL_UINT16(4, engine.latest(ch, 10, samples));
+  TEST_ASSERT_EQUAL_UINT16(0, samples[0]);
+  TEST_ASSERT_EQUAL_UINT16(3, samples[3]);
+}
+
+// Past RING_SIZE the newest samples straddle the end of the ring and
+// must still come back oldest first
+void test_latest_across_wraparound() {
+  CountingAdc adc;
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+
+  uint32_t ticks = AcquisitionEngine::RING_SIZE * 3 + 5;
+  for (uint32_t i = 0; i < ticks; i++) engine.sampleTick();
+  TEST_ASSERT_EQUAL_UINT32(ticks, engine.sampleCount(ch));
+
+  uint16_t samples[AcquisitionEngine::RING_SIZE / 2];
+  TEST_ASSERT_EQUAL_UINT16(10, engine.latest(ch, 10, samples));
+  TEST_ASSERT_EQUAL_UINT16(ticks - 10, samples[0]);
+  assertConsecutive(samples, 10);
+
+  // Capped at half the ring
+  TEST_ASSERT_EQUAL_UINT16(AcquisitionEngine::RING_SIZE / 2,
+                           engine.latest(ch, AcquisitionEngine::RING_SIZE, samples));
+  TEST_ASSERT_EQUAL_UINT16(ticks - AcquisitionEngine::RING_SIZE / 2, samples[0]);
+  assertConsecutive(samples, AcquisitionEngine::RING_SIZE / 2);
+}
+
+// Two channels sampled in one sweep keep their own rings
+void test_channels_interleaved() {
+  CountingAdc adc;
+  AcquisitionEngine engine(adc);
+  int level = engine.addChannel(34);
+  int turbidity = engine.addChannel(32);
+  TEST_ASSERT_EQUAL_INT(-1, engine.addChannel(33));
+
+  for (int i = 0; i < 3; i++) engine.sampleTick();
+  uint16_t samples[3];
+  TEST_ASSERT_EQUAL_UINT16(3, engine.latest(level, 3, samples));
+  TEST_ASSERT_EQUAL_UINT16(0, samples[0]);
+  TEST_ASSERT_EQUAL_UINT16(4, samples[2]);
+  TEST_ASSERT_EQUAL_UINT16(3, engine.latest(turbidity, 3, samples));
+  TEST_ASSERT_EQUAL_UINT16(1, samples[0]);
+  TEST_ASSERT_EQUAL_UINT16(5, samples[2]);
+}
+
+// A producer running flat out laps the reader over and over, often by a
+// full ring while a copy is in progress. Every block latest() returns
+// must still be one unbroken run of samples.
+void test_reader_lapped_by_producer() {
+  CountingAdc adc;
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+  for (uint32_t i = 0; i < AcquisitionEngine::RING_SIZE; i++) engine.sampleTick();
+
+  std::atomic<bool> running(true);
+  std::thread producer([&] {
+    while (running.load(std::memory_order_relaxed)) engine.sampleTick();
+  });
+
+  uint16_t samples[AcquisitionEngine::RING_SIZE / 2];
+  uint32_t torn = 0;
+  for (int read = 0; read < 200000; read++) {
+    uint16_t count = engine.latest(ch, AcquisitionEngine::RING_SIZE / 2, samples);
+    for (uint16_t i = 1; i < count; i++) {
+      if (samples[i] != (uint16_t)(samples[i - 1] + 1)) {
+        torn++;
+        break;
+      }
+    }
+  }
+  running.store(false);
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_GREATER_THAN_UINT32(AcquisitionEngine::RING_SIZE * 2, engine.sampleCount(ch));
+}
+
+void test_adaptive_mean_quiet_stops_at_min() {
+  static const uint16_t flat[] = { 2000 };
+  PatternAdc adc(flat, 1);
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+  for (int i = 0; i < 100; i++) engine.sampleTick();
+
+  AdaptiveMean result;
+  TEST_ASSERT_TRUE(engine.adaptiveMean(ch, 8, 64, 0.5f, result));
+  TEST_ASSERT_TRUE(result.converged);
+  TEST_ASSERT_EQUAL_UINT16(8, result.samples);
+  TEST_ASSERT_EQUAL_FLOAT(2000.0f, result.mean);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, result.stdError);
+}
+
+// +/-10 counts around 1000: the standard error is about 10 / sqrt(n), so
+// a 2-count tolerance needs some 25 samples and a 0.1-count one is never met
+void test_adaptive_mean_noisy_uses_more() {
+  static const uint16_t noisy[] = { 990, 1010 };
+  PatternAdc adc(noisy, 2);
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+  for (int i = 0; i < 200; i++) engine.sampleTick();
+
+  AdaptiveMean result;
+  TEST_ASSERT_TRUE(engine.adaptiveMean(ch, 4, 64, 2.0f, result));
+  TEST_ASSERT_GREATER_THAN(20, result.samples);
+  TEST_ASSERT_LESS_THAN(30, result.samples);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 1000.0f, result.mean);
+  TEST_ASSERT_TRUE(result.stdError <= 2.0f);
+  TEST_ASSERT_TRUE(result.ci95 > result.stdError);
+
+  TEST_ASSERT_FALSE(engine.adaptiveMean(ch, 4, 64, 0.1f, result));
+  TEST_ASSERT_FALSE(result.converged);
+  TEST_ASSERT_EQUAL_UINT16(64, result.samples);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 1000.0f, result.mean);
+
+  // maxN is bounded by what latest() hands back
+  engine.adaptiveMean(ch, 4, AcquisitionEngine::RING_SIZE, 0.1f, result);
+  TEST_ASSERT_EQUAL_UINT16(AcquisitionEngine::RING_SIZE / 2, result.samples);
+}
+
+void test_adaptive_mean_empty() {
+  CountingAdc adc;
+  AcquisitionEngine engine(adc);
+  int ch = engine.addChannel(34);
+
+  AdaptiveMean result;
+  TEST_ASSERT_FALSE(engine.adaptiveMean(ch, 4, 64, 1.0f, result));
+  TEST_ASSERT_EQUAL_UINT16(0, result.samples);
+  TEST_ASSERT_FALSE(engine.adaptiveMean(5, 4, 64, 1.0f, result));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_latest_while_filling);
+  RUN_TEST(test_latest_across_wraparound);
+  RUN_TEST(test_channels_interleaved);
+  RUN_TEST(test_reader_lapped_by_producer);
+  RUN_TEST(test_adaptive_mean_quiet_stops_at_min);
+  RUN_TEST(test_adaptive_mean_noisy_uses_more);
+  RUN_TEST(test_adaptive_mean_empty);
+  return UNITY_END();
+}
@@ -0,0 +1,107 @@
+#include <unity.h>
+#include <string.h>
+#include <Calibration.h>
+
+// Calibration curves from reference points and the integer table the
+// node converts with.
+//
+//   pio test -e native
+
+void setUp() {}
+void tearDown() {}
+
+static CalibrationCurve piecewise() {
+  CalibrationCurve curve;
+  curve.clear();
+  curve.addPoint(3000, 300);
+  curve.addPoint(0, 0);
+  curve.addPoint(1000, 100);
+  return curve;
+}
+
+void test_points_sorted_and_replaced() {
+  CalibrationCurve curve = piecewise();
+  TEST_ASSERT_EQUAL_UINT8(3, curve.count());
+  TEST_ASSERT_EQUAL_UINT16(0, curve.point(0).raw);
+  TEST_ASSERT_EQUAL_UINT16(3000, curve.point(2).raw);
+
+  TEST_ASSERT_TRUE(curve.addPoint(1000, 120));
+  TEST_ASSERT_EQUAL_UINT8(3, curve.count());
+  TEST_ASSERT_EQUAL_FLOAT(120, curve.point(1).value);
+
+  for (uint16_t raw = 100; curve.count() < CalibrationCurve::MAX_POINTS; raw += 100) {
+    TEST_ASSERT_TRUE(curve.addPoint(raw, raw / 10.0f));
+  }
+  TEST_ASSERT_FALSE(curve.addPoint(4000, 400));
+  TEST_ASSERT_TRUE(curve.valid());
+}
+
+void test_valid_rejects_corrupt_storage() {
+  CalibrationCurve curve;
+  memset((void*)&curve, 0xFF, sizeof(curve));   // erased EEPROM
+  TEST_ASSERT_FALSE(curve.valid());
+
+  memset((void*)&curve, 0, sizeof(curve));
+  TEST_ASSERT_TRUE(curve.valid());
+}
+
+void test_piecewise_interpolates_and_extrapolates() {
+  CalibrationCurve curve = piecewise();
+  TEST_ASSERT_EQUAL_FLOAT(50, curve.evaluate(500));
+  TEST_ASSERT_EQUAL_FLOAT(200, curve.evaluate(2000));
+  TEST_ASSERT_EQUAL_FLOAT(400, curve.evaluate(4000));
+  TEST_ASSERT_EQUAL_FLOAT(-10, curve.evaluate(-100));
+}
+
+// Points on y = 2 + 0.01 x + 1e-6 x^2 give back the same quadratic
+void test_polynomial_fit() {
+  CalibrationCurve curve;
+  curve.clear();
+  for (uint16_t raw = 0; raw <= 4000; raw += 800) {
+    curve.addPoint(raw, 2 + 0.01f * raw + 1e-6f * raw * raw);
+  }
+  curve.setFit(CalibrationCurve::FIT_POLYNOMIAL, 2);
+  TEST_ASSERT_TRUE(curve.valid());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2 + 15 + 2.25f, curve.evaluate(1500));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2 + 35 + 12.25f, curve.evaluate(3500));
+}
+
+// Between entries the table interpolates in integer maths, with the
+// fraction of an ADC count kept
+void test_table_interpolates() {
+  CalibrationCurve curve = piecewise();
+  CalibrationTable table;
+  table.compile(curve, 0, 1000);
+
+  TEST_ASSERT_EQUAL_FLOAT(0, table.value(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.2f, table.value(32));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.0f, table.value(50));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 123.45f, table.value(1234.5f));
+  TEST_ASSERT_EQUAL_INT32(12345, table.lookup(1234 * 16 + 8));
+
+  // Across the knee at 1000 the segment still follows the curve within
+  // the difference between the two slopes over one entry
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, curve.evaluate(1010), table.value(1010));
+}
+
+void test_table_clamps() {
+  CalibrationCurve curve = piecewise();
+  CalibrationTable table;
+  table.compile(curve, 10, 250);
+
+  TEST_ASSERT_EQUAL_FLOAT(10, table.value(0));
+  TEST_ASSERT_EQUAL_FLOAT(10, table.value(-5));
+  TEST_ASSERT_EQUAL_FLOAT(250, table.value(3000));
+  TEST_ASSERT_EQUAL_FLOAT(250, table.value(5000));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_points_sorted_and_replaced);
+  RUN_TEST(test_valid_rejects_corrupt_storage);
+  RUN_TEST(test_piecewise_interpolates_and_extrapolates);
+  RUN_TEST(test_polynomial_fit);
+  RUN_TEST(test_table_interpolates);
+  RUN_TEST(test_table_clamps);
+  return UNITY_END();
+}
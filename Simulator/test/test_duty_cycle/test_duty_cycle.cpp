@@ -0,0 +1,129 @@
+#include <unity.h>
+#include <DutyCycle.h>
+
+// The sliding-window airtime budget, refilled bucket by bucket, and the
+// dwell limit on single frames.
+//
+//   pio test -e native
+
+#define EU_1PCT_HZ 868100000      // 1% band, 36 s per hour
+#define EU_10PCT_HZ 869525000     // 10% band
+#define US_HZ 915000000
+
+void setUp() {}
+void tearDown() {}
+
+void test_limits_per_band() {
+  DutyCycle eu(DUTY_REGION_EU868, 0);
+  TEST_ASSERT_EQUAL_UINT32(36000000, eu.limitUs(EU_1PCT_HZ));
+  TEST_ASSERT_EQUAL_UINT32(360000000, eu.limitUs(EU_10PCT_HZ));
+  TEST_ASSERT_EQUAL_UINT32(DutyCycle::NEVER, eu.limitUs(US_HZ));
+
+  // The policy tightens a band, or limits one the region leaves open
+  DutyCycle capped(DUTY_REGION_EU868, 0.005f);
+  TEST_ASSERT_EQUAL_UINT32(18000000, capped.limitUs(EU_1PCT_HZ));
+  DutyCycle us(DUTY_REGION_US915, 0.05f);
+  TEST_ASSERT_EQUAL_UINT32(180000000, us.limitUs(US_HZ));
+}
+
+// Airtime leaves the window with its bucket, BUCKETS + 1 buckets after
+// the one it was recorded in
+void test_budget_refills_at_bucket_boundary() {
+  DutyCycle duty(DUTY_REGION_EU868, 0);
+  duty.record(EU_1PCT_HZ, 30000000, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, duty.waitMs(EU_1PCT_HZ, 6000000, 2000));
+
+  uint32_t refill = (DutyCycle::BUCKETS + 1) * DutyCycle::BUCKET_MS;
+  TEST_ASSERT_EQUAL_UINT32(refill - 2000, duty.waitMs(EU_1PCT_HZ, 7000000, 2000));
+  TEST_ASSERT_EQUAL_UINT32(30000000, duty.usedUs(EU_1PCT_HZ, refill - 1));
+  TEST_ASSERT_EQUAL_UINT32(1, duty.waitMs(EU_1PCT_HZ, 7000000, refill - 1));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.usedUs(EU_1PCT_HZ, refill));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.waitMs(EU_1PCT_HZ, 36000000, refill));
+}
+
+// With airtime spread over several buckets, the wait runs to the first
+// boundary that frees enough of it, not merely the next one
+void test_budget_refills_across_buckets() {
+  DutyCycle duty(DUTY_REGION_EU868, 0);
+  duty.record(EU_1PCT_HZ, 5000000, 0);
+  duty.record(EU_1PCT_HZ, 10000000, 5 * DutyCycle::BUCKET_MS);
+  duty.record(EU_1PCT_HZ, 15000000, 10 * DutyCycle::BUCKET_MS);
+
+  uint32_t now = 20 * DutyCycle::BUCKET_MS;
+  TEST_ASSERT_EQUAL_UINT32(30000000, duty.usedUs(EU_1PCT_HZ, now));
+
+  // 16 s needs the first two buckets gone: bucket 5 leaves at bucket 26
+  TEST_ASSERT_EQUAL_UINT32(6 * DutyCycle::BUCKET_MS, duty.waitMs(EU_1PCT_HZ, 16000000, now));
+  TEST_ASSERT_EQUAL_UINT32(DutyCycle::BUCKET_MS, duty.waitMs(EU_1PCT_HZ, 10000000, now));
+
+  TEST_ASSERT_EQUAL_UINT32(25000000, duty.usedUs(EU_1PCT_HZ, 21 * DutyCycle::BUCKET_MS));
+  TEST_ASSERT_EQUAL_UINT32(15000000, duty.usedUs(EU_1PCT_HZ, 26 * DutyCycle::BUCKET_MS));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.usedUs(EU_1PCT_HZ, 31 * DutyCycle::BUCKET_MS));
+}
+
+// Each band has its own budget
+void test_bands_separate() {
+  DutyCycle duty(DUTY_REGION_EU868, 0);
+  duty.record(EU_1PCT_HZ, 36000000, 0);
+  TEST_ASSERT_TRUE(duty.waitMs(EU_1PCT_HZ, 100000, 0) > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, duty.waitMs(EU_10PCT_HZ, 100000, 0));
+}
+
+void test_frame_over_budget_never_fits() {
+  DutyCycle duty(DUTY_REGION_EU868, 0.0001f);
+  TEST_ASSERT_EQUAL_UINT32(360000, duty.limitUs(EU_1PCT_HZ));
+  TEST_ASSERT_EQUAL_UINT32(DutyCycle::NEVER, duty.waitMs(EU_1PCT_HZ, 400000, 0));
+}
+
+// US915 has no duty cycle but caps every frame at 400 ms
+void test_dwell_rejection() {
+  DutyCycle duty(DUTY_REGION_US915, 0);
+  TEST_ASSERT_TRUE(duty.fitsDwell(400000));
+  TEST_ASSERT_FALSE(duty.fitsDwell(400001));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.waitMs(US_HZ, 400000, 0));
+  TEST_ASSERT_EQUAL_UINT32(DutyCycle::NEVER, duty.waitMs(US_HZ, 450000, 0));
+
+  duty.record(US_HZ, 350000, 0);
+  duty.record(US_HZ, 450000, 1000);
+  TEST_ASSERT_EQUAL_UINT32(2, duty.stats().frames);
+  TEST_ASSERT_EQUAL_UINT32(1, duty.stats().overDwell);
+  TEST_ASSERT_EQUAL_UINT32(450000, duty.stats().maxFrameUs);
+
+  // EU868 sets no dwell limit
+  DutyCycle eu(DUTY_REGION_EU868, 0);
+  TEST_ASSERT_TRUE(eu.fitsDwell(2000000));
+}
+
+// millis() wrapping around starts a new window
+void test_clock_wrap_clears() {
+  DutyCycle duty(DUTY_REGION_EU868, 0);
+  duty.record(EU_1PCT_HZ, 30000000, 0xFFFFF000);
+  TEST_ASSERT_EQUAL_UINT32(30000000, duty.usedUs(EU_1PCT_HZ, 0xFFFFFF00));
+  TEST_ASSERT_EQUAL_UINT32(0, duty.usedUs(EU_1PCT_HZ, 1000));
+}
+
+void test_save_restore() {
+  DutyCycle before(DUTY_REGION_EU868, 0);
+  before.record(EU_1PCT_HZ, 30000000, 1000);
+  DutyCycle::SavedState saved;
+  before.saveState(saved);
+
+  DutyCycle after(DUTY_REGION_EU868, 0);
+  after.restoreState(saved);
+  TEST_ASSERT_EQUAL_UINT32(30000000, after.usedUs(EU_1PCT_HZ, 2000));
+  TEST_ASSERT_EQUAL_UINT32(before.waitMs(EU_1PCT_HZ, 7000000, 2000), after.waitMs(EU_1PCT_HZ, 7000000, 2000));
+  TEST_ASSERT_EQUAL_UINT32(1, after.stats().frames);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_limits_per_band);
+  RUN_TEST(test_budget_refills_at_bucket_boundary);
+  RUN_TEST(test_budget_refills_across_buckets);
+  RUN_TEST(test_bands_separate);
+  RUN_TEST(test_frame_over_budget_never_fits);
+  RUN_TEST(test_dwell_rejection);
+  RUN_TEST(test_clock_wrap_clears);
+  RUN_TEST(test_save_restore);
+  return UNITY_END();
+}
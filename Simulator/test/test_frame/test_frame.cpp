@@ -0,0 +1,426 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <DutyCycle.h>
+#include <LoRaAirtime.h>
+#include <RadioProfile.h>
+#include <SubmersibleFrame.h>
+
+// Round trips of every frame type, the decoder's error paths, and the time
+// on air of a binary reading against the legacy JSON packet.
+//
+//   pio test -e native
+
+void setUp() {}
+void tearDown() {}
+
+static FrameHeader header(uint8_t type, uint8_t flags = 0, uint8_t nodeId = 7, uint16_t seq = 1234) {
+  FrameHeader h;
+  h.type = type;
+  h.flags = flags;
+  h.nodeId = nodeId;
+  h.seq = seq;
+  h.epoch = 0;
+  return h;
+}
+
+static FrameReading reading(uint16_t current, uint16_t depth, int16_t temp,
+                            uint16_t turbV, uint16_t turbNtu, uint8_t flags = 0) {
+  FrameReading r;
+  r.currentCentiMa = current;
+  r.depthMm = depth;
+  r.tempCentiC = temp;
+  r.turbMilliV = turbV;
+  r.turbDeciNtu = turbNtu;
+  r.flags = flags;
+  return r;
+}
+
+static void assertReadingEqual(const FrameReading& expected, const FrameReading& actual) {
+  TEST_ASSERT_EQUAL_UINT16(expected.currentCentiMa, actual.currentCentiMa);
+  TEST_ASSERT_EQUAL_UINT16(expected.depthMm, actual.depthMm);
+  TEST_ASSERT_EQUAL_INT16(expected.tempCentiC, actual.tempCentiC);
+  TEST_ASSERT_EQUAL_UINT16(expected.turbMilliV, actual.turbMilliV);
+  TEST_ASSERT_EQUAL_UINT16(expected.turbDeciNtu, actual.turbDeciNtu);
+  TEST_ASSERT_EQUAL_UINT8(expected.flags, actual.flags);
+}
+
+static void assertBatchRoundTrip(const FrameSample* samples, size_t count) {
+  uint8_t buf[512];
+  size_t encoded;
+  size_t length = frameEncodeBatch(header(FRAME_BATCH), samples, count, buf, sizeof(buf), encoded);
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_EQUAL(count, encoded);
+
+  FrameHeader h;
+  FrameSample out[FRAME_BATCH_MAX];
+  size_t decoded;
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeBatch(buf, length, h, out, FRAME_BATCH_MAX, decoded));
+  TEST_ASSERT_EQUAL(FRAME_BATCH, h.type);
+  TEST_ASSERT_EQUAL(count, decoded);
+  for (size_t i = 0; i < count; i++) {
+    assertReadingEqual(samples[i].reading, out[i].reading);
+    TEST_ASSERT_EQUAL_UINT32(samples[i].ageDs, out[i].ageDs);
+  }
+}
+
+void test_reading_round_trip() {
+  FrameReading values[] = {
+    reading(1234, 2345, 2750, 1230, 4567, 0),
+    reading(0, 0, -4000, 0, 0, FRAME_FLAG_DEPTH_GATED | FRAME_FLAG_TURB_GATED),
+    reading(65535, 65535, 32767, 65535, 65535, 0xFF),
+    reading(400, 100, FRAME_TEMP_INVALID, 10, 10, FRAME_FLAG_TEMP_ERROR),
+  };
+  for (const FrameReading& r : values) {
+    uint8_t buf[FRAME_READING_SIZE];
+    FrameHeader sent = header(FRAME_READING, FRAME_FLAG_ACK_REQUEST, 255, 65535);
+    TEST_ASSERT_EQUAL(FRAME_READING_SIZE, frameEncodeReading(sent, r, buf, sizeof(buf)));
+
+    FrameHeader h;
+    FrameReading out;
+    TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeReading(buf, sizeof(buf), h, out));
+    TEST_ASSERT_EQUAL(FRAME_READING, h.type);
+    TEST_ASSERT_EQUAL(FRAME_FLAG_ACK_REQUEST, h.flags);
+    TEST_ASSERT_EQUAL_UINT8(255, h.nodeId);
+    TEST_ASSERT_EQUAL_UINT16(65535, h.seq);
+    assertReadingEqual(r, out);
+  }
+}
+
+// The epoch shares the type byte with the type and the ACK flag
+void test_header_epoch() {
+  for (uint8_t epoch = 0; epoch <= FRAME_EPOCH_MASK; epoch++) {
+    uint8_t buf[FRAME_READING_SIZE];
+    FrameHeader sent = header(FRAME_READING, FRAME_FLAG_ACK_REQUEST);
+    sent.epoch = epoch;
+    frameEncodeReading(sent, reading(1, 2, 3, 4, 5), buf, sizeof(buf));
+
+    FrameHeader h;
+    FrameReading out;
+    TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeReading(buf, sizeof(buf), h, out));
+    TEST_ASSERT_EQUAL(FRAME_READING, h.type);
+    TEST_ASSERT_EQUAL(FRAME_FLAG_ACK_REQUEST, h.flags);
+    TEST_ASSERT_EQUAL_UINT8(epoch, h.epoch);
+  }
+}
+
+void test_reading_needs_room() {
+  uint8_t buf[FRAME_READING_SIZE - 1];
+  TEST_ASSERT_EQUAL(0, frameEncodeReading(header(FRAME_READING), reading(1, 2, 3, 4, 5), buf, sizeof(buf)));
+}
+
+void test_temperature_validity() {
+  FrameReading r;
+  frameReadingFromValues(r, 12.34f, 234.5f, -3.5f, true, 1.23f, 456.7f);
+  TEST_ASSERT_TRUE(frameTempValid(r));
+  TEST_ASSERT_EQUAL_INT16(-350, r.tempCentiC);
+  TEST_ASSERT_EQUAL_UINT16(2345, r.depthMm);
+
+  frameReadingFromValues(r, 12.34f, 234.5f, 25.0f, false, 1.23f, 456.7f);
+  TEST_ASSERT_FALSE(frameTempValid(r));
+  TEST_ASSERT_EQUAL_INT16(FRAME_TEMP_INVALID, r.tempCentiC);
+}
+
+void test_scale_clamps() {
+  TEST_ASSERT_EQUAL_UINT16(0, frameScaleUnsigned(-1.0f, 10));
+  TEST_ASSERT_EQUAL_UINT16(65535, frameScaleUnsigned(1e6f, 10));
+  TEST_ASSERT_EQUAL_INT16(-32767, frameScaleSigned(-1e6f, 100));
+  TEST_ASSERT_EQUAL_INT16(32767, frameScaleSigned(1e6f, 100));
+  TEST_ASSERT_EQUAL_INT16(-125, frameScaleSigned(-1.25f, 100));
+}
+
+void test_batch_single_sample() {
+  FrameSample s = { reading(1234, 2345, 2750, 1230, 4567), 600 };
+  assertBatchRoundTrip(&s, 1);
+}
+
+void test_batch_small_deltas() {
+  FrameSample samples[8];
+  for (size_t i = 0; i < 8; i++) {
+    samples[i].reading = reading(1200 + i, 2345 - i, 2750 + (i % 2 ? -3 : 3), 1230, 4567 + 2 * i);
+    samples[i].ageDs = (8 - i) * 50;
+  }
+  assertBatchRoundTrip(samples, 8);
+}
+
+// Deltas at both ends of each field's range, where zigzag and the uint16
+// wrap back into the field have to agree
+void test_batch_extreme_deltas() {
+  FrameSample samples[] = {
+    { reading(0, 65535, 32767, 0, 65535, 0), 1000000 },
+    { reading(65535, 0, -32767, 65535, 0, 0xFF), 999999 },
+    { reading(0, 65535, FRAME_TEMP_INVALID, 1, 65534, FRAME_FLAG_TEMP_ERROR), 999999 },
+    { reading(32768, 32767, 0, 32767, 32768, 0x80), 0 },
+  };
+  assertBatchRoundTrip(samples, 4);
+}
+
+// An age step of zero and ages large enough for a five-byte varint
+void test_batch_ages() {
+  FrameSample samples[] = {
+    { reading(1, 1, 1, 1, 1), 0xFFFFFFFF },
+    { reading(1, 1, 1, 1, 1), 0xFFFFFFFF },
+    { reading(2, 2, 2, 2, 2), 127 },
+    { reading(3, 3, 3, 3, 3), 0 },
+  };
+  assertBatchRoundTrip(samples, 4);
+}
+
+// Ages that go up instead of down are sent as a zero step
+void test_batch_ages_out_of_order() {
+  FrameSample samples[] = {
+    { reading(1, 1, 1, 1, 1), 100 },
+    { reading(1, 1, 1, 1, 1), 200 },
+  };
+  uint8_t buf[FRAME_MAX_SIZE];
+  size_t encoded;
+  size_t length = frameEncodeBatch(header(FRAME_BATCH), samples, 2, buf, sizeof(buf), encoded);
+
+  FrameHeader h;
+  FrameSample out[2];
+  size_t decoded;
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeBatch(buf, length, h, out, 2, decoded));
+  TEST_ASSERT_EQUAL_UINT32(100, out[1].ageDs);
+}
+
+void test_batch_stops_at_batch_max() {
+  FrameSample samples[FRAME_BATCH_MAX + 8];
+  for (size_t i = 0; i < FRAME_BATCH_MAX + 8; i++) {
+    samples[i].reading = reading(1200, 2345, 2750, 1230, 4567);
+    samples[i].ageDs = FRAME_BATCH_MAX + 8 - i;
+  }
+  uint8_t buf[512];
+  size_t encoded;
+  size_t length = frameEncodeBatch(header(FRAME_BATCH), samples, FRAME_BATCH_MAX + 8, buf, sizeof(buf), encoded);
+  TEST_ASSERT_EQUAL(FRAME_BATCH_MAX, encoded);
+
+  FrameHeader h;
+  FrameSample out[FRAME_BATCH_MAX];
+  size_t decoded;
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeBatch(buf, length, h, out, FRAME_BATCH_MAX, decoded));
+  TEST_ASSERT_EQUAL(FRAME_BATCH_MAX, decoded);
+  TEST_ASSERT_EQUAL_UINT32(samples[FRAME_BATCH_MAX - 1].ageDs, out[FRAME_BATCH_MAX - 1].ageDs);
+}
+
+void test_batch_fits_cap() {
+  FrameSample samples[FRAME_BATCH_MAX];
+  for (size_t i = 0; i < FRAME_BATCH_MAX; i++) {
+    samples[i].reading = reading(1200 + 300 * i, 2345, 2750, 1230 + 500 * i, 4567);
+    samples[i].ageDs = 10 * (FRAME_BATCH_MAX - i);
+  }
+  uint8_t buf[FRAME_MAX_SIZE];
+  size_t encoded;
+  size_t length = frameEncodeBatch(header(FRAME_BATCH), samples, FRAME_BATCH_MAX, buf, sizeof(buf), encoded);
+  TEST_ASSERT_LESS_OR_EQUAL(FRAME_MAX_SIZE, length);
+  TEST_ASSERT_GREATER_THAN(1, encoded);
+  TEST_ASSERT_LESS_THAN(FRAME_BATCH_MAX, encoded);
+
+  FrameHeader h;
+  FrameSample out[FRAME_BATCH_MAX];
+  size_t decoded;
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeBatch(buf, length, h, out, FRAME_BATCH_MAX, decoded));
+  TEST_ASSERT_EQUAL(encoded, decoded);
+  assertReadingEqual(samples[encoded - 1].reading, out[encoded - 1].reading);
+}
+
+void test_batch_needs_room() {
+  FrameSample s = { reading(1, 2, 3, 4, 5), 0 };
+  uint8_t buf[FRAME_READING_SIZE + 1];
+  size_t encoded;
+  TEST_ASSERT_EQUAL(0, frameEncodeBatch(header(FRAME_BATCH), &s, 1, buf, sizeof(buf), encoded));
+  TEST_ASSERT_EQUAL(0, encoded);
+}
+
+void test_batch_decode_errors() {
+  FrameSample samples[3];
+  for (size_t i = 0; i < 3; i++) {
+    samples[i].reading = reading(1200 + i, 2345, 2750, 1230, 4567);
+    samples[i].ageDs = 3 - i;
+  }
+  uint8_t buf[FRAME_MAX_SIZE];
+  size_t encoded;
+  size_t length = frameEncodeBatch(header(FRAME_BATCH), samples, 3, buf, sizeof(buf), encoded);
+
+  FrameHeader h;
+  FrameSample out[3];
+  size_t decoded;
+  TEST_ASSERT_EQUAL(FRAME_NO_SPACE, frameDecodeBatch(buf, length, h, out, 2, decoded));
+  TEST_ASSERT_EQUAL(2, decoded);
+  TEST_ASSERT_EQUAL(FRAME_NO_SPACE, frameDecodeBatch(buf, length, h, out, 0, decoded));
+  TEST_ASSERT_EQUAL(FRAME_TOO_SHORT, frameDecodeBatch(buf, length - 1, h, out, 3, decoded));
+  TEST_ASSERT_EQUAL(FRAME_TOO_SHORT, frameDecodeBatch(buf, FRAME_READING_SIZE + 1, h, out, 3, decoded));
+
+  uint8_t single[FRAME_READING_SIZE];
+  frameEncodeReading(header(FRAME_READING), samples[0].reading, single, sizeof(single));
+  TEST_ASSERT_EQUAL(FRAME_BAD_TYPE, frameDecodeBatch(single, sizeof(single), h, out, 3, decoded));
+}
+
+// Both uplink types through the one decoder the gateway and node share
+void test_uplink_decode() {
+  uint8_t buf[FRAME_MAX_SIZE];
+  FrameHeader h;
+  FrameSample out[FRAME_BATCH_MAX];
+  size_t count;
+
+  size_t length = frameEncodeReading(header(FRAME_READING), reading(1, 2, 3, 4, 5), buf, sizeof(buf));
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeUplink(buf, length, h, out, FRAME_BATCH_MAX, count));
+  TEST_ASSERT_EQUAL(1, count);
+  assertReadingEqual(reading(1, 2, 3, 4, 5), out[0].reading);
+  TEST_ASSERT_EQUAL_UINT32(0, out[0].ageDs);
+  TEST_ASSERT_EQUAL(FRAME_NO_SPACE, frameDecodeUplink(buf, length, h, out, 0, count));
+
+  FrameSample samples[3];
+  for (size_t i = 0; i < 3; i++) {
+    samples[i].reading = reading(100 + i, 200, 300, 400, 500);
+    samples[i].ageDs = (3 - i) * 10;
+  }
+  size_t encoded;
+  length = frameEncodeBatch(header(FRAME_BATCH), samples, 3, buf, sizeof(buf), encoded);
+  TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeUplink(buf, length, h, out, FRAME_BATCH_MAX, count));
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL_UINT32(10, out[2].ageDs);
+  TEST_ASSERT_EQUAL(FRAME_NO_SPACE, frameDecodeUplink(buf, length, h, out, 2, count));
+  TEST_ASSERT_EQUAL(2, count);
+
+  length = frameEncodeDownlink(header(FRAME_ACK), 1, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL(FRAME_BAD_TYPE, frameDecodeUplink(buf, length, h, out, FRAME_BATCH_MAX, count));
+  TEST_ASSERT_EQUAL(0, count);
+}
+
+void test_downlink_round_trip() {
+  uint8_t types[] = { FRAME_ADR, FRAME_ACK };
+  for (uint8_t type : types) {
+    uint8_t buf[FRAME_DOWNLINK_SIZE];
+    TEST_ASSERT_EQUAL(FRAME_DOWNLINK_SIZE, frameEncodeDownlink(header(type, 0, 3, 40000), 4, buf, sizeof(buf)));
+
+    FrameHeader h;
+    uint8_t profile;
+    TEST_ASSERT_EQUAL(FRAME_OK, frameDecodeDownlink(buf, sizeof(buf), h, profile));
+    TEST_ASSERT_EQUAL(type, h.type);
+    TEST_ASSERT_EQUAL_UINT8(3, h.nodeId);
+    TEST_ASSERT_EQUAL_UINT16(40000, h.seq);
+    TEST_ASSERT_EQUAL_UINT8(4, profile);
+    TEST_ASSERT_EQUAL(FRAME_TOO_SHORT, frameDecodeDownlink(buf, sizeof(buf) - 1, h, profile));
+  }
+}
+
+void test_downlink_rejects_uplink_types() {
+  uint8_t buf[FRAME_READING_SIZE];
+  TEST_ASSERT_EQUAL(0, frameEncodeDownlink(header(FRAME_READING), 1, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL(0, frameEncodeDownlink(header(FRAME_ADR), 1, buf, FRAME_DOWNLINK_SIZE - 1));
+
+  frameEncodeReading(header(FRAME_READING), reading(1, 2, 3, 4, 5), buf, sizeof(buf));
+  FrameHeader h;
+  uint8_t profile;
+  TEST_ASSERT_EQUAL(FRAME_BAD_TYPE, frameDecodeDownlink(buf, sizeof(buf), h, profile));
+}
+
+void test_header_errors() {
+  uint8_t buf[FRAME_READING_SIZE];
+  frameEncodeReading(header(FRAME_READING), reading(1, 2, 3, 4, 5), buf, sizeof(buf));
+  FrameHeader h;
+  FrameReading r;
+  TEST_ASSERT_EQUAL(FRAME_TOO_SHORT, frameDecodeHeader(buf, FRAME_HEADER_SIZE - 1, h));
+  TEST_ASSERT_EQUAL(FRAME_TOO_SHORT, frameDecodeReading(buf, FRAME_READING_SIZE - 1, h, r));
+
+  buf[0] = FRAME_VERSION + 1;
+  TEST_ASSERT_EQUAL(FRAME_BAD_VERSION, frameDecodeReading(buf, sizeof(buf), h, r));
+
+  buf[0] = FRAME_VERSION;
+  buf[1] = FRAME_ACK;
+  TEST_ASSERT_EQUAL(FRAME_BAD_TYPE, frameDecodeReading(buf, sizeof(buf), h, r));
+}
+
+// The legacy JSON packet must never parse as a binary frame
+void test_legacy_json_is_not_a_frame() {
+  const char* json = "{\"current\":12.34,\"depth\":234.5}";
+  FrameHeader h;
+  TEST_ASSERT_TRUE(frameIsLegacyJson((const uint8_t*)json, strlen(json)));
+  TEST_ASSERT_EQUAL(FRAME_BAD_VERSION, frameDecodeHeader((const uint8_t*)json, strlen(json), h));
+
+  uint8_t buf[FRAME_READING_SIZE];
+  frameEncodeReading(header(FRAME_READING), reading(1, 2, 3, 4, 5), buf, sizeof(buf));
+  TEST_ASSERT_FALSE(frameIsLegacyJson(buf, sizeof(buf)));
+}
+
+// Reference values from the SX127x datasheet formula
+void test_time_on_air() {
+  TEST_ASSERT_EQUAL_UINT32(51456, loraTimeOnAirUs(16, 7, 125000, 5));
+  TEST_ASSERT_EQUAL_UINT32(329728, loraTimeOnAirUs(16, 10, 125000, 5));
+  TEST_ASSERT_EQUAL_UINT32(428032, loraTimeOnAirUs(16, 10, 125000, 8));
+  // SF12/125 kHz: low data rate optimisation on
+  TEST_ASSERT_EQUAL_UINT32(1318912, loraTimeOnAirUs(16, 12, 125000, 5));
+  TEST_ASSERT_EQUAL_UINT32(0, loraTimeOnAirUs(16, 7, 0, 5));
+}
+
+void test_max_payload() {
+  TEST_ASSERT_EQUAL_UINT8(24, loraMaxPayload(400000, 10, 125000, 5));
+  TEST_ASSERT_EQUAL_UINT8(255, loraMaxPayload(400000, 7, 500000, 5));
+  TEST_ASSERT_EQUAL_UINT8(0, loraMaxPayload(1000, 7, 125000, 5));
+  for (int length = 1; length < 255; length += 7) {
+    uint32_t us = loraTimeOnAirUs(length, 9, 125000, 6);
+    TEST_ASSERT_GREATER_OR_EQUAL(length, loraMaxPayload(us, 9, 125000, 6));
+    TEST_ASSERT_LESS_THAN(length, loraMaxPayload(us - 1, 9, 125000, 6));
+  }
+}
+
+// A reading must be sendable on every profile, the safe one included
+void test_profiles_fit_dwell() {
+  DutyCycle duty(RADIO_DUTY_REGION, RADIO_AIRTIME_POLICY);
+  for (uint8_t i = 0; i < RADIO_PROFILE_COUNT; i++) {
+    const RadioProfile& p = radioProfile(i);
+    uint32_t us = loraTimeOnAirUs(FRAME_READING_SIZE, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+    TEST_ASSERT_TRUE(duty.fitsDwell(us));
+    TEST_ASSERT_EQUAL_UINT32(0, duty.waitMs(RADIO_FREQUENCY, us, 0));
+  }
+  TEST_ASSERT_EQUAL_UINT32(DutyCycle::NEVER, duty.waitMs(RADIO_FREQUENCY, loraTimeOnAirUs(16, 10, 125000, 8), 0));
+}
+
+// The same reading as the JSON the node used to send, on every profile
+void test_binary_beats_legacy_json() {
+  char legacy[128];
+  int legacyLength = snprintf(legacy, sizeof(legacy),
+    "{\"current\":%.2f,\"depth\":%.1f,\"temp\":%.1f,\"turb_v\":%.2f,\"turb_ntu\":%.1f,\"id\":%d}",
+    12.34, 234.5, 27.5, 1.23, 456.7, 1);
+
+  for (uint8_t i = 0; i < RADIO_PROFILE_COUNT; i++) {
+    const RadioProfile& p = radioProfile(i);
+    uint32_t binaryUs = loraTimeOnAirUs(FRAME_READING_SIZE, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+    uint32_t legacyUs = loraTimeOnAirUs(legacyLength, p.spreadingFactor, p.bandwidthHz, p.codingRate);
+
+    char message[96];
+    snprintf(message, sizeof(message), "SF%u/%lukHz: binary %u B %.1f ms, JSON %d B %.1f ms",
+             p.spreadingFactor, (unsigned long)(p.bandwidthHz / 1000), FRAME_READING_SIZE,
+             binaryUs / 1000.0, legacyLength, legacyUs / 1000.0);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN_UINT32(legacyUs / 2, binaryUs);
+  }
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reading_round_trip);
+  RUN_TEST(test_header_epoch);
+  RUN_TEST(test_reading_needs_room);
+  RUN_TEST(test_temperature_validity);
+  RUN_TEST(test_scale_clamps);
+  RUN_TEST(test_batch_single_sample);
+  RUN_TEST(test_batch_small_deltas);
+  RUN_TEST(test_batch_extreme_deltas);
+  RUN_TEST(test_batch_ages);
+  RUN_TEST(test_batch_ages_out_of_order);
+  RUN_TEST(test_batch_stops_at_batch_max);
+  RUN_TEST(test_batch_fits_cap);
+  RUN_TEST(test_batch_needs_room);
+  RUN_TEST(test_batch_decode_errors);
+  RUN_TEST(test_uplink_decode);
+  RUN_TEST(test_downlink_round_trip);
+  RUN_TEST(test_downlink_rejects_uplink_types);
+  RUN_TEST(test_header_errors);
+  RUN_TEST(test_legacy_json_is_not_a_frame);
+  RUN_TEST(test_time_on_air);
+  RUN_TEST(test_max_payload);
+  RUN_TEST(test_profiles_fit_dwell);
+  RUN_TEST(test_binary_beats_legacy_json);
+  return UNITY_END();
+}
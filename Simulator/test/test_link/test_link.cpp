@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <ReliableLink.h>
+
+// The gateway's duplicate filter, in particular a node restarting its
+// sequence numbers while the gateway keeps running.
+//
+//   pio test -e native
+
+void setUp() {}
+void tearDown() {}
+
+void test_duplicates_dropped() {
+  DuplicateFilter filter;
+  TEST_ASSERT_TRUE(filter.accept(10, 1));
+  TEST_ASSERT_TRUE(filter.accept(11, 1));
+  TEST_ASSERT_FALSE(filter.accept(10, 1));
+  TEST_ASSERT_FALSE(filter.accept(11, 1));
+  TEST_ASSERT_EQUAL_UINT32(2, filter.stats().received);
+  TEST_ASSERT_EQUAL_UINT32(2, filter.stats().duplicates);
+}
+
+void test_gap_filled_late() {
+  DuplicateFilter filter;
+  filter.accept(1, 0);
+  filter.accept(4, 0);
+  TEST_ASSERT_EQUAL_UINT32(2, filter.stats().missing);
+  TEST_ASSERT_TRUE(filter.accept(3, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, filter.stats().missing);
+  TEST_ASSERT_EQUAL_UINT32(1, filter.stats().late);
+}
+
+// Restart while the gateway's highest seq is still inside the window:
+// without the epoch, 0, 1, 2... would look like duplicates
+void test_restart_inside_window() {
+  DuplicateFilter filter;
+  for (uint16_t seq = 0; seq < 20; seq++) filter.accept(seq, 1);
+
+  for (uint16_t seq = 0; seq < 20; seq++) {
+    TEST_ASSERT_TRUE(filter.accept(seq, 2));
+  }
+  TEST_ASSERT_EQUAL_UINT32(40, filter.stats().received);
+  TEST_ASSERT_EQUAL_UINT32(0, filter.stats().duplicates);
+  TEST_ASSERT_EQUAL_UINT32(1, filter.stats().resets);
+  TEST_ASSERT_FALSE(filter.accept(19, 2));
+}
+
+// Restart after more than half the sequence space: without the epoch, 0
+// would look like a jump forward over 30000 missing frames
+void test_restart_after_wrap_half() {
+  DuplicateFilter filter;
+  filter.accept(40000, 3);
+  TEST_ASSERT_TRUE(filter.accept(0, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, filter.stats().missing);
+  TEST_ASSERT_EQUAL_UINT32(1, filter.stats().resets);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, filter.deliveryRatio());
+}
+
+// Four restarts the gateway never heard bring the epoch back round; a
+// count far behind the window is still taken as a restart
+void test_restart_same_epoch_far_behind() {
+  DuplicateFilter filter;
+  filter.accept(500, 1);
+  TEST_ASSERT_TRUE(filter.accept(0, 1));
+  TEST_ASSERT_EQUAL_UINT32(1, filter.stats().resets);
+  TEST_ASSERT_TRUE(filter.accept(1, 1));
+  TEST_ASSERT_EQUAL_UINT32(0, filter.stats().missing);
+}
+
+void test_sequence_wraps() {
+  DuplicateFilter filter;
+  filter.accept(65534, 0);
+  TEST_ASSERT_TRUE(filter.accept(65535, 0));
+  TEST_ASSERT_TRUE(filter.accept(0, 0));
+  TEST_ASSERT_FALSE(filter.accept(65535, 0));
+  TEST_ASSERT_EQUAL_UINT32(0, filter.stats().resets);
+  TEST_ASSERT_EQUAL_UINT32(0, filter.stats().missing);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_duplicates_dropped);
+  RUN_TEST(test_gap_filled_late);
+  RUN_TEST(test_restart_inside_window);
+  RUN_TEST(test_restart_after_wrap_half);
+  RUN_TEST(test_restart_same_epoch_far_behind);
+  RUN_TEST(test_sequence_wraps);
+  return UNITY_END();
+}
@@ -0,0 +1,149 @@
+#include <unity.h>
+#include <math.h>
+#include <SignalFilter.h>
+
+// The median prefilter, the rate-of-change gate and both smoothers,
+// including inputs that arrive at an irregular rate.
+//
+//   pio test -e native
+
+void setUp() {}
+void tearDown() {}
+
+static FilterConfig config(uint8_t medianWindow, SmoothingMode mode, float maxRatePerS, uint8_t gateLimit) {
+  FilterConfig c = {};
+  c.medianWindow = medianWindow;
+  c.mode = mode;
+  c.emaTimeConstantS = 10;
+  c.processNoise = 0.01f;
+  c.measurementNoise = 1;
+  c.maxRatePerS = maxRatePerS;
+  c.gateLimit = gateLimit;
+  return c;
+}
+
+void test_median_drops_single_spike() {
+  SignalFilter filter(config(3, SMOOTH_NONE, 0, 0));
+  filter.update(100, 0);
+  filter.update(100, 1000);
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.update(500, 2000));
+  TEST_ASSERT_EQUAL_FLOAT(500, filter.state().input);
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.state().median);
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.update(100, 3000));
+}
+
+// A jump faster than maxRatePerS is held back, and one that goes away
+// again never reaches the estimate
+void test_gate_rejects_spike() {
+  SignalFilter filter(config(1, SMOOTH_NONE, 5, 3));
+  filter.update(100, 0);
+
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.update(200, 1000));
+  TEST_ASSERT_TRUE(filter.state().gated);
+  TEST_ASSERT_EQUAL_FLOAT(103, filter.update(103, 2000));
+  TEST_ASSERT_FALSE(filter.state().gated);
+
+  // The gate count starts over after an accepted input
+  TEST_ASSERT_EQUAL_FLOAT(103, filter.update(200, 3000));
+  TEST_ASSERT_EQUAL_FLOAT(103, filter.update(200, 4000));
+  TEST_ASSERT_EQUAL_FLOAT(104, filter.update(104, 5000));
+  TEST_ASSERT_EQUAL_UINT32(3, filter.state().rejected);
+}
+
+// A level that stays put for gateLimit inputs is a real step: the filter
+// restarts from it
+void test_gate_accepts_step_after_limit() {
+  SignalFilter filter(config(1, SMOOTH_NONE, 5, 3));
+  filter.update(100, 0);
+
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.update(130, 1000));
+  TEST_ASSERT_EQUAL_FLOAT(100, filter.update(130, 2000));
+  TEST_ASSERT_TRUE(filter.state().gated);
+  TEST_ASSERT_EQUAL_FLOAT(130, filter.update(130, 3000));
+  TEST_ASSERT_FALSE(filter.state().gated);
+  TEST_ASSERT_EQUAL_UINT32(3, filter.state().rejected);
+
+  // The gate allows more change over a longer gap
+  TEST_ASSERT_EQUAL_FLOAT(170, filter.update(170, 13000));
+  TEST_ASSERT_FALSE(filter.state().gated);
+}
+
+// Feeds a step from 0 to 100 at the given times, in milliseconds
+static float emaAfter(const uint32_t* times, uint8_t count) {
+  SignalFilter filter(config(1, SMOOTH_EMA, 0, 0));
+  filter.update(0, 0);
+  for (uint8_t i = 0; i < count; i++) filter.update(100, times[i]);
+  return filter.value();
+}
+
+// The EMA weighs by elapsed time, not by input count: any spacing that
+// ends at the same time ends at 100 * (1 - e^(-t / tau))
+void test_ema_irregular_rate() {
+  static const uint32_t regular[] = { 5000, 10000, 15000, 20000 };
+  static const uint32_t irregular[] = { 300, 1200, 9000, 9100, 17500, 20000 };
+  static const uint32_t single[] = { 20000 };
+  float expected = 100 * (1 - expf(-2.0f));
+
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, expected, emaAfter(regular, 4));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, expected, emaAfter(irregular, 6));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, expected, emaAfter(single, 1));
+}
+
+void test_kalman_converges_irregular_rate() {
+  SignalFilter filter(config(1, SMOOTH_KALMAN, 0, 0));
+  uint32_t now = 0;
+  for (int i = 0; i < 200; i++) {
+    filter.update(i % 2 ? 11 : 9, now);
+    now += 200 + (i * 7919) % 1800;
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, 10, filter.value());
+  float settled = filter.state().variance;
+  TEST_ASSERT_TRUE(settled < 0.1f);
+
+  // A long silence lets the true value drift, so the next input counts
+  // for more
+  filter.update(10, now + 600000);
+  TEST_ASSERT_TRUE(filter.state().variance > settled);
+}
+
+void test_reset() {
+  SignalFilter filter(config(3, SMOOTH_EMA, 5, 3));
+  filter.update(100, 0);
+  filter.update(100, 1000);
+  filter.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, filter.state().samples);
+  TEST_ASSERT_EQUAL_FLOAT(40, filter.update(40, 50000));
+}
+
+// Across deep sleep: a restored filter carries on exactly where the
+// saved one was, gate count and median window included
+void test_save_restore() {
+  FilterConfig c = config(3, SMOOTH_KALMAN, 5, 3);
+  SignalFilter before(c);
+  before.update(100, 0);
+  before.update(101, 1000);
+  before.update(150, 2000);
+
+  SignalFilter::SavedState saved;
+  before.saveState(saved);
+  SignalFilter after(c);
+  after.restoreState(saved);
+
+  for (uint32_t now = 3000; now <= 6000; now += 1000) {
+    TEST_ASSERT_EQUAL_FLOAT(before.update(150, now), after.update(150, now));
+  }
+  TEST_ASSERT_EQUAL_UINT32(before.state().rejected, after.state().rejected);
+  TEST_ASSERT_EQUAL_FLOAT(before.state().variance, after.state().variance);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_median_drops_single_spike);
+  RUN_TEST(test_gate_rejects_spike);
+  RUN_TEST(test_gate_accepts_step_after_limit);
+  RUN_TEST(test_ema_irregular_rate);
+  RUN_TEST(test_kalman_converges_irregular_rate);
+  RUN_TEST(test_reset);
+  RUN_TEST(test_save_restore);
+  return UNITY_END();
+}
@@ -0,0 +1,53 @@
+#include <unity.h>
+#include <RadioProfile.h>
+#include <Simulation.h>
+
+// End-to-end runs of the simulator: both firmwares' pipelines over the
+// simulated channel, checked against what the command line reports.
+//
+//   pio test -e native
+
+#define MIN_DELIVERY 0.95f
+
+void setUp() {}
+void tearDown() {}
+
+SimulationConfig config(float hours, bool portalOpen) {
+  SimulationConfig c = { hours, { 130.0, 4.0, 6.0, 0.02 }, 1, portalOpen };
+  return c;
+}
+
+// Same as simulator --hours 2 --min-delivery 0.95
+void test_min_delivery() {
+  SimulationResults r = runSimulation(config(2, false));
+  TEST_ASSERT_GREATER_THAN_UINT32(3000, r.readings);
+  TEST_ASSERT_TRUE(r.delivery() >= MIN_DELIVERY);
+  TEST_ASSERT_EQUAL_UINT32(0, r.nodeAirtime.overDwell);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(RADIO_DUTY_REGION.maxDwellUs, r.nodeAirtime.maxFrameUs);
+}
+
+// Every reading the gateway accepted lands in exactly one upload window
+void test_windows_hold_every_reading() {
+  SimulationResults r = runSimulation(config(1, false));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, r.windows);
+  TEST_ASSERT_EQUAL_UINT32(r.delivered, r.windowSamples);
+}
+
+// Live samples for an open portal read the filters without feeding them,
+// so the node transmits exactly the same readings
+void test_portal_leaves_readings_alone() {
+  SimulationResults closed = runSimulation(config(1, false));
+  SimulationResults open = runSimulation(config(1, true));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, open.liveSamples);
+  TEST_ASSERT_EQUAL_UINT32(closed.delivered, open.delivered);
+  TEST_ASSERT_EQUAL_FLOAT(closed.depthError.rms(), open.depthError.rms());
+  TEST_ASSERT_EQUAL_FLOAT(closed.ntuError.rms(), open.ntuError.rms());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_min_delivery);
+  RUN_TEST(test_windows_hold_every_reading);
+  RUN_TEST(test_portal_leaves_readings_alone);
+  return UNITY_END();
+}
@@ -0,0 +1,94 @@
+#include "ConfigStore.h"
+#include <string.h>
+
+uint32_t configCrc32(const void* data, size_t length) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *p++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+void configSeal(uint8_t* record, uint16_t schema, uint32_t sequence,
+                const void* payload, uint16_t length) {
+  ConfigHeader header;
+  header.magic = CONFIG_MAGIC;
+  header.schema = schema;
+  header.length = length;
+  header.sequence = sequence;
+  header.crc = configCrc32(payload, length);
+  memcpy(record, &header, sizeof(header));
+  memcpy(record + sizeof(header), payload, length);
+}
+
+bool configValidate(const uint8_t* record, size_t recordLength,
+                    uint16_t schema, uint16_t length) {
+  if (recordLength != sizeof(ConfigHeader) + length) return false;
+
+  ConfigHeader header;
+  memcpy(&header, record, sizeof(header));
+  if (header.magic != CONFIG_MAGIC) return false;
+  if (header.schema != schema || header.length != length) return false;
+  return header.crc == configCrc32(record + sizeof(header), length);
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+static const char* const SLOT_KEYS[2] = { "a", "b" };
+
+ConfigStore::ConfigStore(const char* name, uint16_t schema, void* payload, uint16_t length)
+  : _name(name), _schema(schema), _payload(payload), _length(length),
+    _slot(1), _sequence(0), _commits(0), _dirty(false), _dirtySince(0) {}
+
+bool ConfigStore::begin() {
+  if (_length > CONFIG_MAX_PAYLOAD || !_prefs.begin(_name, false)) return false;
+
+  static uint8_t record[sizeof(ConfigHeader) + CONFIG_MAX_PAYLOAD];
+  bool found = false;
+  for (uint8_t slot = 0; slot < 2; slot++) {
+    size_t n = _prefs.getBytes(SLOT_KEYS[slot], record, sizeof(record));
+    if (!configValidate(record, n, _schema, _length)) continue;
+
+    ConfigHeader header;
+    memcpy(&header, record, sizeof(header));
+    if (found && (int32_t)(header.sequence - _sequence) <= 0) continue;
+
+    memcpy(_payload, record + sizeof(header), _length);
+    _sequence = header.sequence;
+    _slot = slot;
+    found = true;
+  }
+  return found;
+}
+
+void ConfigStore::markDirty() {
+  _dirty = true;
+  _dirtySince = millis();
+}
+
+bool ConfigStore::service() {
+  if (!_dirty || millis() - _dirtySince < COMMIT_DELAY_MS) return false;
+  return commit();
+}
+
+bool ConfigStore::commit() {
+  static uint8_t record[sizeof(ConfigHeader) + CONFIG_MAX_PAYLOAD];
+  if (_length > CONFIG_MAX_PAYLOAD) return false;
+
+  uint8_t slot = _slot ^ 1;
+  configSeal(record, _schema, _sequence + 1, _payload, _length);
+  size_t size = sizeof(ConfigHeader) + _length;
+  if (_prefs.putBytes(SLOT_KEYS[slot], record, size) != size) return false;
+
+  _slot = slot;
+  _sequence++;
+  _commits++;
+  _dirty = false;
+  return true;
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Versioned configuration record shared by the sensor node and the
+// gateway. Each firmware defines its own plain-data payload struct and a
+// schema id for it; the record wraps the payload in a header:
+//
+//   0  magic     CONFIG_MAGIC
+//   4  schema    uint16, bumped whenever the payload layout changes
+//   6  length    uint16, payload bytes
+//   8  sequence  uint32, incremented on every commit
+//   12 crc       CRC-32 of the payload
+//   16 payload
+//
+// A record with the wrong magic, schema, length or CRC is rejected as a
+// whole, so boot either gets a complete valid payload or the defaults.
+
+#define CONFIG_MAGIC 0x43464731   // "CFG1"
+#define CONFIG_MAX_PAYLOAD 496
+
+struct ConfigHeader {
+  uint32_t magic;
+  uint16_t schema;
+  uint16_t length;
+  uint32_t sequence;
+  uint32_t crc;
+};
+
+uint32_t configCrc32(const void* data, size_t length);
+
+// Fill in the header for payload. record must hold sizeof(ConfigHeader)
+// plus length bytes; the payload is copied in behind the header.
+void configSeal(uint8_t* record, uint16_t schema, uint32_t sequence,
+                const void* payload, uint16_t length);
+
+// True when record is a complete, intact record of this schema and length.
+bool configValidate(const uint8_t* record, size_t recordLength,
+                    uint16_t schema, uint16_t length);
+
+#ifdef ARDUINO
+#include <Preferences.h>
+
+// Record kept in NVS under two keys used alternately (A/B). NVS is
+// log-structured and wear-levelled, and a commit writes the slot that is
+// not current, so a reset mid-write leaves the previous record intact.
+//
+// Web handlers change the payload in RAM and call markDirty(); loop()
+// calls service(), which commits once changes have settled for
+// COMMIT_DELAY_MS. Several quick edits cost one flash write, and no
+// handler waits for a flash erase.
+class ConfigStore {
+public:
+  static const unsigned long COMMIT_DELAY_MS = 2000;
+
+  // payload is the caller's struct, read from and written to in place.
+  ConfigStore(const char* name, uint16_t schema, void* payload, uint16_t length);
+
+  // Load the newest valid slot into payload, one read per slot. Returns
+  // false (payload untouched) when neither slot holds a valid record.
+  bool begin();
+
+  void markDirty();
+  bool dirty() const { return _dirty; }
+
+  // Commit if dirty and settled. Returns true when a commit happened.
+  bool service();
+
+  // Write the payload now to the inactive slot.
+  bool commit();
+
+  uint32_t sequence() const { return _sequence; }
+  uint32_t commits() const { return _commits; }
+
+private:
+  Preferences _prefs;
+  const char* _name;
+  uint16_t _schema;
+  void* _payload;
+  uint16_t _length;
+  uint8_t _slot;             // slot holding the current record
+  uint32_t _sequence;
+  uint32_t _commits;
+  bool _dirty;
+  unsigned long _dirtySince;
+};
+#endif
+
+#endif
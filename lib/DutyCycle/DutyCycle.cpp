@@ -0,0 +1,116 @@
+#include "DutyCycle.h"
+#include <string.h>
+
+static const DutyCycleBand EU868_BANDS[] = {
+  { 863000000, 865000000, 0.001 },
+  { 865000000, 868000000, 0.01 },
+  { 868000000, 868600000, 0.01 },
+  { 868700000, 869200000, 0.001 },
+  { 869400000, 869650000, 0.10 },
+  { 869700000, 870000000, 0.01 },
+};
+const DutyCycleRegion DUTY_REGION_EU868 = {
+  "EU868", EU868_BANDS, sizeof(EU868_BANDS) / sizeof(EU868_BANDS[0]), 0
+};
+
+static const DutyCycleBand US915_BANDS[] = {
+  { 902000000, 928000000, 0 },
+};
+const DutyCycleRegion DUTY_REGION_US915 = {
+  "US915", US915_BANDS, sizeof(US915_BANDS) / sizeof(US915_BANDS[0]), 400000
+};
+
+DutyCycle::DutyCycle(const DutyCycleRegion& region, float policy)
+  : _region(&region), _policy(policy), _bucket(0) {
+  memset(_airtime, 0, sizeof(_airtime));
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+uint8_t DutyCycle::band(uint32_t frequencyHz) const {
+  for (uint8_t i = 0; i < _region->bandCount && i < MAX_BANDS; i++) {
+    const DutyCycleBand& b = _region->bands[i];
+    if (frequencyHz >= b.lowHz && frequencyHz < b.highHz) return i;
+  }
+  return MAX_BANDS;
+}
+
+uint32_t DutyCycle::limitUs(uint32_t frequencyHz) const {
+  uint8_t b = band(frequencyHz);
+  float duty = b < MAX_BANDS ? _region->bands[b].duty : 0;
+  if (_policy > 0 && (duty == 0 || _policy < duty)) duty = _policy;
+  if (duty <= 0) return NEVER;
+  return (uint32_t)(duty * WINDOW_MS * 1000.0f);
+}
+
+// Clear the buckets that fell out of the window since the last call. A
+// jump backwards (the millisecond clock wrapped) starts a new window.
+void DutyCycle::advance(uint32_t now) {
+  uint32_t bucket = now / BUCKET_MS;
+  uint32_t steps = bucket - _bucket;
+  if (steps == 0) return;
+  if (steps > BUCKETS || bucket < _bucket) {
+    memset(_airtime, 0, sizeof(_airtime));
+  } else {
+    for (uint32_t i = 1; i <= steps; i++) {
+      uint8_t slot = (_bucket + i) % (BUCKETS + 1);
+      for (uint8_t b = 0; b <= MAX_BANDS; b++) _airtime[b][slot] = 0;
+    }
+  }
+  _bucket = bucket;
+}
+
+uint32_t DutyCycle::sum(uint8_t band) const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i <= BUCKETS; i++) total += _airtime[band][i];
+  return total;
+}
+
+uint32_t DutyCycle::usedUs(uint32_t frequencyHz, uint32_t now) {
+  advance(now);
+  return sum(band(frequencyHz));
+}
+
+uint32_t DutyCycle::waitMs(uint32_t frequencyHz, uint32_t airtimeUs, uint32_t now) {
+  if (!fitsDwell(airtimeUs)) return NEVER;
+  uint32_t limit = limitUs(frequencyHz);
+  if (limit == NEVER) return 0;
+  if (airtimeUs > limit) return NEVER;
+
+  advance(now);
+  uint8_t b = band(frequencyHz);
+  uint32_t used = sum(b);
+  if (used + airtimeUs <= limit) return 0;
+
+  // Walk from the oldest bucket: the one `age` buckets back leaves the
+  // window when bucket _bucket + BUCKETS + 1 - age begins
+  uint32_t intoBucket = now % BUCKET_MS;
+  for (int age = BUCKETS; age >= 0; age--) {
+    used -= _airtime[b][(_bucket + BUCKETS + 1 - age) % (BUCKETS + 1)];
+    if (used + airtimeUs <= limit) {
+      return (uint32_t)(BUCKETS + 1 - age) * BUCKET_MS - intoBucket;
+    }
+  }
+  return NEVER;
+}
+
+void DutyCycle::record(uint32_t frequencyHz, uint32_t airtimeUs, uint32_t now) {
+  advance(now);
+  _airtime[band(frequencyHz)][_bucket % (BUCKETS + 1)] += airtimeUs;
+
+  _stats.frames++;
+  _stats.airtimeUs += airtimeUs;
+  if (airtimeUs > _stats.maxFrameUs) _stats.maxFrameUs = airtimeUs;
+  if (_region->maxDwellUs && airtimeUs > _region->maxDwellUs) _stats.overDwell++;
+}
+
+void DutyCycle::saveState(SavedState& out) const {
+  out.bucket = _bucket;
+  memcpy(out.airtime, _airtime, sizeof(_airtime));
+  out.stats = _stats;
+}
+
+void DutyCycle::restoreState(const SavedState& in) {
+  _bucket = in.bucket;
+  memcpy(_airtime, in.airtime, sizeof(_airtime));
+  _stats = in.stats;
+}
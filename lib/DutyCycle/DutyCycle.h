@@ -0,0 +1,102 @@
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <stdint.h>
+
+// Airtime accounting for one transmitter, shared by the sensor node and
+// the gateway. Every frame's time on air (see LoRaAirtime.h) is recorded
+// against the sub-band of its frequency, and a send is allowed only while
+// the airtime of the last WINDOW_MS stays within the band's budget and the
+// frame itself within the region's dwell limit.
+//
+// The window is kept as BUCKETS + 1 buckets of BUCKET_MS per band, so
+// memory is fixed and the check is conservative by at most one bucket.
+// The node carries the buckets across deep sleep with saveState().
+
+// One regulated sub-band. duty is the share of the window a transmitter
+// may use; 0 leaves the band to the node's own policy.
+struct DutyCycleBand {
+  uint32_t lowHz;
+  uint32_t highHz;
+  float duty;
+};
+
+struct DutyCycleRegion {
+  const char* name;
+  const DutyCycleBand* bands;
+  uint8_t bandCount;
+  uint32_t maxDwellUs;     // longest single transmission, 0 = no limit
+};
+
+// ETSI EN 300 220 sub-bands as used by LoRaWAN EU868
+extern const DutyCycleRegion DUTY_REGION_EU868;
+// FCC part 15.247: no duty cycle, 400 ms dwell time
+extern const DutyCycleRegion DUTY_REGION_US915;
+
+struct DutyCycleStats {
+  uint32_t frames;
+  uint64_t airtimeUs;      // since boot (or since the RTC copy began)
+  uint32_t maxFrameUs;
+  uint32_t deferred;       // sends held back by the budget
+  uint32_t overDwell;      // frames longer than the region's dwell limit (sent anyway)
+};
+
+class DutyCycle {
+public:
+  static const uint8_t MAX_BANDS = 6;
+  static const uint8_t BUCKETS = 20;
+  static const uint32_t WINDOW_MS = 3600000;
+  static const uint32_t BUCKET_MS = WINDOW_MS / BUCKETS;
+  static const uint32_t NEVER = 0xFFFFFFFF;
+
+  // The accounting as plain data; region and policy stay with the owner
+  struct SavedState {
+    uint32_t bucket;
+    uint32_t airtime[MAX_BANDS + 1][BUCKETS + 1];
+    DutyCycleStats stats;
+  };
+
+  // policy caps every band at that share of the window on top of the
+  // regional limit, or alone where the region sets none; 0 disables it.
+  DutyCycle(const DutyCycleRegion& region, float policy);
+
+  // Airtime budget per window in the band of frequencyHz, NEVER when
+  // neither the region nor the policy limits it.
+  uint32_t limitUs(uint32_t frequencyHz) const;
+
+  // Airtime spent in the band within the window.
+  uint32_t usedUs(uint32_t frequencyHz, uint32_t now);
+
+  // Milliseconds until airtimeUs fits the budget: 0 when it fits now,
+  // NEVER when the frame is longer than the whole budget or the dwell
+  // limit.
+  uint32_t waitMs(uint32_t frequencyHz, uint32_t airtimeUs, uint32_t now);
+
+  // False when one transmission of airtimeUs breaks the dwell limit
+  bool fitsDwell(uint32_t airtimeUs) const {
+    return _region->maxDwellUs == 0 || airtimeUs <= _region->maxDwellUs;
+  }
+
+  void record(uint32_t frequencyHz, uint32_t airtimeUs, uint32_t now);
+  void deferred() { _stats.deferred++; }
+
+  void saveState(SavedState& out) const;
+  void restoreState(const SavedState& in);
+
+  const DutyCycleStats& stats() const { return _stats; }
+  const DutyCycleRegion& region() const { return *_region; }
+
+private:
+  // Slot MAX_BANDS holds frequencies outside every regulated band
+  uint8_t band(uint32_t frequencyHz) const;
+  void advance(uint32_t now);
+  uint32_t sum(uint8_t band) const;
+
+  const DutyCycleRegion* _region;
+  float _policy;
+  uint32_t _bucket;        // number of the current bucket, now / BUCKET_MS
+  uint32_t _airtime[MAX_BANDS + 1][BUCKETS + 1];
+  DutyCycleStats _stats;
+};
+
+#endif
@@ -0,0 +1,129 @@
+#include "InterruptRadioDriver.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <LoRa.h>
+#include <RadioProfile.h>
+
+bool InterruptRadioDriver::begin(uint8_t dio0Pin, UBaseType_t priority, BaseType_t core) {
+  _dio0Pin = dio0Pin;
+  _mutex = xSemaphoreCreateMutex();
+  if (_mutex == nullptr) return false;
+  if (xTaskCreatePinnedToCore(taskEntry, "lora_rx", 3072, this, priority, &_task, core) != pdPASS) {
+    return false;
+  }
+
+  pinMode(dio0Pin, INPUT);
+  attachInterruptArg(digitalPinToInterrupt(dio0Pin), onDio0, this, RISING);
+
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  LoRa.receive();
+  xSemaphoreGive(_mutex);
+  return true;
+}
+
+void IRAM_ATTR InterruptRadioDriver::onDio0(void* arg) {
+  InterruptRadioDriver* self = static_cast<InterruptRadioDriver*>(arg);
+  self->_irqAt = millis();
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(self->_task, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void InterruptRadioDriver::taskEntry(void* arg) {
+  static_cast<InterruptRadioDriver*>(arg)->run();
+}
+
+void InterruptRadioDriver::run() {
+  for (;;) {
+    // The timeout also catches an edge missed while DIO0 was already high
+    bool notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)) > 0;
+    if (digitalRead(_dio0Pin) == LOW) continue;
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    // transmit() may have collected the frame in the meantime
+    if (digitalRead(_dio0Pin) == HIGH) collect(notified ? _irqAt : millis());
+    xSemaphoreGive(_mutex);
+  }
+}
+
+// Called with the mutex held and DIO0 high. parsePacket() clears RxDone
+// and leaves the radio idle, so the receiver is re-armed at the end.
+void InterruptRadioDriver::collect(uint32_t receivedAt) {
+  int length = LoRa.parsePacket();
+  if (length == 0) {
+    _stats.crcErrors++;
+  } else {
+    Packet* slot = _ring.claim();
+    if (slot == nullptr) {
+      _stats.dropped++;
+    } else {
+      size_t n = 0;
+      while (LoRa.available()) {
+        int b = LoRa.read();
+        if (n < MAX_PACKET) slot->data[n++] = (uint8_t)b;
+      }
+      slot->length = n;
+      slot->rssi = LoRa.packetRssi();
+      slot->snr = LoRa.packetSnr();
+      slot->receivedAt = receivedAt;
+      _ring.publish();
+
+      _stats.received++;
+      uint32_t waiting = _ring.size();
+      if (waiting > _stats.highWater) _stats.highWater = waiting;
+    }
+  }
+  LoRa.receive();
+}
+
+size_t InterruptRadioDriver::receive(uint8_t* buf, size_t cap) {
+  const Packet* packet = _ring.front();
+  if (packet == nullptr) return 0;
+
+  size_t length = packet->length < cap ? packet->length : cap;
+  memcpy(buf, packet->data, length);
+  _rssi = packet->rssi;
+  _snr = packet->snr;
+  _receivedAt = packet->receivedAt;
+  _ring.release();
+  return length;
+}
+
+bool InterruptRadioDriver::transmit(const uint8_t* packet, size_t length) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  // The TX payload goes through the same FIFO: take a frame that has just
+  // arrived out first
+  if (digitalRead(_dio0Pin) == HIGH) collect(millis());
+
+  LoRa.beginPacket();
+  LoRa.write(packet, length);
+  bool sent = LoRa.endPacket();
+  LoRa.receive();
+  xSemaphoreGive(_mutex);
+  return sent;
+}
+
+void InterruptRadioDriver::applyProfile(uint8_t index) {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  LoRa.idle();
+  radioApplyProfile(index);
+  LoRa.receive();
+  xSemaphoreGive(_mutex);
+}
+
+void InterruptRadioDriver::idle() {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  LoRa.idle();
+  xSemaphoreGive(_mutex);
+}
+
+void InterruptRadioDriver::sleep() {
+  xSemaphoreTake(_mutex, portMAX_DELAY);
+  LoRa.sleep();
+  xSemaphoreGive(_mutex);
+}
+
+InterruptRadioStats InterruptRadioDriver::stats() const {
+  return _stats;
+}
+#endif
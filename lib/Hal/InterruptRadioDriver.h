@@ -0,0 +1,79 @@
+#ifndef INTERRUPT_RADIO_DRIVER_H
+#define INTERRUPT_RADIO_DRIVER_H
+
+#include "RadioDriver.h"
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <Arduino.h>
+#include <SpscRing.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// Interrupt-driven receive for the gateway. The radio stays in continuous
+// receive; DIO0 (RxDone) wakes a high-priority task that copies the frame
+// out of the SX127x FIFO into a ring, together with its RSSI, SNR and
+// arrival time, and re-arms the receiver straight away. Frames therefore
+// keep arriving while the caller is blocked in an upload or a redraw,
+// and receive() hands them out at the caller's pace.
+//
+// The LoRa library's own onReceive() reads the FIFO over SPI inside the
+// ISR, which the ESP32 does not allow; here the ISR only notifies.
+// Every radio access, including transmit() and applyProfile() from the
+// caller's task, goes through one mutex.
+struct InterruptRadioStats {
+  uint32_t received;     // frames put into the ring
+  uint32_t dropped;      // frames lost because the ring was full
+  uint32_t crcErrors;    // RxDone with a bad payload CRC
+  uint32_t highWater;    // most frames ever waiting in the ring
+};
+
+class InterruptRadioDriver : public RadioDriver {
+public:
+  static const uint32_t RING_SIZE = 8;
+  static const size_t MAX_PACKET = 255;
+
+  // LoRa.begin() must have been called. Starts the receive task and puts
+  // the radio into continuous receive.
+  bool begin(uint8_t dio0Pin, UBaseType_t priority, BaseType_t core);
+
+  bool transmit(const uint8_t* packet, size_t length) override;
+  size_t receive(uint8_t* buf, size_t cap) override;
+  int packetRssi() override { return _rssi; }
+  float packetSnr() override { return _snr; }
+  void applyProfile(uint8_t index) override;
+  void idle() override;
+  void sleep() override;
+
+  // millis() at RxDone of the frame last returned by receive()
+  uint32_t packetTime() const { return _receivedAt; }
+  uint32_t queued() const { return _ring.size(); }
+  InterruptRadioStats stats() const;
+
+private:
+  struct Packet {
+    uint8_t data[MAX_PACKET];
+    uint8_t length;
+    int16_t rssi;
+    float snr;
+    uint32_t receivedAt;
+  };
+
+  static void IRAM_ATTR onDio0(void* arg);
+  static void taskEntry(void* arg);
+  void run();
+  void collect(uint32_t receivedAt);
+
+  SpscRing<Packet, RING_SIZE> _ring;
+  SemaphoreHandle_t _mutex = nullptr;
+  TaskHandle_t _task = nullptr;
+  uint8_t _dio0Pin = 0;
+  volatile uint32_t _irqAt = 0;
+  InterruptRadioStats _stats = {};
+  int _rssi = 0;
+  float _snr = 0;
+  uint32_t _receivedAt = 0;
+};
+#endif
+
+#endif
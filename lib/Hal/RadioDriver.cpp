@@ -0,0 +1,44 @@
+#include "RadioDriver.h"
+
+#ifdef ARDUINO
+#include <LoRa.h>
+#include <RadioProfile.h>
+
+bool LoRaRadioDriver::transmit(const uint8_t* packet, size_t length) {
+  LoRa.beginPacket();
+  LoRa.write(packet, length);
+  return LoRa.endPacket();
+}
+
+size_t LoRaRadioDriver::receive(uint8_t* buf, size_t cap) {
+  if (LoRa.parsePacket() == 0) return 0;
+
+  // Drain the FIFO even when the packet is longer than buf
+  size_t length = 0;
+  while (LoRa.available()) {
+    int b = LoRa.read();
+    if (length < cap) buf[length++] = (uint8_t)b;
+  }
+  return length;
+}
+
+int LoRaRadioDriver::packetRssi() {
+  return LoRa.packetRssi();
+}
+
+float LoRaRadioDriver::packetSnr() {
+  return LoRa.packetSnr();
+}
+
+void LoRaRadioDriver::applyProfile(uint8_t index) {
+  radioApplyProfile(index);
+}
+
+void LoRaRadioDriver::idle() {
+  LoRa.idle();
+}
+
+void LoRaRadioDriver::sleep() {
+  LoRa.sleep();
+}
+#endif
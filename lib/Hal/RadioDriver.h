@@ -0,0 +1,49 @@
+#ifndef RADIO_DRIVER_H
+#define RADIO_DRIVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Packet-level radio abstraction shared by the sensor node and the
+// gateway. The firmware uses LoRaRadioDriver; the host simulator
+// substitutes a simulated channel. Time is never read here: callers pass
+// timestamps to the protocol code themselves, as with AdcSource.
+class RadioDriver {
+public:
+  virtual ~RadioDriver() {}
+
+  // Send one packet and wait until it is on the air. Returns false if the
+  // transceiver did not finish the transmission.
+  virtual bool transmit(const uint8_t* packet, size_t length) = 0;
+
+  // Non-blocking poll. Copies up to cap bytes of a received packet into
+  // buf and returns its length (bytes beyond cap are dropped), or 0.
+  virtual size_t receive(uint8_t* buf, size_t cap) = 0;
+
+  // Link quality of the last received packet.
+  virtual int packetRssi() = 0;
+  virtual float packetSnr() = 0;
+
+  // Switch to an entry of RADIO_PROFILES.
+  virtual void applyProfile(uint8_t index) = 0;
+
+  virtual void idle() = 0;
+  virtual void sleep() = 0;
+};
+
+#ifdef ARDUINO
+// SX127x through the LoRa library, which must already be started with
+// LoRa.begin().
+class LoRaRadioDriver : public RadioDriver {
+public:
+  bool transmit(const uint8_t* packet, size_t length) override;
+  size_t receive(uint8_t* buf, size_t cap) override;
+  int packetRssi() override;
+  float packetSnr() override;
+  void applyProfile(uint8_t index) override;
+  void idle() override;
+  void sleep() override;
+};
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+#include "LoRaAirtime.h"
+
+uint32_t loraTimeOnAirUs(uint8_t payloadLength, uint8_t spreadingFactor,
+                         uint32_t bandwidthHz, uint8_t codingRateDenominator,
+                         bool crc, bool implicitHeader, uint16_t preambleLength) {
+  if (bandwidthHz == 0) return 0;
+
+  // Symbol time in microseconds (2^SF / BW)
+  uint32_t symbolUs = (uint32_t)(((uint64_t)1000000 << spreadingFactor) / bandwidthHz);
+  int lowDataRate = symbolUs > 16000 ? 1 : 0;
+
+  int32_t numerator = 8 * payloadLength - 4 * spreadingFactor + 28
+                    + (crc ? 16 : 0) - (implicitHeader ? 20 : 0);
+  int32_t denominator = 4 * (spreadingFactor - 2 * lowDataRate);
+  int32_t payloadSymbols = 0;
+  if (numerator > 0) {
+    payloadSymbols = ((numerator + denominator - 1) / denominator) * codingRateDenominator;
+  }
+  payloadSymbols += 8;
+
+  // Preamble is (n + 4.25) symbols; keep the quarter symbol exact
+  uint64_t preambleUs = ((uint64_t)(preambleLength * 4 + 17) * symbolUs) / 4;
+  return (uint32_t)(preambleUs + (uint64_t)payloadSymbols * symbolUs);
+}
+
+uint8_t loraMaxPayload(uint32_t maxAirtimeUs, uint8_t spreadingFactor,
+                       uint32_t bandwidthHz, uint8_t codingRateDenominator,
+                       bool crc, bool implicitHeader, uint16_t preambleLength) {
+  // Time on air never falls as the payload grows: binary search
+  uint16_t low = 0;
+  uint16_t high = 256;
+  while (high - low > 1) {
+    uint16_t mid = (low + high) / 2;
+    uint32_t us = loraTimeOnAirUs(mid, spreadingFactor, bandwidthHz, codingRateDenominator,
+                                  crc, implicitHeader, preambleLength);
+    if (us <= maxAirtimeUs) low = mid; else high = mid;
+  }
+  return low;
+}
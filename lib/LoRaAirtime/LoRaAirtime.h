@@ -0,0 +1,22 @@
+#ifndef LORA_AIRTIME_H
+#define LORA_AIRTIME_H
+
+#include <stdint.h>
+
+// LoRa time-on-air in microseconds, per the SX127x datasheet (section 4.1.1.7).
+// codingRateDenominator is 5..8 for 4/5..4/8, as passed to setCodingRate4().
+// Low data rate optimisation is assumed on whenever a symbol exceeds 16 ms,
+// which is what the LoRa library does.
+uint32_t loraTimeOnAirUs(uint8_t payloadLength, uint8_t spreadingFactor,
+                         uint32_t bandwidthHz, uint8_t codingRateDenominator,
+                         bool crc = true, bool implicitHeader = false,
+                         uint16_t preambleLength = 8);
+
+// Longest payload (up to 255 bytes) whose time on air stays within
+// maxAirtimeUs, for sizing frames under a dwell limit. 0 if none fits.
+uint8_t loraMaxPayload(uint32_t maxAirtimeUs, uint8_t spreadingFactor,
+                       uint32_t bandwidthHz, uint8_t codingRateDenominator,
+                       bool crc = true, bool implicitHeader = false,
+                       uint16_t preambleLength = 8);
+
+#endif
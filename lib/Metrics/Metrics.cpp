@@ -0,0 +1,90 @@
+#include "Metrics.h"
+
+#if METRICS_ENABLED
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+uint32_t metricsNowUs() {
+  return micros();
+}
+#else
+#include <chrono>
+
+uint32_t metricsNowUs() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+Metric* Metric::_first = nullptr;
+Metric* Metric::_last = nullptr;
+
+Metric::Metric(const char* name, const char* help)
+  : _name(name), _help(help), _next(nullptr) {
+  if (_last) {
+    _last->_next = this;
+  } else {
+    _first = this;
+  }
+  _last = this;
+}
+
+// Advance len by an snprintf result, clamped to the buffer
+static size_t append(size_t size, size_t len, int written) {
+  if (written < 0) return len;
+  len += written;
+  return len < size ? len : size - 1;
+}
+
+static size_t formatHeader(char* text, size_t size, const char* name, const char* type, const char* help) {
+  return append(size, 0, snprintf(text, size, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type));
+}
+
+size_t metricsFormatValue(char* text, size_t size, const char* name, const char* type,
+                          const char* help, double value) {
+  size_t len = formatHeader(text, size, name, type, help);
+  return append(size, len, snprintf(text + len, size - len, "%s %.15g\n", name, value));
+}
+
+size_t MetricCounter::format(char* text, size_t size) const {
+  return metricsFormatValue(text, size, _name, "counter", _help, _value);
+}
+
+LatencyHistogram::LatencyHistogram(const char* name, const char* help)
+  : Metric(name, help), _count(0), _sumUs(0) {
+  memset((void*)_buckets, 0, sizeof(_buckets));
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  // Bucket i holds durations up to 4^i us: ceil(log4(us))
+  uint8_t bucket = us <= 1 ? 0 : (31 - __builtin_clz(us - 1)) / 2 + 1;
+  if (bucket > BUCKETS) bucket = BUCKETS;
+  _buckets[bucket]++;
+  _sumUs += us;
+  _count++;
+}
+
+size_t LatencyHistogram::format(char* text, size_t size) const {
+  uint32_t buckets[BUCKETS + 1];
+  for (uint8_t i = 0; i <= BUCKETS; i++) buckets[i] = _buckets[i];
+  uint64_t sumUs = _sumUs;
+
+  size_t len = formatHeader(text, size, _name, "histogram", _help);
+  uint32_t cumulative = 0;
+  uint32_t boundUs = 1;
+  for (uint8_t i = 0; i < BUCKETS; i++) {
+    cumulative += buckets[i];
+    len = append(size, len, snprintf(text + len, size - len, "%s_bucket{le=\"%.6f\"} %lu\n",
+                                     _name, boundUs / 1e6, (unsigned long)cumulative));
+    boundUs *= 4;
+  }
+  cumulative += buckets[BUCKETS];
+  len = append(size, len, snprintf(text + len, size - len,
+    "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %.6f\n%s_count %lu\n",
+    _name, (unsigned long)cumulative, _name, sumUs / 1e6, _name, (unsigned long)cumulative));
+  return len;
+}
+#endif
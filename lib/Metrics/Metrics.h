@@ -0,0 +1,131 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hot-path instrumentation for both firmwares: fixed-bucket latency
+// histograms and counters, served in Prometheus text format at /metrics.
+//
+// A probe is two clock reads, a count-leading-zeros and three increments,
+// about a microsecond on the ESP32. Each metric must have a single writer
+// (one task or the timer callback); a scrape reads it unlocked and may see
+// a sample in _count before it reaches _sum.
+//
+// Build with -DMETRICS_ENABLED=0 to compile every probe, metric and the
+// endpoint out of the firmware.
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1
+#endif
+
+#if METRICS_ENABLED
+
+// Largest text format() produces for one metric
+#define METRICS_TEXT_MAX 1024
+
+uint32_t metricsNowUs();
+
+// Registered metrics form a list in construction order, so they are
+// declared once as globals and found again by the /metrics handler.
+class Metric {
+public:
+  Metric(const char* name, const char* help);
+  virtual ~Metric() {}
+
+  // Writes the metric's HELP, TYPE and sample lines. Returns the length.
+  virtual size_t format(char* text, size_t size) const = 0;
+
+  const char* name() const { return _name; }
+  const Metric* next() const { return _next; }
+  static const Metric* first() { return _first; }
+
+protected:
+  const char* _name;
+  const char* _help;
+
+private:
+  const Metric* _next;
+  static Metric* _first;
+  static Metric* _last;
+};
+
+class MetricCounter : public Metric {
+public:
+  MetricCounter(const char* name, const char* help) : Metric(name, help), _value(0) {}
+
+  void increment(uint32_t n = 1) { _value += n; }
+  uint32_t value() const { return _value; }
+  size_t format(char* text, size_t size) const override;
+
+private:
+  volatile uint32_t _value;
+};
+
+// Durations in power-of-four microsecond buckets, 1 us to 4.2 s, exported
+// as a Prometheus histogram in seconds. The bucket is found from the bit
+// length of the duration, without a search.
+class LatencyHistogram : public Metric {
+public:
+  static const uint8_t BUCKETS = 12;   // plus +Inf
+
+  LatencyHistogram(const char* name, const char* help);
+
+  void record(uint32_t us);
+  uint32_t count() const { return _count; }
+  size_t format(char* text, size_t size) const override;
+
+private:
+  volatile uint32_t _buckets[BUCKETS + 1];
+  volatile uint32_t _count;
+  volatile uint64_t _sumUs;
+};
+
+// Times the rest of the enclosing scope
+class MetricTimer {
+public:
+  explicit MetricTimer(LatencyHistogram& histogram) : _histogram(histogram), _start(metricsNowUs()) {}
+  ~MetricTimer() { _histogram.record(metricsNowUs() - _start); }
+
+private:
+  LatencyHistogram& _histogram;
+  uint32_t _start;
+};
+
+// A single sample line for values the firmware already keeps elsewhere
+// (link statistics, queue drops). type is "counter" or "gauge".
+size_t metricsFormatValue(char* text, size_t size, const char* name, const char* type,
+                          const char* help, double value);
+
+// Every registered metric into out, which needs a print(const char*)
+template <typename Out>
+void metricsWrite(Out& out) {
+  char text[METRICS_TEXT_MAX];
+  for (const Metric* m = Metric::first(); m; m = m->next()) {
+    if (m->format(text, sizeof(text)) > 0) out.print(text);
+  }
+}
+
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+
+#define METRIC_HISTOGRAM(var, name, help) LatencyHistogram var(name, help)
+#define METRIC_COUNTER(var, name, help) MetricCounter var(name, help)
+#define METRIC_TIME(var) MetricTimer METRICS_CONCAT(metricTimer, __LINE__)(var)
+#define METRIC_STAMP(stamp) uint32_t stamp = metricsNowUs()
+#define METRIC_SINCE(var, stamp) var.record(metricsNowUs() - (stamp))
+#define METRIC_RECORD(var, us) var.record(us)
+#define METRIC_COUNT(var) var.increment()
+
+#else
+
+#define METRIC_HISTOGRAM(var, name, help)
+#define METRIC_COUNTER(var, name, help)
+#define METRIC_TIME(var)
+#define METRIC_STAMP(stamp)
+#define METRIC_SINCE(var, stamp) ((void)0)
+#define METRIC_RECORD(var, us) ((void)0)
+#define METRIC_COUNT(var) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+#include "RadioProfile.h"
+
+#ifdef ARDUINO
+#include <LoRa.h>
+#endif
+
+// Every profile must get a single reading (FRAME_READING_SIZE) through
+// the region's dwell limit: 400 ms in US915. At SF10 that rules out CR4/8
+// (428 ms); CR4/5 takes 330 ms.
+const RadioProfile RADIO_PROFILES[] = {
+  //  SF  bandwidth  CR  dBm  sensitivity
+  {    7,   500000,   5,  10,  -118 },
+  {    7,   500000,   5,  17,  -118 },
+  {    7,   250000,   5,  17,  -121 },
+  {    8,   250000,   6,  17,  -123 },
+  {    9,   125000,   6,  20,  -129 },
+  {   10,   125000,   5,  20,  -132 },
+};
+const uint8_t RADIO_PROFILE_COUNT = sizeof(RADIO_PROFILES) / sizeof(RADIO_PROFILES[0]);
+
+#ifdef ARDUINO
+void radioApplyProfile(uint8_t index) {
+  const RadioProfile& p = radioProfile(index);
+  LoRa.setTxPower(p.txPowerDbm);
+  LoRa.setSignalBandwidth(p.bandwidthHz);
+  LoRa.setSpreadingFactor(p.spreadingFactor);
+  LoRa.setCodingRate4(p.codingRate);
+  LoRa.setSyncWord(RADIO_SYNC_WORD);
+  LoRa.enableCrc();
+}
+#endif
+
+AdrController::AdrController(uint8_t profile) {
+  setProfile(profile);
+}
+
+void AdrController::reset() {
+  setProfile(RADIO_PROFILE_SAFE);
+}
+
+void AdrController::setProfile(uint8_t profile) {
+  _profile = profile < RADIO_PROFILE_COUNT ? profile : RADIO_PROFILE_SAFE;
+  _count = 0;
+  _next = 0;
+}
+
+void AdrController::addMeasurement(int rssi, float snr) {
+  // Below the noise floor the packet RSSI overstates the signal
+  int signal = rssi + (snr < 0 ? (int)snr : 0);
+  int margin = signal - radioProfile(_profile).sensitivityDbm;
+  if (margin > 127) margin = 127;
+  if (margin < -128) margin = -128;
+
+  _margins[_next] = (int8_t)margin;
+  _next = (_next + 1) % HISTORY;
+  if (_count < HISTORY) _count++;
+}
+
+int8_t AdrController::margin() const {
+  if (_count == 0) return 0;
+  int8_t worst = _margins[0];
+  for (uint8_t i = 1; i < _count; i++) {
+    if (_margins[i] < worst) worst = _margins[i];
+  }
+  return worst;
+}
+
+uint8_t AdrController::recommend() const {
+  if (_count < 2) return _profile;
+
+  const RadioProfile& current = radioProfile(_profile);
+  int worst = margin();
+
+  // Fastest rung whose predicted margin still clears MARGIN_DB
+  uint8_t target = RADIO_PROFILE_SAFE;
+  for (uint8_t i = 0; i < RADIO_PROFILE_COUNT; i++) {
+    const RadioProfile& p = RADIO_PROFILES[i];
+    int predicted = worst + (p.txPowerDbm - current.txPowerDbm)
+                  + (current.sensitivityDbm - p.sensitivityDbm);
+    if (predicted >= MARGIN_DB) {
+      target = i;
+      break;
+    }
+  }
+
+  // Back off at once, but only speed up one rung on a full history
+  if (target > _profile) return target;
+  if (target < _profile && _count == HISTORY) return _profile - 1;
+  return _profile;
+}
@@ -0,0 +1,73 @@
+#ifndef RADIO_PROFILE_H
+#define RADIO_PROFILE_H
+
+#include <stdint.h>
+
+// Radio settings shared by the sensor node and the gateway. Both sides
+// start on RADIO_PROFILE_SAFE and only move when the gateway says so, so
+// they can never drift apart the way two hand-edited setup() blocks can.
+
+#define RADIO_FREQUENCY 915E6
+#define RADIO_SYNC_WORD 0xA5
+
+// Airtime rules for RADIO_FREQUENCY (see DutyCycle.h), and each
+// transmitter's own cap on its share of the channel, which is what bounds
+// how many nodes one gateway can serve
+#define RADIO_DUTY_REGION DUTY_REGION_US915
+#define RADIO_AIRTIME_POLICY 0.10
+
+struct RadioProfile {
+  uint8_t spreadingFactor;
+  uint32_t bandwidthHz;
+  uint8_t codingRate;        // denominator, 5..8 for 4/5..4/8
+  int8_t txPowerDbm;
+  int16_t sensitivityDbm;    // -174 + 10log10(BW) + NF + required SNR
+};
+
+// Ordered from fastest / lowest power to most robust. ADR moves one rung
+// at a time towards faster settings and jumps straight to a slower one.
+extern const RadioProfile RADIO_PROFILES[];
+extern const uint8_t RADIO_PROFILE_COUNT;
+#define RADIO_PROFILE_SAFE (RADIO_PROFILE_COUNT - 1)
+
+inline const RadioProfile& radioProfile(uint8_t index) {
+  return RADIO_PROFILES[index < RADIO_PROFILE_COUNT ? index : RADIO_PROFILE_SAFE];
+}
+
+#ifdef ARDUINO
+// Program the SX127x through the LoRa library.
+void radioApplyProfile(uint8_t index);
+#endif
+
+// ADR decision logic, run on the gateway for each node.
+class AdrController {
+public:
+  static const uint8_t HISTORY = 8;         // uplinks considered per decision
+  static const int8_t MARGIN_DB = 10;       // headroom kept above sensitivity
+
+  explicit AdrController(uint8_t profile = RADIO_PROFILE_SAFE);
+
+  // Record the link quality of an uplink received on the current profile.
+  void addMeasurement(int rssi, float snr);
+
+  // Profile the node should move to next. Equals profile() when no change
+  // is advised.
+  uint8_t recommend() const;
+
+  // Commit a profile change; the measurement history is restarted.
+  void setProfile(uint8_t profile);
+  void reset();
+
+  uint8_t profile() const { return _profile; }
+  uint8_t samples() const { return _count; }
+  // Worst margin over the history in dB, relative to the current profile.
+  int8_t margin() const;
+
+private:
+  uint8_t _profile;
+  int8_t _margins[HISTORY];
+  uint8_t _count;
+  uint8_t _next;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "ReliableLink.h"
+#include <string.h>
+
+ReliableSender::ReliableSender() : _rng(0x2545F491) {
+  memset(&_stats, 0, sizeof(_stats));
+  for (uint8_t i = 0; i < QUEUE_SIZE; i++) {
+    _entries[i].used = false;
+  }
+}
+
+void ReliableSender::saveState(SavedState& out) const {
+  memcpy(out.entries, _entries, sizeof(_entries));
+  out.stats = _stats;
+  out.rng = _rng;
+}
+
+void ReliableSender::restoreState(const SavedState& in) {
+  memcpy(_entries, in.entries, sizeof(_entries));
+  _stats = in.stats;
+  _rng = in.rng;
+}
+
+bool ReliableSender::enqueue(const uint8_t* frame, size_t length, uint16_t seq, uint32_t now) {
+  if (length > FRAME_MAX_SIZE) return false;
+
+  for (uint8_t i = 0; i < QUEUE_SIZE; i++) {
+    Entry& e = _entries[i];
+    if (e.used) continue;
+    memcpy(e.frame, frame, length);
+    e.length = length;
+    e.seq = seq;
+    e.attempts = 0;
+    e.nextAttemptMs = now;
+    e.used = true;
+    return true;
+  }
+  _stats.rejected++;
+  return false;
+}
+
+ReliableSender::Entry* ReliableSender::due(uint32_t now) {
+  Entry* oldest = nullptr;
+  for (uint8_t i = 0; i < QUEUE_SIZE; i++) {
+    Entry& e = _entries[i];
+    if (!e.used || (int32_t)(now - e.nextAttemptMs) < 0) continue;
+    if (e.attempts >= MAX_ATTEMPTS) {
+      // Last backoff expired without an ACK
+      e.used = false;
+      _stats.lost++;
+      continue;
+    }
+    if (!oldest || (int16_t)(e.seq - oldest->seq) < 0) oldest = &e;
+  }
+  return oldest;
+}
+
+void ReliableSender::transmitted(Entry* entry, uint32_t now) {
+  if (entry->attempts == 0) {
+    _stats.sent++;
+  } else {
+    _stats.retries++;
+  }
+  entry->attempts++;
+
+  // After the last attempt the entry waits one more backoff for a late ACK
+  entry->nextAttemptMs = now + backoff(entry->attempts);
+}
+
+uint32_t ReliableSender::backoff(uint8_t attempts) {
+  uint32_t delay = BACKOFF_BASE_MS << (attempts - 1);
+  if (delay > BACKOFF_MAX_MS) delay = BACKOFF_MAX_MS;
+
+  // Up to 25% jitter so nodes that collided do not collide again
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return delay + _rng % (delay / 4 + 1);
+}
+
+bool ReliableSender::acknowledge(uint16_t seq) {
+  for (uint8_t i = 0; i < QUEUE_SIZE; i++) {
+    Entry& e = _entries[i];
+    if (e.used && e.seq == seq) {
+      e.used = false;
+      _stats.acked++;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t ReliableSender::pending() const {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < QUEUE_SIZE; i++) {
+    if (_entries[i].used) n++;
+  }
+  return n;
+}
+
+DuplicateFilter::DuplicateFilter() {
+  memset(&_stats, 0, sizeof(_stats));
+  reset();
+}
+
+void DuplicateFilter::reset() {
+  _highest = 0;
+  _seen = 0;
+  _epoch = 0;
+  _started = false;
+}
+
+bool DuplicateFilter::accept(uint16_t seq, uint8_t epoch) {
+  if (_started && epoch != _epoch) {
+    // The node restarted; its count begins again wherever the old one was
+    _stats.resets++;
+    reset();
+  }
+
+  if (!_started) {
+    _started = true;
+    _epoch = epoch;
+    _highest = seq;
+    _seen = 1;
+    _stats.received++;
+    return true;
+  }
+
+  int16_t ahead = (int16_t)(seq - _highest);
+
+  if (ahead > 0) {
+    _stats.missing += ahead - 1;
+    _seen = ahead >= 32 ? 0 : _seen << ahead;
+    _seen |= 1;
+    _highest = seq;
+    _stats.received++;
+    return true;
+  }
+
+  uint16_t behind = (uint16_t)(-ahead);
+  if (behind >= WINDOW) {
+    // Far behind the window: a restart whose epoch wrapped around to ours
+    _stats.resets++;
+    reset();
+    return accept(seq, epoch);
+  }
+
+  uint32_t bit = (uint32_t)1 << behind;
+  if (_seen & bit) {
+    _stats.duplicates++;
+    return false;
+  }
+
+  _seen |= bit;
+  _stats.late++;
+  if (_stats.missing > 0) _stats.missing--;
+  _stats.received++;
+  return true;
+}
+
+float DuplicateFilter::deliveryRatio() const {
+  uint32_t expected = _stats.received + _stats.missing;
+  return expected ? (float)_stats.received / expected : 1.0f;
+}
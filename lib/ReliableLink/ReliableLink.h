@@ -0,0 +1,113 @@
+#ifndef RELIABLE_LINK_H
+#define RELIABLE_LINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <SubmersibleFrame.h>
+
+// Optional acknowledged delivery on top of SubmersibleFrame.
+//
+// The node keeps every frame it sent with FRAME_FLAG_ACK_REQUEST in a small
+// queue until the gateway's FRAME_ACK for that seq arrives, retransmitting
+// with exponential backoff. The gateway runs a DuplicateFilter per node so
+// retransmissions of frames it already has are acknowledged again but not
+// processed twice. The header's boot epoch tells the filter when the node
+// has restarted and its sequence numbers begin again at 0.
+
+struct ReliableSenderStats {
+  uint32_t sent;        // first transmissions
+  uint32_t retries;     // retransmissions
+  uint32_t acked;
+  uint32_t lost;        // gave up after MAX_ATTEMPTS
+  uint32_t rejected;    // queue full, frame not accepted
+};
+
+class ReliableSender {
+public:
+  static const uint8_t QUEUE_SIZE = 4;
+  static const uint8_t MAX_ATTEMPTS = 5;
+  static const uint32_t BACKOFF_BASE_MS = 2000;
+  static const uint32_t BACKOFF_MAX_MS = 32000;
+
+  struct Entry {
+    uint8_t frame[FRAME_MAX_SIZE];
+    uint8_t length;
+    uint16_t seq;
+    uint8_t attempts;
+    uint32_t nextAttemptMs;
+    bool used;
+  };
+
+  // The queue as plain data, for the node's RTC memory
+  struct SavedState {
+    Entry entries[QUEUE_SIZE];
+    ReliableSenderStats stats;
+    uint32_t rng;
+  };
+
+  ReliableSender();
+
+  // Take ownership of an encoded frame. It is due immediately.
+  bool enqueue(const uint8_t* frame, size_t length, uint16_t seq, uint32_t now);
+
+  // The queued frame that should be (re)transmitted now, or nullptr.
+  Entry* due(uint32_t now);
+
+  // Record a transmission attempt of an entry returned by due(). Schedules
+  // the next retry, or drops the frame once MAX_ATTEMPTS is reached.
+  void transmitted(Entry* entry, uint32_t now);
+
+  // Returns true if seq was waiting for an ACK.
+  bool acknowledge(uint16_t seq);
+
+  // Drop an entry without an ACK, for a caller that re-sends its readings
+  // another way.
+  void release(Entry* entry) { entry->used = false; }
+
+  uint8_t pending() const;
+  bool full() const { return pending() == QUEUE_SIZE; }
+  const ReliableSenderStats& stats() const { return _stats; }
+
+  void saveState(SavedState& out) const;
+  void restoreState(const SavedState& in);
+
+private:
+  uint32_t backoff(uint8_t attempts);
+
+  Entry _entries[QUEUE_SIZE];
+  ReliableSenderStats _stats;
+  uint32_t _rng;
+};
+
+struct DuplicateFilterStats {
+  uint32_t received;    // unique frames accepted
+  uint32_t duplicates;
+  uint32_t missing;     // sequence numbers skipped and not (yet) filled
+  uint32_t late;        // skipped sequence numbers that arrived later
+  uint32_t resets;      // node restarted its sequence
+};
+
+class DuplicateFilter {
+public:
+  static const uint8_t WINDOW = 32;
+
+  DuplicateFilter();
+
+  // Returns false if seq was already seen within the window. A new epoch
+  // starts the window over at seq.
+  bool accept(uint16_t seq, uint8_t epoch);
+  void reset();
+
+  const DuplicateFilterStats& stats() const { return _stats; }
+  // Fraction of sent frames that arrived, as far as the gateway can tell.
+  float deliveryRatio() const;
+
+private:
+  uint16_t _highest;
+  uint32_t _seen;      // bit i set: _highest - i was received
+  uint8_t _epoch;
+  bool _started;
+  DuplicateFilterStats _stats;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Fixed-size FIFO for exactly one producer and one consumer, without
+// locks. Slots are filled and emptied in place: the producer claim()s the
+// next free slot, fills it and publish()es it; the consumer reads front()
+// and release()s it. N must be a power of two.
+//
+// Head and tail only grow and are compared as unsigned, so they may wrap.
+template <typename T, uint32_t N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+  SpscRing() : _head(0), _tail(0) {}
+
+  // Producer: the slot to fill next, or nullptr while the ring is full.
+  T* claim() {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == N) return nullptr;
+    return &_slots[head & (N - 1)];
+  }
+
+  // Producer: hand the claimed slot to the consumer.
+  void publish() {
+    _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Consumer: the oldest published slot, or nullptr while empty.
+  const T* front() const {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (_head.load(std::memory_order_acquire) == tail) return nullptr;
+    return &_slots[tail & (N - 1)];
+  }
+
+  // Consumer: give the front slot back to the producer.
+  void release() {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Slots in use; from a third task it may already be out of date.
+  uint32_t size() const {
+    uint32_t tail = _tail.load(std::memory_order_acquire);
+    return _head.load(std::memory_order_acquire) - tail;
+  }
+  static uint32_t capacity() { return N; }
+
+private:
+  T _slots[N];
+  std::atomic<uint32_t> _head;
+  std::atomic<uint32_t> _tail;
+};
+
+#endif
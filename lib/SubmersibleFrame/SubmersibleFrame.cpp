@@ -0,0 +1,275 @@
+#include "SubmersibleFrame.h"
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+// LEB128 unsigned varint. Returns bytes written, 0 if it does not fit.
+static size_t putVarint(uint8_t* p, size_t cap, uint32_t v) {
+  size_t n = 0;
+  do {
+    if (n >= cap) return 0;
+    uint8_t byte = v & 0x7F;
+    v >>= 7;
+    p[n++] = v ? (byte | 0x80) : byte;
+  } while (v);
+  return n;
+}
+
+// Returns bytes consumed, 0 on truncated or overlong input.
+static size_t getVarint(const uint8_t* p, size_t len, uint32_t& v) {
+  v = 0;
+  for (size_t n = 0; n < len && n < 5; n++) {
+    v |= (uint32_t)(p[n] & 0x7F) << (7 * n);
+    if (!(p[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+static uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void putReading(uint8_t* p, const FrameReading& reading) {
+  putU16(p, reading.currentCentiMa);
+  putU16(p + 2, reading.depthMm);
+  putU16(p + 4, (uint16_t)reading.tempCentiC);
+  putU16(p + 6, reading.turbMilliV);
+  putU16(p + 8, reading.turbDeciNtu);
+  p[10] = reading.flags;
+}
+
+static void getReading(const uint8_t* p, FrameReading& reading) {
+  reading.currentCentiMa = getU16(p);
+  reading.depthMm = getU16(p + 2);
+  reading.tempCentiC = (int16_t)getU16(p + 4);
+  reading.turbMilliV = getU16(p + 6);
+  reading.turbDeciNtu = getU16(p + 8);
+  reading.flags = p[10];
+}
+
+static void readingFields(const FrameReading& r, int32_t* fields) {
+  fields[0] = r.currentCentiMa;
+  fields[1] = r.depthMm;
+  fields[2] = r.tempCentiC;
+  fields[3] = r.turbMilliV;
+  fields[4] = r.turbDeciNtu;
+}
+
+static void putHeader(uint8_t* p, const FrameHeader& header) {
+  p[0] = FRAME_VERSION;
+  p[1] = (header.type & FRAME_TYPE_MASK)
+       | ((header.epoch & FRAME_EPOCH_MASK) << FRAME_EPOCH_SHIFT)
+       | (header.flags & FRAME_FLAG_ACK_REQUEST);
+  p[2] = header.nodeId;
+  putU16(p + 3, header.seq);
+}
+
+size_t frameEncodeReading(const FrameHeader& header, const FrameReading& reading,
+                          uint8_t* buf, size_t cap) {
+  if (cap < FRAME_READING_SIZE) return 0;
+
+  FrameHeader h = header;
+  h.type = FRAME_READING;
+  putHeader(buf, h);
+
+  putReading(buf + FRAME_HEADER_SIZE, reading);
+  return FRAME_READING_SIZE;
+}
+
+size_t frameEncodeBatch(const FrameHeader& header, const FrameSample* samples,
+                        size_t count, uint8_t* buf, size_t cap, size_t& encoded) {
+  encoded = 0;
+  if (count == 0 || cap < FRAME_READING_SIZE + 2) return 0;
+
+  FrameHeader h = header;
+  h.type = FRAME_BATCH;
+  putHeader(buf, h);
+
+  size_t pos = FRAME_HEADER_SIZE + 1;
+  putReading(buf + pos, samples[0].reading);
+  pos += 11;
+  size_t n = putVarint(buf + pos, cap - pos, samples[0].ageDs);
+  if (n == 0) return 0;
+  pos += n;
+  encoded = 1;
+
+  int32_t base[5];
+  readingFields(samples[0].reading, base);
+
+  while (encoded < count && encoded < FRAME_BATCH_MAX) {
+    const FrameSample& s = samples[encoded];
+    const FrameSample& prev = samples[encoded - 1];
+    uint8_t tmp[32];
+    size_t len = 0;
+
+    uint32_t step = prev.ageDs > s.ageDs ? prev.ageDs - s.ageDs : 0;
+    len += putVarint(tmp + len, sizeof(tmp) - len, step);
+
+    int32_t fields[5];
+    readingFields(s.reading, fields);
+    for (uint8_t i = 0; i < 5; i++) {
+      len += putVarint(tmp + len, sizeof(tmp) - len, zigzag(fields[i] - base[i]));
+    }
+    len += putVarint(tmp + len, sizeof(tmp) - len, s.reading.flags ^ samples[0].reading.flags);
+
+    if (pos + len > cap) break;
+    for (size_t i = 0; i < len; i++) buf[pos + i] = tmp[i];
+    pos += len;
+    encoded++;
+  }
+
+  buf[FRAME_HEADER_SIZE] = (uint8_t)encoded;
+  return pos;
+}
+
+FrameStatus frameDecodeBatch(const uint8_t* buf, size_t len, FrameHeader& header,
+                             FrameSample* out, size_t maxSamples, size_t& count) {
+  count = 0;
+  FrameStatus status = frameDecodeHeader(buf, len, header);
+  if (status != FRAME_OK) return status;
+  if (header.type != FRAME_BATCH) return FRAME_BAD_TYPE;
+  if (len < FRAME_READING_SIZE + 2) return FRAME_TOO_SHORT;
+  if (maxSamples == 0) return FRAME_NO_SPACE;
+
+  uint8_t total = buf[FRAME_HEADER_SIZE];
+  size_t pos = FRAME_HEADER_SIZE + 1;
+  FrameSample first;
+  getReading(buf + pos, first.reading);
+  pos += 11;
+  size_t n = getVarint(buf + pos, len - pos, first.ageDs);
+  if (n == 0) return FRAME_TOO_SHORT;
+  pos += n;
+  out[count++] = first;
+
+  int32_t base[5];
+  readingFields(first.reading, base);
+
+  while (count < total) {
+    if (count >= maxSamples) return FRAME_NO_SPACE;
+
+    uint32_t values[7];
+    for (uint8_t i = 0; i < 7; i++) {
+      n = getVarint(buf + pos, len - pos, values[i]);
+      if (n == 0) return FRAME_TOO_SHORT;
+      pos += n;
+    }
+
+    FrameSample& s = out[count];
+    const FrameSample& prev = out[count - 1];
+    s.ageDs = prev.ageDs > values[0] ? prev.ageDs - values[0] : 0;
+    s.reading.currentCentiMa = (uint16_t)(base[0] + unzigzag(values[1]));
+    s.reading.depthMm = (uint16_t)(base[1] + unzigzag(values[2]));
+    s.reading.tempCentiC = (int16_t)(base[2] + unzigzag(values[3]));
+    s.reading.turbMilliV = (uint16_t)(base[3] + unzigzag(values[4]));
+    s.reading.turbDeciNtu = (uint16_t)(base[4] + unzigzag(values[5]));
+    s.reading.flags = first.reading.flags ^ (uint8_t)values[6];
+    count++;
+  }
+  return FRAME_OK;
+}
+
+FrameStatus frameDecodeHeader(const uint8_t* buf, size_t len, FrameHeader& header) {
+  if (len < FRAME_HEADER_SIZE) return FRAME_TOO_SHORT;
+  if (buf[0] != FRAME_VERSION) return FRAME_BAD_VERSION;
+
+  header.type = buf[1] & FRAME_TYPE_MASK;
+  header.flags = buf[1] & FRAME_FLAG_ACK_REQUEST;
+  header.epoch = (buf[1] >> FRAME_EPOCH_SHIFT) & FRAME_EPOCH_MASK;
+  header.nodeId = buf[2];
+  header.seq = getU16(buf + 3);
+  return FRAME_OK;
+}
+
+FrameStatus frameDecodeReading(const uint8_t* buf, size_t len,
+                               FrameHeader& header, FrameReading& reading) {
+  FrameStatus status = frameDecodeHeader(buf, len, header);
+  if (status != FRAME_OK) return status;
+  if (header.type != FRAME_READING) return FRAME_BAD_TYPE;
+  if (len < FRAME_READING_SIZE) return FRAME_TOO_SHORT;
+
+  getReading(buf + FRAME_HEADER_SIZE, reading);
+  return FRAME_OK;
+}
+
+FrameStatus frameDecodeUplink(const uint8_t* buf, size_t len, FrameHeader& header,
+                              FrameSample* out, size_t maxSamples, size_t& count) {
+  count = 0;
+  FrameStatus status = frameDecodeHeader(buf, len, header);
+  if (status != FRAME_OK) return status;
+  if (header.type == FRAME_BATCH) return frameDecodeBatch(buf, len, header, out, maxSamples, count);
+  if (header.type != FRAME_READING) return FRAME_BAD_TYPE;
+  if (maxSamples == 0) return FRAME_NO_SPACE;
+
+  status = frameDecodeReading(buf, len, header, out[0].reading);
+  if (status != FRAME_OK) return status;
+  out[0].ageDs = 0;
+  count = 1;
+  return FRAME_OK;
+}
+
+size_t frameEncodeDownlink(const FrameHeader& header, uint8_t profile, uint8_t* buf, size_t cap) {
+  if (cap < FRAME_DOWNLINK_SIZE) return 0;
+  if (header.type != FRAME_ADR && header.type != FRAME_ACK) return 0;
+
+  putHeader(buf, header);
+  buf[FRAME_HEADER_SIZE] = profile;
+  return FRAME_DOWNLINK_SIZE;
+}
+
+FrameStatus frameDecodeDownlink(const uint8_t* buf, size_t len, FrameHeader& header, uint8_t& profile) {
+  FrameStatus status = frameDecodeHeader(buf, len, header);
+  if (status != FRAME_OK) return status;
+  if (header.type != FRAME_ADR && header.type != FRAME_ACK) return FRAME_BAD_TYPE;
+  if (len < FRAME_DOWNLINK_SIZE) return FRAME_TOO_SHORT;
+
+  profile = buf[FRAME_HEADER_SIZE];
+  return FRAME_OK;
+}
+
+const char* frameStatusString(FrameStatus status) {
+  switch (status) {
+    case FRAME_OK: return "ok";
+    case FRAME_TOO_SHORT: return "frame too short";
+    case FRAME_BAD_VERSION: return "unknown frame version";
+    case FRAME_BAD_TYPE: return "unexpected frame type";
+    case FRAME_NO_SPACE: return "buffer too small";
+  }
+  return "unknown";
+}
+
+uint16_t frameScaleUnsigned(float value, float scale) {
+  float scaled = value * scale + 0.5f;
+  if (!(scaled > 0)) return 0;
+  if (scaled >= 65535.0f) return 65535;
+  return (uint16_t)scaled;
+}
+
+int16_t frameScaleSigned(float value, float scale) {
+  float scaled = value * scale;
+  scaled += scaled < 0 ? -0.5f : 0.5f;
+  // INT16_MIN is reserved for "invalid"
+  if (scaled <= -32767.0f) return -32767;
+  if (scaled >= 32767.0f) return 32767;
+  if (scaled != scaled) return FRAME_TEMP_INVALID;
+  return (int16_t)scaled;
+}
+
+void frameReadingFromValues(FrameReading& reading, float currentMa, float depthCm,
+                            float tempC, bool tempValid, float turbVolts, float turbNtu) {
+  reading.currentCentiMa = frameScaleUnsigned(currentMa, 100.0f);
+  reading.depthMm = frameScaleUnsigned(depthCm, 10.0f);
+  reading.tempCentiC = tempValid ? frameScaleSigned(tempC, 100.0f) : FRAME_TEMP_INVALID;
+  reading.turbMilliV = frameScaleUnsigned(turbVolts, 1000.0f);
+  reading.turbDeciNtu = frameScaleUnsigned(turbNtu, 10.0f);
+  reading.flags = tempValid ? 0 : FRAME_FLAG_TEMP_ERROR;
+}
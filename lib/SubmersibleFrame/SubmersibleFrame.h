@@ -0,0 +1,163 @@
+#ifndef SUBMERSIBLE_FRAME_H
+#define SUBMERSIBLE_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary LoRa frame shared by the sensor node (TX) and the gateway (RX).
+//
+// All multi-byte fields are little-endian. Every frame starts with a
+// fixed header:
+//
+//   0  version   FRAME_VERSION
+//   1  type      FrameType in bits 0-4, boot epoch in bits 5-6,
+//                FRAME_FLAG_ACK_REQUEST in bit 7
+//   2  nodeId
+//   3  seq       uint16, per node, wraps
+//
+// seq starts again at 0 whenever the node restarts. The boot epoch is the
+// node's restart count (kept in flash) modulo 4, so consecutive boots
+// always differ and the gateway can tell a restarted count from
+// retransmissions it has already seen.
+//
+// FRAME_READING payload (11 bytes, total frame 16 bytes):
+//
+//   5  current   uint16, 0.01 mA
+//   7  depth     uint16, 0.1 cm
+//   9  temp      int16,  0.01 °C, FRAME_TEMP_INVALID when no probe
+//   11 turbV     uint16, 1 mV
+//   13 turbNtu   uint16, 0.1 NTU
+//   15 flags     FrameReadingFlags
+//
+// FRAME_BATCH carries several readings taken at different times:
+//
+//   5  count     number of samples
+//   6  sample 0  the 11-byte reading layout above, absolute
+//   17 age 0     varint, deciseconds between sample 0 and transmission
+//   then for each further sample:
+//      age step  varint, deciseconds since the previous sample
+//      deltas    five zigzag varints, field minus sample 0's field,
+//                in FRAME_READING field order
+//      flags     varint, flags XOR sample 0's flags
+//
+// Slow-moving fields shrink to one byte per delta, so a batch costs a
+// fraction of the same readings sent one frame each.
+//
+// FRAME_ADR and FRAME_ACK are the gateway's downlinks to one node (nodeId
+// is the target, seq and epoch echo the uplink it answers). FRAME_ACK is
+// sent for uplinks carrying FRAME_FLAG_ACK_REQUEST and confirms that seq
+// arrived:
+//
+//   5  profile   index into RADIO_PROFILES the node should use
+//
+// Encoding and decoding never allocate. The legacy JSON packet starts with
+// '{', which is never a valid version byte, so both can share the air.
+
+#define FRAME_VERSION 1
+#define FRAME_HEADER_SIZE 5
+#define FRAME_READING_SIZE (FRAME_HEADER_SIZE + 11)
+#define FRAME_DOWNLINK_SIZE (FRAME_HEADER_SIZE + 1)
+#define FRAME_MAX_SIZE 128
+#define FRAME_BATCH_MAX 32
+#define FRAME_TEMP_INVALID INT16_MIN
+
+enum FrameType : uint8_t {
+  FRAME_READING = 1,
+  FRAME_BATCH = 2,
+  FRAME_ADR = 3,
+  FRAME_ACK = 4
+};
+
+#define FRAME_TYPE_MASK 0x1F
+#define FRAME_EPOCH_SHIFT 5
+#define FRAME_EPOCH_MASK 0x03
+#define FRAME_FLAG_ACK_REQUEST 0x80
+
+enum FrameReadingFlags : uint8_t {
+  FRAME_FLAG_TEMP_ERROR = 0x01,
+  FRAME_FLAG_DEPTH_GATED = 0x02,   // depth held by the node's rate gate
+  FRAME_FLAG_TURB_GATED = 0x04     // turbidity held by the node's rate gate
+};
+
+enum FrameStatus {
+  FRAME_OK = 0,
+  FRAME_TOO_SHORT,
+  FRAME_BAD_VERSION,
+  FRAME_BAD_TYPE,
+  FRAME_NO_SPACE
+};
+
+struct FrameHeader {
+  uint8_t type;
+  uint8_t flags;     // FRAME_FLAG_ACK_REQUEST
+  uint8_t nodeId;
+  uint16_t seq;
+  uint8_t epoch;     // sender's boot epoch, 0..FRAME_EPOCH_MASK
+};
+
+// Scaled integer fields as they travel on the air.
+struct FrameReading {
+  uint16_t currentCentiMa;
+  uint16_t depthMm;
+  int16_t tempCentiC;
+  uint16_t turbMilliV;
+  uint16_t turbDeciNtu;
+  uint8_t flags;
+};
+
+// A reading plus how long before transmission it was taken.
+struct FrameSample {
+  FrameReading reading;
+  uint32_t ageDs;
+};
+
+// Returns the encoded length, or 0 if cap is too small.
+size_t frameEncodeReading(const FrameHeader& header, const FrameReading& reading,
+                          uint8_t* buf, size_t cap);
+
+FrameStatus frameDecodeHeader(const uint8_t* buf, size_t len, FrameHeader& header);
+FrameStatus frameDecodeReading(const uint8_t* buf, size_t len,
+                               FrameHeader& header, FrameReading& reading);
+
+// Encodes as many samples as fit in cap, oldest first (samples must be in
+// capture order, so ages are non-increasing). Returns the encoded length
+// and stores the number of samples written in encoded; 0 if none fit.
+size_t frameEncodeBatch(const FrameHeader& header, const FrameSample* samples,
+                        size_t count, uint8_t* buf, size_t cap, size_t& encoded);
+
+// Decodes up to maxSamples samples into out; count receives the number decoded.
+FrameStatus frameDecodeBatch(const uint8_t* buf, size_t len, FrameHeader& header,
+                             FrameSample* out, size_t maxSamples, size_t& count);
+
+// Either uplink type as samples, a FRAME_READING being one sample of age 0.
+// After an error count still holds the samples decoded before it.
+FrameStatus frameDecodeUplink(const uint8_t* buf, size_t len, FrameHeader& header,
+                              FrameSample* out, size_t maxSamples, size_t& count);
+
+// header.type selects FRAME_ADR or FRAME_ACK.
+size_t frameEncodeDownlink(const FrameHeader& header, uint8_t profile, uint8_t* buf, size_t cap);
+FrameStatus frameDecodeDownlink(const uint8_t* buf, size_t len, FrameHeader& header, uint8_t& profile);
+
+const char* frameStatusString(FrameStatus status);
+
+inline bool frameIsLegacyJson(const uint8_t* buf, size_t len) {
+  return len > 0 && buf[0] == '{';
+}
+
+// Float <-> scaled integer helpers, clamped to the field range.
+uint16_t frameScaleUnsigned(float value, float scale);
+int16_t frameScaleSigned(float value, float scale);
+
+void frameReadingFromValues(FrameReading& reading, float currentMa, float depthCm,
+                            float tempC, bool tempValid, float turbVolts, float turbNtu);
+
+inline float frameCurrentMa(const FrameReading& r) { return r.currentCentiMa / 100.0f; }
+inline float frameDepthCm(const FrameReading& r) { return r.depthMm / 10.0f; }
+inline float frameTempC(const FrameReading& r) { return r.tempCentiC / 100.0f; }
+inline float frameTurbVolts(const FrameReading& r) { return r.turbMilliV / 1000.0f; }
+inline float frameTurbNtu(const FrameReading& r) { return r.turbDeciNtu / 10.0f; }
+inline bool frameTempValid(const FrameReading& r) {
+  return r.tempCentiC != FRAME_TEMP_INVALID && !(r.flags & FRAME_FLAG_TEMP_ERROR);
+}
+
+#endif